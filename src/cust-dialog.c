@@ -1852,6 +1852,8 @@ static void cb_file_value_change( VFSFileMonitor* fm,
         // use low priority since cb_file_value_change is called from another thread
         // otherwise segfault in vfs-file-monitor.c:351
         break;
+    case VFS_FILE_MONITOR_OVERFLOW:
+        // events were lost - read the file again like on a change
     case VFS_FILE_MONITOR_CHANGE:
     case VFS_FILE_MONITOR_CREATE:
     default:
@@ -71,8 +71,18 @@ struct _DesktopItem
 
     gboolean is_selected : 1;
     gboolean is_prelight : 1;
+
+    /* the item as last painted, redrawn when its state or the serial of
+     * the window changed - see paint_item() */
+    cairo_surface_t* tile;
+    guint tile_serial;
+    guint tile_state : 2;
 };
 
+/* states of a rendered item */
+#define TILE_SELECTED   1
+#define TILE_FOCUSED    2   /* window has focus - colors a selected icon */
+
 static void desktop_window_class_init           (DesktopWindowClass *klass);
 static void desktop_window_init             (DesktopWindow *self);
 static void desktop_window_finalize         (GObject *object);
@@ -126,9 +136,11 @@ static void forward_event_to_rootwin( GdkScreen *gscreen, GdkEvent *event );
 
 static void calc_item_size( DesktopWindow* self, DesktopItem* item );
 static void layout_items( DesktopWindow* self );
+static void index_items( DesktopWindow* self );
 static void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_area );
 static void move_item( DesktopWindow* self, DesktopItem* item, int x, int y, gboolean is_offset );
 static void paint_rubber_banding_rect( DesktopWindow* self );
+static void drop_rubber_banding_pix( DesktopWindow* self );
 
 /* FIXME: this is too dirty and here is some redundant code.
  *  We really need better and cleaner APIs for this */
@@ -143,6 +155,7 @@ static int comp_item_by_type( DesktopItem* item1, DesktopItem* item2, DesktopWin
 
 static void redraw_item( DesktopWindow* win, DesktopItem* item );
 static void desktop_item_free( DesktopItem* item );
+static void drop_item_tile( DesktopItem* item );
 
 GList* desktop_window_get_selected_items( DesktopWindow* win,
                                           gboolean current_first );
@@ -340,10 +353,8 @@ static void desktop_window_init(DesktopWindow *self)
     self->insert_item = NULL;
     self->renamed_item = self->renaming_item = NULL;
     self->file_listed = FALSE;
+    self->item_grid = ptk_item_grid_new();
 
-    self->icon_render = gtk_cell_renderer_pixbuf_new();
-    g_object_set( self->icon_render, "follow-state", TRUE, NULL);
-    g_object_ref_sink(self->icon_render);
     pc = gtk_widget_get_pango_context( (GtkWidget*)self );
     self->pl = gtk_widget_create_pango_layout( (GtkWidget*)self, NULL );
     pango_layout_set_alignment( self->pl, PANGO_ALIGN_CENTER );
@@ -437,9 +448,19 @@ void desktop_item_free( DesktopItem* item )
 {
     if ( item->fi )
         vfs_file_info_unref( item->fi );
+    drop_item_tile( item );
     g_slice_free( DesktopItem, item );
 }
 
+void drop_item_tile( DesktopItem* item )
+{
+    if ( item->tile )
+    {
+        cairo_surface_destroy( item->tile );
+        item->tile = NULL;
+    }
+}
+
 void desktop_window_finalize(GObject *object)
 {
     DesktopWindow *self = (DesktopWindow*)object;
@@ -466,6 +487,8 @@ void desktop_window_finalize(GObject *object)
     if( self->hand_cursor )
         gdk_cursor_unref( self->hand_cursor );
 
+    drop_rubber_banding_pix( self );
+
     if ( link_icon )
         g_object_unref( link_icon );
 
@@ -475,6 +498,7 @@ void desktop_window_finalize(GObject *object)
 
     g_list_foreach( self->items, (GFunc)desktop_item_free, NULL );
     g_list_free( self->items );
+    ptk_item_grid_free( self->item_grid );
 
     if (G_OBJECT_CLASS(parent_class)->finalize)
         (* G_OBJECT_CLASS(parent_class)->finalize)(object);
@@ -490,10 +514,14 @@ gboolean on_expose( GtkWidget* w, GdkEventExpose* evt )
 {
     DesktopWindow* self = (DesktopWindow*)w;
     GList* l;
+    GList* items;
     GdkRectangle intersect;
 #if GTK_CHECK_VERSION (3, 0, 0)
-    GtkAllocation allocation;
-    gtk_widget_get_allocation (w, &allocation);
+    GdkRectangle area;
+    if ( !gdk_cairo_get_clip_rectangle( cr, &area ) )
+        gtk_widget_get_allocation( w, &area );
+#else
+    GdkRectangle area = evt->area;
 #endif
 
     if( G_UNLIKELY( ! gtk_widget_get_visible (w) || ! gtk_widget_get_mapped (w) ) )
@@ -529,17 +557,15 @@ gboolean on_expose( GtkWidget* w, GdkEventExpose* evt )
     if( self->rubber_bending )
         paint_rubber_banding_rect( self );
 
-    for( l = self->items; l; l = l->next )
+    // only repaint the items in the damaged area
+    items = ptk_item_grid_get_in_rect( self->item_grid, &area );
+    for( l = items; l; l = l->next )
     {
-        DesktopItem* item = (DesktopItem*)l->data;
-#if GTK_CHECK_VERSION (3, 0, 0)
-        if( gdk_rectangle_intersect( &allocation, &item->box, &intersect ) )
-            paint_item( self, item, &intersect );
-#else
-        if( gdk_rectangle_intersect( &evt->area, &item->box, &intersect ) )
+        DesktopItem* item = (DesktopItem*)((GList*)l->data)->data;
+        if( gdk_rectangle_intersect( &area, &item->box, &intersect ) )
             paint_item( self, item, &intersect );
-#endif
     }
+    g_list_free( items );
     return TRUE;
 }
 
@@ -595,6 +621,7 @@ void desktop_window_set_text_color( DesktopWindow* win, GdkColor* clr, GdkColor*
                                 &win->shadow, FALSE, TRUE );
 #endif
         }
+        win->tile_serial++;  // repaint all items
         if( gtk_widget_get_visible( (GtkWidget*)win ) )
             gtk_widget_queue_draw(  (GtkWidget*)win );
     }
@@ -766,6 +793,7 @@ void desktop_window_set_background( DesktopWindow* win, GdkPixbuf* src_pix, DWBg
         g_object_unref( win->background );
 #endif
     win->background = pixmap;
+    drop_rubber_banding_pix( win );
 
 
     if( pixmap )
@@ -851,6 +879,7 @@ void desktop_window_set_icon_size( DesktopWindow* win, int size )
     if ( win->sort_by == DW_SORT_CUSTOM )
         win->order_rows = win->row_count; // possible change of row count in new layout
     
+    win->tile_serial++;  // repaint all items - the size or font changed
     layout_items( win );
 
     for( l = win->items; l; l = l->next )
@@ -918,6 +947,7 @@ void desktop_window_reload_icons( DesktopWindow* win )
 
     if ( win->sort_by == DW_SORT_CUSTOM )
         win->order_rows = win->row_count; // possible change of row count in new layout
+    win->tile_serial++;  // repaint all items with the new icons
      layout_items( win );
 }
 
@@ -1067,19 +1097,29 @@ void paint_rubber_banding_rect( DesktopWindow* self )
     }
     else if( self->bg_type != DW_BG_COLOR )
     {
-        if( self->background )
+        if( !self->rubber_bending_pix && self->background )
+        {
+            /* colorize the whole background once rather than the rect on
+             * every expose - it only changes with the wallpaper */
 #if GTK_CHECK_VERSION (3, 0, 0)
-            pix = gdk_pixbuf_get_from_surface( self->surface,
-                                                rect.x, rect.y, rect.width, rect.height );
+            self->rubber_bending_pix = gdk_pixbuf_get_from_surface( self->surface, 0, 0,
+                                        cairo_xlib_surface_get_width( self->surface ),
+                                        cairo_xlib_surface_get_height( self->surface ) );
 #else
-            pix = gdk_pixbuf_get_from_drawable( NULL, self->background, gdk_drawable_get_colormap(self->background),
-                                                rect.x, rect.y, 0, 0, rect.width, rect.height );
+            gdk_drawable_get_size( self->background, &w, &h );
+            self->rubber_bending_pix = gdk_pixbuf_get_from_drawable( NULL, self->background,
+                                                gdk_drawable_get_colormap(self->background),
+                                                0, 0, 0, 0, w, h );
 #endif
+            if( self->rubber_bending_pix )
+                colorize_pixbuf( self->rubber_bending_pix, clr, alpha );
+        }
+        if( self->rubber_bending_pix )
+            pix = g_object_ref( self->rubber_bending_pix );
     }
 
     if( pix )
     {
-        colorize_pixbuf( pix, clr, alpha );
         if( self->bg_type == DW_BG_TILE ) /* this is currently unreachable */
         {
             /*GdkPixmap* pattern;*/
@@ -1099,7 +1139,7 @@ void paint_rubber_banding_rect( DesktopWindow* self )
         }
         else
         {
-            gdk_cairo_set_source_pixbuf( cr, pix, rect.x, rect.y );
+            gdk_cairo_set_source_pixbuf( cr, pix, 0, 0 );
             cairo_rectangle( cr, rect.x, rect.y, rect.width, rect.height );
             cairo_fill( cr );
         }
@@ -1126,10 +1166,38 @@ void paint_rubber_banding_rect( DesktopWindow* self )
     cairo_destroy( cr );
 }
 
+void drop_rubber_banding_pix( DesktopWindow* self )
+{
+    if( self->rubber_bending_pix )
+    {
+        g_object_unref( self->rubber_bending_pix );
+        self->rubber_bending_pix = NULL;
+    }
+}
+
+static void update_rubberbanded_item( DesktopWindow* self, DesktopItem* item,
+                                      GdkRectangle* rect, gboolean add )
+{
+    gboolean selected;
+    if( item->fi &&
+        ( gdk_rectangle_intersect( rect, &item->icon_rect, NULL ) ||
+          gdk_rectangle_intersect( rect, &item->text_rect, NULL ) ) )
+        selected = TRUE;
+    else
+        selected = FALSE;
+
+    if( ( item->is_selected != selected ) && ( !add || !item->is_selected ) )
+    {
+        item->is_selected = selected;
+        redraw_item( self, item );
+    }
+}
+
 static void update_rubberbanding( DesktopWindow* self, int newx, int newy, gboolean add )
 {
     GList* l;
-    GdkRectangle old_rect, new_rect;
+    GList* items;
+    GdkRectangle old_rect, new_rect, area;
 /*
 #if GTK_CHECK_VERSION (3, 0, 0)
     cairo_region_t *region;
@@ -1157,24 +1225,24 @@ static void update_rubberbanding( DesktopWindow* self, int newx, int newy, gbool
     self->rubber_bending_x = newx;
     self->rubber_bending_y = newy;
 
-    /* update selection */
-    for( l = self->items; l; l = l->next )
+    /* update selection - adding never deselects, and after a deselecting
+     * update only items in the old or new rect can change */
+    if ( add || !self->rubber_bending_all )
     {
-        DesktopItem* item = (DesktopItem*)l->data;
-        gboolean selected;
-        if( item->fi &&
-            ( gdk_rectangle_intersect( &new_rect, &item->icon_rect, NULL ) ||
-              gdk_rectangle_intersect( &new_rect, &item->text_rect, NULL ) ) )
-            selected = TRUE;
-        else
-            selected = FALSE;
-
-        if( ( item->is_selected != selected ) && ( !add || !item->is_selected ) )
-        {
-            item->is_selected = selected;
-            redraw_item( self, item );
-        }
+        gdk_rectangle_union( &old_rect, &new_rect, &area );
+        items = ptk_item_grid_get_in_rect( self->item_grid, &area );
+        for( l = items; l; l = l->next )
+            update_rubberbanded_item( self, (DesktopItem*)((GList*)l->data)->data,
+                                                            &new_rect, add );
+        g_list_free( items );
     }
+    else
+    {
+        for( l = self->items; l; l = l->next )
+            update_rubberbanded_item( self, (DesktopItem*)l->data, &new_rect,
+                                                                        add );
+    }
+    self->rubber_bending_all = add;
 }
 
 static void open_clicked_item( DesktopWindow* self, DesktopItem* clicked_item )
@@ -1344,6 +1412,7 @@ gboolean on_button_press( GtkWidget* w, GdkEventButton* evt )
                 gtk_grab_add( w );
                 self->rubber_bending_x = evt->x;
                 self->rubber_bending_y = evt->y;
+                self->rubber_bending_all = TRUE;
                 goto out;
             }
         }
@@ -1379,6 +1448,7 @@ gboolean on_button_release( GtkWidget* w, GdkEventButton* evt )
                                         !!(evt->state & GDK_CONTROL_MASK) );
         gtk_grab_remove( w );
         self->rubber_bending = FALSE;
+        drop_rubber_banding_pix( self );
     }
     else if( self->dragging )
     {
@@ -2006,6 +2076,7 @@ void on_drag_data_received( GtkWidget* w, GdkDragContext* ctx, gint x, gint y,
         }
         gtk_grab_remove(w);
         self->rubber_bending = FALSE;
+        drop_rubber_banding_pix( self );
         self->dragging = FALSE;
         gtk_drag_finish( ctx, TRUE, FALSE, time );
     }
@@ -2517,6 +2588,8 @@ void on_style_set( GtkWidget* w, GtkStyle* prev )
 
     font_h = pango_font_metrics_get_ascent(metrics) + pango_font_metrics_get_descent (metrics);
     font_h /= PANGO_SCALE;
+
+    self->tile_serial++;  // selection colors may have changed
 }
 
 void on_realize( GtkWidget* w )
@@ -2970,9 +3043,32 @@ start_layout:
         custom_order_write( self );
     }
     //printf("    box_count = %d\n", self->box_count );
+    index_items( self );
     gtk_widget_queue_draw( GTK_WIDGET(self) );
 }
 
+void index_items( DesktopWindow* self )
+{   // index the links of items by position for hit testing
+    GList* l;
+    DesktopItem* item;
+    GdkRectangle rect;
+
+    ptk_item_grid_clear( self->item_grid );
+    for ( l = self->items; l; l = l->next )
+    {
+        item = (DesktopItem*)l->data;
+        rect = item->box;
+        if ( item->fi )
+        {
+            gdk_rectangle_union( &rect, &item->icon_rect, &rect );
+            gdk_rectangle_union( &rect, &item->text_rect, &rect );
+        }
+        ptk_item_grid_add( self->item_grid, &rect, l );
+    }
+    // items moved - the next rubber band update checks them all
+    self->rubber_bending_all = TRUE;
+}
+
 void on_file_listed( VFSDir* dir, gboolean is_cancelled, DesktopWindow* self )
 {
     GList* l, *items = NULL;
@@ -3098,6 +3194,7 @@ void on_thumbnail_loaded( VFSDir* dir,  VFSFileInfo* fi, DesktopWindow* self )
                 g_object_unref( item->icon );
             item->icon = vfs_file_info_get_big_thumbnail( fi );
 */
+            drop_item_tile( item );
             redraw_item( self, item );
             return;
         }
@@ -3302,6 +3399,7 @@ void on_file_changed( VFSDir* dir, VFSFileInfo* file, gpointer user_data )
                                 && vfs_file_info_is_image( item->fi ) ) ) )
             vfs_thumbnail_loader_request( dir, item->fi, TRUE );
 
+        drop_item_tile( item );
         if( gtk_widget_get_visible( w ) )
         {
             /* redraw the item */
@@ -3352,7 +3450,7 @@ void desktop_window_copycmd( DesktopWindow* desktop, GList* sel_files,
             else
                 move_dest = path;
             set2 = xset_get( "copy_loc_last" );
-            xset_set_set( set2, "desc", path );
+            xset_set_set( set2, XSET_VAR_DESC, path );
         }
         else
             return;
@@ -3415,44 +3513,55 @@ void desktop_window_copycmd( DesktopWindow* desktop, GList* sel_files,
 
 /*-------------- Private methods -------------------*/
 
-void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_area )
-{
-    /* GdkPixbuf* icon = item->icon ? gdk_pixbuf_ref(item->icon) : NULL; */
+static void render_item_tile( DesktopWindow* self, DesktopItem* item, guint state )
+{   // draw the icon and label of item to its tile, with item->box at 0, 0
     GdkPixbuf* icon;
-    
-    if ( !item->fi )
-        return;   // empty
+    GdkPixbuf* colored;
     const char* text = item->fi->disp_name;
     GtkWidget* widget = (GtkWidget*)self;
-#if !GTK_CHECK_VERSION (3, 0, 0)
-    GdkDrawable* drawable = gtk_widget_get_window(widget);
-#endif
-    GtkCellRendererState state = 0;
     GdkRectangle text_rect;
     int w, h;
     cairo_t *cr;
 
-    cr = gdk_cairo_create( gtk_widget_get_window( widget ) );
+    drop_item_tile( item );
+    item->tile = cairo_image_surface_create( CAIRO_FORMAT_ARGB32,
+                                             item->box.width, item->box.height );
+    item->tile_serial = self->tile_serial;
+    item->tile_state = state;
+
+    cr = cairo_create( item->tile );
+    cairo_translate( cr, -item->box.x, -item->box.y );
+    pango_cairo_update_layout( cr, self->pl );
 
     if ( item->fi->big_thumbnail )
         icon = g_object_ref( item->fi->big_thumbnail );
     else
         icon = vfs_file_info_get_big_icon( item->fi );
 
-    if( item->is_selected )
-        state = GTK_CELL_RENDERER_SELECTED;
-
-    g_object_set( self->icon_render, "pixbuf", icon, NULL );
-#if GTK_CHECK_VERSION (3, 0, 0)
-    gtk_cell_renderer_render( self->icon_render, cr, widget,
-                                                       &item->icon_rect, &item->icon_rect, state );
-#else
-    gtk_cell_renderer_render( self->icon_render, drawable, widget,
-                                                       &item->icon_rect, &item->icon_rect, expose_area, state );
-#endif
-
     if( icon )
+    {
+        if( state & TILE_SELECTED )
+        {
+            // follow the state like a cell renderer would
+            colored = gdk_pixbuf_copy( icon );
+            colorize_pixbuf( colored, &gtk_widget_get_style(widget)->base[
+                            state & TILE_FOCUSED ? GTK_STATE_SELECTED :
+                                                   GTK_STATE_ACTIVE], 255 );
+            g_object_unref( icon );
+            icon = colored;
+        }
+
+        // centered in icon_rect
+        cairo_save( cr );
+        gdk_cairo_rectangle( cr, &item->icon_rect );
+        cairo_clip( cr );
+        gdk_cairo_set_source_pixbuf( cr, icon,
+            item->icon_rect.x + ( item->icon_rect.width - gdk_pixbuf_get_width( icon ) ) / 2,
+            item->icon_rect.y + ( item->icon_rect.height - gdk_pixbuf_get_height( icon ) ) / 2 );
+        cairo_paint( cr );
+        cairo_restore( cr );
         g_object_unref( icon );
+    }
 
     // add link_icon arrow to links
     if ( vfs_file_info_is_symlink( item->fi ) && link_icon )
@@ -3472,14 +3581,9 @@ void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_ar
 
     if( item->is_selected )
     {
-        GdkRectangle intersect={0};
-
-        if( gdk_rectangle_intersect( expose_area, &item->text_rect, &intersect ) )
-        {
-            gdk_cairo_set_source_color( cr, &gtk_widget_get_style(widget)->bg[GTK_STATE_SELECTED] );
-            cairo_rectangle( cr, intersect.x, intersect.y, intersect.width, intersect.height );
-            cairo_fill( cr );
-        }
+        gdk_cairo_set_source_color( cr, &gtk_widget_get_style(widget)->bg[GTK_STATE_SELECTED] );
+        gdk_cairo_rectangle( cr, &item->text_rect );
+        cairo_fill( cr );
     }
     else
     {
@@ -3493,7 +3597,6 @@ void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_ar
         {
             pango_layout_set_text( self->pl, text, item->len1 );
             pango_layout_get_pixel_size( self->pl, &w, &h );
-            pango_cairo_update_layout( cr, self->pl );
             cairo_move_to( cr, text_rect.x, text_rect.y );
             pango_cairo_show_layout( cr, self->pl );
             text_rect.y += h;
@@ -3507,23 +3610,6 @@ void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_ar
         --text_rect.y;
     }
 
-    if( self->focus == item && gtk_widget_has_focus(widget) )
-    {
-#if GTK_CHECK_VERSION (3, 0, 0)
-        gtk_paint_focus( gtk_widget_get_style(widget), cr,
-                        GTK_STATE_NORMAL,/*item->is_selected ? GTK_STATE_SELECTED : GTK_STATE_NORMAL,*/
-                        widget, "icon_view",
-                        item->text_rect.x, item->text_rect.y,
-                        item->text_rect.width, item->text_rect.height);
-#else
-        gtk_paint_focus( gtk_widget_get_style(widget), gtk_widget_get_window(widget),
-                        GTK_STATE_NORMAL,/*item->is_selected ? GTK_STATE_SELECTED : GTK_STATE_NORMAL,*/
-                        &item->text_rect, widget, "icon_view",
-                        item->text_rect.x, item->text_rect.y,
-                        item->text_rect.width, item->text_rect.height);
-#endif
-    }
-
     text_rect = item->text_rect;
 
     gdk_cairo_set_source_color( cr, &self->fg );
@@ -3532,7 +3618,6 @@ void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_ar
     {
         pango_layout_set_text( self->pl, text, item->len1 );
         pango_layout_get_pixel_size( self->pl, &w, &h );
-        pango_cairo_update_layout( cr, self->pl );
         cairo_move_to( cr, text_rect.x, text_rect.y );
         pango_cairo_show_layout( cr, self->pl );
         text_rect.y += h;
@@ -3545,6 +3630,54 @@ void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_ar
     cairo_destroy( cr );
 }
 
+void paint_item( DesktopWindow* self, DesktopItem* item, GdkRectangle* expose_area )
+{
+    GtkWidget* widget = (GtkWidget*)self;
+    guint state = 0;
+    cairo_t *cr;
+
+    if ( !item->fi )
+        return;   // empty
+
+    if( item->is_selected )
+        state = TILE_SELECTED |
+                        ( gtk_widget_has_focus(widget) ? TILE_FOCUSED : 0 );
+
+    /* Rendering the icon and the label is slow, so a tile of the item is
+     * kept and only drawn again when it looks different. */
+    if( !item->tile || item->tile_state != state ||
+                item->tile_serial != self->tile_serial ||
+                cairo_image_surface_get_width( item->tile ) != item->box.width ||
+                cairo_image_surface_get_height( item->tile ) != item->box.height )
+        render_item_tile( self, item, state );
+
+    cr = gdk_cairo_create( gtk_widget_get_window( widget ) );
+    gdk_cairo_rectangle( cr, expose_area );
+    cairo_clip( cr );
+    cairo_set_source_surface( cr, item->tile, item->box.x, item->box.y );
+    cairo_paint( cr );
+    cairo_destroy( cr );
+
+    if( self->focus == item && gtk_widget_has_focus(widget) )
+    {
+#if GTK_CHECK_VERSION (3, 0, 0)
+        cr = gdk_cairo_create( gtk_widget_get_window( widget ) );
+        gtk_paint_focus( gtk_widget_get_style(widget), cr,
+                        GTK_STATE_NORMAL,/*item->is_selected ? GTK_STATE_SELECTED : GTK_STATE_NORMAL,*/
+                        widget, "icon_view",
+                        item->text_rect.x, item->text_rect.y,
+                        item->text_rect.width, item->text_rect.height);
+        cairo_destroy( cr );
+#else
+        gtk_paint_focus( gtk_widget_get_style(widget), gtk_widget_get_window(widget),
+                        GTK_STATE_NORMAL,/*item->is_selected ? GTK_STATE_SELECTED : GTK_STATE_NORMAL,*/
+                        &item->text_rect, widget, "icon_view",
+                        item->text_rect.x, item->text_rect.y,
+                        item->text_rect.width, item->text_rect.height);
+#endif
+    }
+}
+
 void move_item( DesktopWindow* self, DesktopItem* item, int x, int y, gboolean is_offset )
 {
     GdkRectangle old = item->box;
@@ -3560,6 +3693,7 @@ void move_item( DesktopWindow* self, DesktopItem* item, int x, int y, gboolean i
     item->icon_rect.y += y;
     item->text_rect.x += x;
     item->text_rect.y += y;
+    index_items( self );
 
     gtk_widget_queue_draw_area( (GtkWidget*)self, old.x, old.y, old.width, old.height );
     gtk_widget_queue_draw_area( (GtkWidget*)self, item->box.x, item->box.y, item->box.width, item->box.height );
@@ -3570,58 +3704,54 @@ static gboolean is_point_in_rect( GdkRectangle* rect, int x, int y )
     return rect->x < x && x < (rect->x + rect->width) && y > rect->y && y < (rect->y + rect->height);
 }
 
+enum {
+    HIT_ICON = 1 << 0,
+    HIT_TEXT = 1 << 1,
+    HIT_BOX = 1 << 2
+};
+
+static gboolean is_item_hit( GList* l, int x, int y, gpointer parts )
+{
+    DesktopItem* item = (DesktopItem*) l->data;
+    int p = GPOINTER_TO_INT( parts );
+
+    if ( p & HIT_BOX )
+        return is_point_in_rect( &item->box, x, y );
+    if ( !item->fi )
+        return FALSE;  // empty box
+    return ( ( p & HIT_ICON ) && is_point_in_rect( &item->icon_rect, x, y ) ) ||
+           ( ( p & HIT_TEXT ) && is_point_in_rect( &item->text_rect, x, y ) );
+}
+
+static GList* find_item_link( DesktopWindow* self, int x, int y, int parts )
+{
+    return (GList*)ptk_item_grid_find( self->item_grid, x, y,
+                                       (PtkItemGridFunc)is_item_hit,
+                                       GINT_TO_POINTER( parts ) );
+}
+
 DesktopItem* hit_test( DesktopWindow* self, int x, int y )
 {   // hit on icon or text ?
-    DesktopItem* item;
-    GList* l;
-    for ( l = self->items; l; l = l->next )
-    {
-        item = (DesktopItem*) l->data;
-        if ( !item->fi )
-            continue;  // empty box
-        if ( is_point_in_rect( &item->icon_rect, x, y )
-                        || is_point_in_rect( &item->text_rect, x, y ) )
-            return item;
-    }
-    return NULL;
+    GList* l = find_item_link( self, x, y, HIT_ICON | HIT_TEXT );
+    return l ? (DesktopItem*) l->data : NULL;
 }
 
 DesktopItem* hit_test_icon( DesktopWindow* self, int x, int y )
 {   // hit on icon ?
-    DesktopItem* item;
-    GList* l;
-    for ( l = self->items; l; l = l->next )
-    {
-        item = (DesktopItem*) l->data;
-        if ( !item->fi )
-            continue;  // empty box
-        if ( is_point_in_rect( &item->icon_rect, x, y ) )
-            return item;
-    }
-    return NULL;
+    GList* l = find_item_link( self, x, y, HIT_ICON );
+    return l ? (DesktopItem*) l->data : NULL;
 }
 
 gboolean hit_test_text( DesktopWindow* self, int x, int y,
                                                     DesktopItem** next_item )
 {   // hit on text ?   sets next item
-    DesktopItem* item;
-    GList* l;
-    for ( l = self->items; l; l = l->next )
+    GList* l = find_item_link( self, x, y, HIT_TEXT );
+    if ( l )
     {
-        item = (DesktopItem*) l->data;
-        if ( !item->fi )
-            continue;  // empty box
-        if ( is_point_in_rect( &item->text_rect, x, y ) )
-        {
-            // hit text
-            if ( l->next )
-                item = (DesktopItem*)l->next->data;
-            else
-                item = NULL;
-            if ( next_item )
-                *next_item = item;
-            return TRUE;
-        }
+        // hit text
+        if ( next_item )
+            *next_item = l->next ? (DesktopItem*)l->next->data : NULL;
+        return TRUE;
     }
     if ( next_item )
         *next_item = NULL;
@@ -3633,19 +3763,16 @@ DesktopItem* hit_test_box( DesktopWindow* self, int x, int y )  //sfm
     DesktopItem* item;
     GList* l;
 
-    for ( l = self->items; l; l = l->next )
+    if ( ( l = find_item_link( self, x, y, HIT_BOX ) ) )
     {
         item = (DesktopItem*)l->data;
-        if ( is_point_in_rect( &item->box, x, y ) )
-        {
-            if ( item->fi && l->next &&
-                         ((DesktopItem*)l->next->data)->box.x == item->box.x &&
-                         y > item->text_rect.y )
-                // clicked in lower area of non-empty box,
-                // return next box if same column
-                return (DesktopItem*)l->next->data;
-            return item;
-        }
+        if ( item->fi && l->next &&
+                     ((DesktopItem*)l->next->data)->box.x == item->box.x &&
+                     y > item->text_rect.y )
+            // clicked in lower area of non-empty box,
+            // return next box if same column
+            return (DesktopItem*)l->next->data;
+        return item;
     }
     
     // unlikely - no box was directly hit, so use closest
@@ -3806,7 +3933,8 @@ int comp_item_by_name( DesktopItem* item1, DesktopItem* item2, DesktopWindow* wi
         return ret;
     //ret =g_utf8_collate( item1->fi->disp_name, item2->fi->disp_name );
     // natural icase
-    ret = strcmp( item1->fi->collate_icase_key, item2->fi->collate_icase_key );
+    ret = strcmp( vfs_file_info_get_collate_key( item1->fi, TRUE ),
+                  vfs_file_info_get_collate_key( item2->fi, TRUE ) );
     if( win && win->sort_type == GTK_SORT_DESCENDING )
         ret = -ret;
     return ret;
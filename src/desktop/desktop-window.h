@@ -19,6 +19,7 @@
 
 #include "vfs-dir.h"
 #include "vfs-file-task.h"
+#include "ptk-item-grid.h"
 
 G_BEGIN_DECLS
 
@@ -69,6 +70,9 @@ struct _DesktopWindow
     /* all items on the desktop window */
     GList* items;
 
+    /* links of items indexed by position for hit testing */
+    PtkItemGrid* item_grid;
+
     /* margins of the whole desktop window */
     int margin_top;
     int margin_left;
@@ -105,6 +109,7 @@ struct _DesktopWindow
     /* <private> */
 
     gboolean rubber_bending : 1;
+    gboolean rubber_bending_all : 1;    // next update checks all items
     gboolean dragging : 1;
     gboolean drag_entered : 1;
     gboolean pending_drop_action : 1;
@@ -121,6 +126,7 @@ struct _DesktopWindow
     gint drag_pending_y;
     guint rubber_bending_x;
     guint rubber_bending_y;
+    GdkPixbuf* rubber_bending_pix;  // colorized background while rubber banding
 
     /* the directory content */
     VFSDir* dir;
@@ -128,7 +134,8 @@ struct _DesktopWindow
     /* renderers for the items */
     PangoLayout* pl;
 
-    GtkCellRenderer* icon_render;
+    /* rendered items older than this are outdated */
+    guint tile_serial;
 
     /* background image */
 #if GTK_CHECK_VERSION (3, 0, 0)
@@ -51,6 +51,7 @@
 
 #include "gtk2-compat.h"
 #include "ptk-utils.h"
+#include "ptk-item-grid.h"
 
 
 GType
@@ -213,11 +214,13 @@ static void                 exo_icon_view_adjustment_changed             (GtkAdj
                                                                           ExoIconView            *icon_view);
 static gint                 exo_icon_view_layout_cols                    (ExoIconView            *icon_view,
                                                                           gint                    item_height,
+                                                                          gint                    focus_width,
                                                                           gint                   *x,
                                                                           gint                   *maximum_height,
                                                                           gint                    max_rows);
 static gint                 exo_icon_view_layout_rows                    (ExoIconView            *icon_view,
                                                                           gint                    item_width,
+                                                                          gint                    focus_width,
                                                                           gint                   *y,
                                                                           gint                   *maximum_width,
                                                                           gint                    max_cols);
@@ -236,6 +239,9 @@ static void                 exo_icon_view_paint_item                     (ExoIco
 static void                 exo_icon_view_queue_draw_item                (ExoIconView            *icon_view,
                                                                           ExoIconViewItem        *item);
 static void                 exo_icon_view_queue_layout                   (ExoIconView            *icon_view);
+static void                 exo_icon_view_queue_layout_items             (ExoIconView            *icon_view,
+                                                                          gint                    index,
+                                                                          gint                    shift);
 static void                 exo_icon_view_set_cursor_item                (ExoIconView            *icon_view,
                                                                           ExoIconViewItem        *item,
                                                                           gint                    cursor_cell);
@@ -243,7 +249,8 @@ static void                 exo_icon_view_start_rubberbanding            (ExoIco
                                                                           gint                    x,
                                                                           gint                    y);
 static void                 exo_icon_view_stop_rubberbanding             (ExoIconView            *icon_view);
-static void                 exo_icon_view_update_rubberband_selection    (ExoIconView            *icon_view);
+static void                 exo_icon_view_update_rubberband_selection    (ExoIconView            *icon_view,
+                                                                          const GdkRectangle     *old_area);
 static gboolean             exo_icon_view_item_hit_test                  (ExoIconView            *icon_view,
                                                                           ExoIconViewItem        *item,
                                                                           gint                    x,
@@ -284,6 +291,7 @@ static void                 exo_icon_view_unselect_item                  (ExoIco
 static gboolean             exo_icon_view_select_all_between             (ExoIconView            *icon_view,
                                                                           ExoIconViewItem        *anchor,
                                                                           ExoIconViewItem        *cursor);
+static PtkItemGrid *        exo_icon_view_get_item_grid                  (ExoIconViewPrivate     *priv);
 static ExoIconViewItem *    exo_icon_view_get_item_at_coords             (const ExoIconView      *icon_view,
                                                                           gint                    x,
                                                                           gint                    y,
@@ -469,8 +477,8 @@ struct _ExoIconViewItem
     gint *before;
     gint *after;
 
-    guint row : ((sizeof (guint) / 2) * 8) - 1;
-    guint col : ((sizeof (guint) / 2) * 8) - 1;
+    gint row;
+    gint col;
     guint selected : 1;
     guint selected_before_rubberbanding : 1;
 };
@@ -501,7 +509,29 @@ struct _ExoIconViewPrivate
 
     gint layout_idle_id;
 
+    /* Incremental layout: only the items from layout_dirty_first to
+     * layout_dirty_last changed since the last layout, the items before
+     * keep their positions.  The other layout_* fields are what the last
+     * layout depended on, layout_all forces a full layout.
+     */
+    gint layout_dirty_first;
+    gint layout_dirty_last;
+    gint layout_width;
+    gint layout_height;
+    gint layout_focus_width;
+    gint layout_item_size;
+    gint layout_max_lines;
+    guint layout_rtl : 1;
+    guint layout_all : 1;
+
+    /* Spatial index of the item areas for hit testing, rebuilt on the
+     * first lookup after the items moved.
+     */
+    PtkItemGrid *item_grid;
+    guint item_grid_valid : 1;
+
     gboolean doing_rubberband;
+    gboolean rubberband_check_all;
     gint rubberband_x1, rubberband_y1;
     gint rubberband_x2, rubberband_y2;
 #if GTK_CHECK_VERSION (3, 0, 0)
@@ -1268,6 +1298,10 @@ exo_icon_view_init (ExoIconView *icon_view)
     icon_view->priv->column_spacing = 3;
     icon_view->priv->margin = 3;
 
+    icon_view->priv->layout_dirty_first = G_MAXINT;
+    icon_view->priv->layout_dirty_last = -1;
+    icon_view->priv->layout_all = TRUE;
+
     icon_view->priv->enable_search = TRUE;
     icon_view->priv->search_column = -1;
     icon_view->priv->search_equal_func = exo_icon_view_search_equal_func;
@@ -1336,6 +1370,10 @@ exo_icon_view_finalize (GObject *object)
     if (G_UNLIKELY (icon_view->priv->single_click_timeout_id != 0))
         g_source_remove (icon_view->priv->single_click_timeout_id);
 
+    /* drop the hit test index */
+    if (G_LIKELY (icon_view->priv->item_grid != NULL))
+        ptk_item_grid_free (icon_view->priv->item_grid);
+
     /* kill the layout idle source (it's important to have this last!) */
     if (G_UNLIKELY (icon_view->priv->layout_idle_id != 0))
         g_source_remove (icon_view->priv->layout_idle_id);
@@ -2852,7 +2890,7 @@ exo_icon_view_update_rubberband (gpointer data)
     icon_view->priv->rubberband_x2 = x;
     icon_view->priv->rubberband_y2 = y;
 
-    exo_icon_view_update_rubberband_selection (icon_view);
+    exo_icon_view_update_rubberband_selection (icon_view, &old_area);
 }
 
 
@@ -2883,6 +2921,7 @@ exo_icon_view_start_rubberbanding (ExoIconView  *icon_view,
     icon_view->priv->rubberband_y2 = y;
 
     icon_view->priv->doing_rubberband = TRUE;
+    icon_view->priv->rubberband_check_all = TRUE;
 
 #if GTK_CHECK_VERSION (3, 0, 0)
     GtkStyleContext *style_ctx = gtk_widget_get_style_context (GTK_WIDGET (icon_view));
@@ -2969,12 +3008,15 @@ exo_icon_view_stop_rubberbanding (ExoIconView *icon_view)
 
 
 static void
-exo_icon_view_update_rubberband_selection (ExoIconView *icon_view)
+exo_icon_view_update_rubberband_selection (ExoIconView        *icon_view,
+                                           const GdkRectangle *old_area)
 {
     ExoIconViewItem *item;
+    GdkRectangle     area;
     gboolean         selected;
     gboolean         changed = FALSE;
     gboolean         is_in;
+    GList           *items = NULL;
     GList           *lp;
     gint             x, y;
     gint             width;
@@ -2986,8 +3028,25 @@ exo_icon_view_update_rubberband_selection (ExoIconView *icon_view)
     width = ABS (icon_view->priv->rubberband_x1 - icon_view->priv->rubberband_x2);
     height = ABS (icon_view->priv->rubberband_y1 - icon_view->priv->rubberband_y2);
 
-    /* check all items */
-    for (lp = icon_view->priv->items; lp != NULL; lp = lp->next)
+    /* items outside the old and the new area keep their state, unless
+     * they moved since the last update.
+     */
+    if (G_UNLIKELY (icon_view->priv->rubberband_check_all))
+    {
+        lp = icon_view->priv->items;
+        icon_view->priv->rubberband_check_all = FALSE;
+    }
+    else
+    {
+        area.x = x;
+        area.y = y;
+        area.width = width;
+        area.height = height;
+        gdk_rectangle_union (&area, old_area, &area);
+        lp = items = ptk_item_grid_get_in_rect (exo_icon_view_get_item_grid (icon_view->priv), &area);
+    }
+
+    for (; lp != NULL; lp = lp->next)
     {
         item = EXO_ICON_VIEW_ITEM (lp->data);
 
@@ -3002,6 +3061,7 @@ exo_icon_view_update_rubberband_selection (ExoIconView *icon_view)
             exo_icon_view_queue_draw_item (icon_view, item);
         }
     }
+    g_list_free (items);
 
     if (G_LIKELY (changed))
         g_signal_emit (G_OBJECT (icon_view), icon_view_signals[SELECTION_CHANGED], 0);
@@ -3313,6 +3373,7 @@ static GList*
 exo_icon_view_layout_single_row (ExoIconView *icon_view,
                                  GList       *first_item,
                                  gint         item_width,
+                                 gint         focus_width,
                                  gint         row,
                                  gint        *y,
                                  gint        *maximum_width,
@@ -3326,7 +3387,6 @@ exo_icon_view_layout_single_row (ExoIconView *icon_view,
     GList              *items = first_item;
     gint               *max_width;
     gint               *max_height;
-    gint                focus_width;
     gint                current_width;
     gint                colspan;
     gint                col = 0;
@@ -3343,10 +3403,6 @@ exo_icon_view_layout_single_row (ExoIconView *icon_view,
         max_height[i] = 0;
     }
 
-    gtk_widget_style_get (GTK_WIDGET (icon_view),
-                          "focus-line-width", &focus_width,
-                          NULL);
-
     x = priv->margin + focus_width;
     current_width = 2 * (priv->margin + focus_width);
 
@@ -3417,6 +3473,7 @@ static GList*
 exo_icon_view_layout_single_col (ExoIconView *icon_view,
                                  GList       *first_item,
                                  gint         item_height,
+                                 gint         focus_width,
                                  gint         col,
                                  gint        *x,
                                  gint        *maximum_height,
@@ -3429,7 +3486,6 @@ exo_icon_view_layout_single_col (ExoIconView *icon_view,
     GList              *last_item;
     gint               *max_width;
     gint               *max_height;
-    gint                focus_width;
     gint                current_height;
     gint                rowspan;
     gint                row = 0;
@@ -3444,10 +3500,6 @@ exo_icon_view_layout_single_col (ExoIconView *icon_view,
         max_height[i] = 0;
     }
 
-    gtk_widget_style_get (GTK_WIDGET (icon_view),
-                          "focus-line-width", &focus_width,
-                          NULL);
-
     y = priv->margin + focus_width;
     current_height = 2 * (priv->margin + focus_width);
 
@@ -3537,39 +3589,104 @@ exo_icon_view_set_adjustment_upper (GtkAdjustment *adj,
 
 
 
+static GList*
+exo_icon_view_layout_restart (ExoIconView *icon_view,
+                              gint        *line,
+                              gint        *index)
+{
+    ExoIconViewPrivate *priv = icon_view->priv;
+    ExoIconViewItem    *item;
+    GList              *lp;
+
+    *line = 0;
+    *index = 0;
+
+    if (priv->layout_dirty_first == 0)
+        return priv->items;
+
+    /* the item before the first changed one keeps its position */
+    lp = g_list_nth (priv->items, priv->layout_dirty_first - 1);
+    if (G_UNLIKELY (lp == NULL))
+        return priv->items;
+
+    item = EXO_ICON_VIEW_ITEM (lp->data);
+    *line = (priv->layout_mode == EXO_ICON_VIEW_LAYOUT_ROWS) ? item->row : item->col;
+    *index = priv->layout_dirty_first - 1;
+
+    /* the layout continues with the first item of its row/column */
+    for (; lp->prev != NULL; lp = lp->prev, --*index)
+    {
+        item = EXO_ICON_VIEW_ITEM (lp->prev->data);
+        if (((priv->layout_mode == EXO_ICON_VIEW_LAYOUT_ROWS) ? item->row : item->col) != *line)
+            break;
+    }
+
+    return lp;
+}
+
+
+
 static gint
 exo_icon_view_layout_cols (ExoIconView *icon_view,
                            gint         item_height,
+                           gint         focus_width,
                            gint        *x,
                            gint        *maximum_height,
                            gint         max_rows)
 {
-    GList *icons = icon_view->priv->items;
-    GList *items;
-    gint   col = 0;
-    gint   rows;
+    ExoIconViewPrivate *priv = icon_view->priv;
+    ExoIconViewItem    *item;
+    GList              *icons = priv->items;
+    GList              *items;
+    gint                col = 0;
+    gint                rows = priv->rows;
+    gint                index = 0;
+    gint                n;
+
+    *x = priv->margin;
 
-    *x = icon_view->priv->margin;
+    /* continue with the first column that changed */
+    if (!priv->layout_all)
+    {
+        icons = exo_icon_view_layout_restart (icon_view, &col, &index);
+        if (col > 0)
+            *x = EXO_ICON_VIEW_ITEM (icons->data)->area.x;
+    }
 
     do
     {
-        icons = exo_icon_view_layout_single_col (icon_view, icons,
-                                                 item_height, col,
+        items = icons;
+        icons = exo_icon_view_layout_single_col (icon_view, items,
+                                                 item_height, focus_width, col,
                                                  x, maximum_height, max_rows);
 
         /* count the number of rows in the first column */
+        for (n = 0; items != icons; items = items->next, ++n)
+            ;
         if (G_UNLIKELY (col == 0))
-        {
-            for (items = icon_view->priv->items, rows = 0; items != icons; items = items->next, ++rows)
-                ;
-        }
+            rows = n;
 
+        index += n;
         col++;
+
+        /* past the changed items, a column starting with the same item at the
+         * same position as before is followed by unchanged columns only.
+         */
+        if (icons != NULL && index > priv->layout_dirty_last && !priv->layout_all)
+        {
+            item = EXO_ICON_VIEW_ITEM (icons->data);
+            if (item->col == col && item->area.x == *x
+                    && item->area.y == priv->margin + 2 * focus_width)
+            {
+                *x = priv->width;
+                return rows;
+            }
+        }
     }
     while (icons != NULL);
 
-    *x += icon_view->priv->margin;
-    icon_view->priv->cols = col;
+    *x += priv->margin;
+    priv->cols = col;
 
     return rows;
 }
@@ -3579,36 +3696,66 @@ exo_icon_view_layout_cols (ExoIconView *icon_view,
 static gint
 exo_icon_view_layout_rows (ExoIconView *icon_view,
                            gint         item_width,
+                           gint         focus_width,
                            gint        *y,
                            gint        *maximum_width,
                            gint         max_cols)
 {
-    GList *icons = icon_view->priv->items;
-    GList *items;
-    gint   row = 0;
-    gint   cols;
+    ExoIconViewPrivate *priv = icon_view->priv;
+    ExoIconViewItem    *item;
+    GList              *icons = priv->items;
+    GList              *items;
+    gint                row = 0;
+    gint                cols = priv->cols;
+    gint                index = 0;
+    gint                n, x;
 
-    *y = icon_view->priv->margin;
+    *y = priv->margin;
+
+    /* continue with the first row that changed */
+    if (!priv->layout_all)
+    {
+        icons = exo_icon_view_layout_restart (icon_view, &row, &index);
+        if (row > 0)
+            *y = EXO_ICON_VIEW_ITEM (icons->data)->area.y - focus_width;
+    }
 
     do
     {
-        icons = exo_icon_view_layout_single_row (icon_view, icons,
-                                                 item_width, row,
+        items = icons;
+        icons = exo_icon_view_layout_single_row (icon_view, items,
+                                                 item_width, focus_width, row,
                                                  y, maximum_width, max_cols);
 
         /* count the number of columns in the first row */
+        for (n = 0; items != icons; items = items->next, ++n)
+            ;
         if (G_UNLIKELY (row == 0))
-        {
-            for (items = icon_view->priv->items, cols = 0; items != icons; items = items->next, ++cols)
-                ;
-        }
+            cols = n;
 
+        index += n;
         row++;
+
+        /* past the changed items, a row starting with the same item at the
+         * same position as before is followed by unchanged rows only.
+         */
+        if (icons != NULL && index > priv->layout_dirty_last && !priv->layout_all)
+        {
+            item = EXO_ICON_VIEW_ITEM (icons->data);
+            x = priv->margin + focus_width;
+            if (G_UNLIKELY (priv->layout_rtl))
+                x = priv->layout_width - item->area.width - x;
+            if (item->row == row && item->area.y == *y + focus_width && item->area.x == x)
+            {
+                *y = priv->height;
+                return cols;
+            }
+        }
     }
     while (icons != NULL);
 
-    *y += icon_view->priv->margin;
-    icon_view->priv->rows = row;
+    *y += priv->margin;
+    priv->rows = row;
 
     return cols;
 }
@@ -3622,6 +3769,9 @@ exo_icon_view_layout (ExoIconView *icon_view)
     ExoIconViewItem    *item;
     GtkAllocation       allocation;
     GList              *icons;
+    gboolean            rtl;
+    gboolean            incremental;
+    gint                focus_width;
     gint                maximum_height = 0;
     gint                maximum_width = 0;
     gint                item_height;
@@ -3635,6 +3785,27 @@ exo_icon_view_layout (ExoIconView *icon_view)
 
     gtk_widget_get_allocation (GTK_WIDGET (icon_view), &allocation);
 
+    gtk_widget_style_get (GTK_WIDGET (icon_view),
+                          "focus-line-width", &focus_width,
+                          NULL);
+
+    rtl = (gtk_widget_get_direction (GTK_WIDGET (icon_view)) == GTK_TEXT_DIR_RTL);
+
+    /* the positions of all items depend on these */
+    if (allocation.width != priv->layout_width || allocation.height != priv->layout_height
+            || focus_width != priv->layout_focus_width || rtl != priv->layout_rtl)
+    {
+        priv->layout_width = allocation.width;
+        priv->layout_height = allocation.height;
+        priv->layout_focus_width = focus_width;
+        priv->layout_rtl = rtl;
+        priv->layout_all = TRUE;
+    }
+
+    /* nothing changed since the last layout */
+    if (!priv->layout_all && priv->layout_dirty_first == G_MAXINT)
+        goto done;
+
     /* determine the layout mode */
     if (G_LIKELY (priv->layout_mode == EXO_ICON_VIEW_LAYOUT_ROWS))
     {
@@ -3650,7 +3821,15 @@ exo_icon_view_layout (ExoIconView *icon_view)
             }
         }
 
-        cols = exo_icon_view_layout_rows (icon_view, item_width, &y, &maximum_width, 0);
+        if (item_width != priv->layout_item_size)
+        {
+            priv->layout_item_size = item_width;
+            priv->layout_all = TRUE;
+        }
+
+        incremental = !priv->layout_all;
+        cols = exo_icon_view_layout_rows (icon_view, item_width, focus_width, &y, &maximum_width,
+                                          incremental ? priv->layout_max_lines : 0);
 
         /* If, by adding another column, we increase the height of the icon view, thus forcing a
        * vertical scrollbar to appear that would prevent the last column from being able to fit,
@@ -3659,8 +3838,18 @@ exo_icon_view_layout (ExoIconView *icon_view)
         if (cols == priv->cols + 1 && y > allocation.height &&
                 priv->height <= allocation.height)
         {
-            cols = exo_icon_view_layout_rows (icon_view, item_width, &y, &maximum_width, priv->cols);
+            priv->layout_all = TRUE;
+            priv->layout_max_lines = priv->cols;
+            cols = exo_icon_view_layout_rows (icon_view, item_width, focus_width, &y, &maximum_width, priv->cols);
         }
+        else if (!incremental)
+        {
+            priv->layout_max_lines = 0;
+        }
+
+        /* the rows that weren't layouted again keep their width */
+        if (!priv->layout_all)
+            maximum_width = MAX (maximum_width, priv->width);
 
         priv->width = maximum_width;
         priv->height = y;
@@ -3676,7 +3865,15 @@ exo_icon_view_layout (ExoIconView *icon_view)
             item_height = MAX (item_height, item->area.height);
         }
 
-        rows = exo_icon_view_layout_cols (icon_view, item_height, &x, &maximum_height, 0);
+        if (item_height != priv->layout_item_size)
+        {
+            priv->layout_item_size = item_height;
+            priv->layout_all = TRUE;
+        }
+
+        incremental = !priv->layout_all;
+        rows = exo_icon_view_layout_cols (icon_view, item_height, focus_width, &x, &maximum_height,
+                                          incremental ? priv->layout_max_lines : 0);
 
         /* If, by adding another row, we increase the width of the icon view, thus forcing a
        * horizontal scrollbar to appear that would prevent the last row from being able to fit,
@@ -3685,14 +3882,32 @@ exo_icon_view_layout (ExoIconView *icon_view)
         if (rows == priv->rows + 1 && x > allocation.width &&
                 priv->width <= allocation.width)
         {
-            rows = exo_icon_view_layout_cols (icon_view, item_height, &x, &maximum_height, priv->rows);
+            priv->layout_all = TRUE;
+            priv->layout_max_lines = priv->rows;
+            rows = exo_icon_view_layout_cols (icon_view, item_height, focus_width, &x, &maximum_height, priv->rows);
         }
+        else if (!incremental)
+        {
+            priv->layout_max_lines = 0;
+        }
+
+        /* the columns that weren't layouted again keep their height */
+        if (!priv->layout_all)
+            maximum_height = MAX (maximum_height, priv->height);
 
         priv->height = maximum_height;
         priv->width = x;
         priv->rows = rows;
     }
 
+    priv->layout_dirty_first = G_MAXINT;
+    priv->layout_dirty_last = -1;
+    priv->layout_all = FALSE;
+
+    /* the items moved */
+    priv->item_grid_valid = FALSE;
+    priv->rubberband_check_all = TRUE;
+
     exo_icon_view_set_adjustment_upper (priv->hadjustment, priv->width);
     exo_icon_view_set_adjustment_upper (priv->vadjustment, priv->height);
 
@@ -3703,11 +3918,12 @@ exo_icon_view_layout (ExoIconView *icon_view)
                            MAX (priv->height, allocation.height));
     }
 
+    gtk_widget_queue_draw (GTK_WIDGET (icon_view));
+
+done:
     /* drop any pending layout idle source */
     if (priv->layout_idle_id != 0)
         g_source_remove (priv->layout_idle_id);
-
-    gtk_widget_queue_draw (GTK_WIDGET (icon_view));
 }
 
 
@@ -4055,12 +4271,36 @@ layout_destroy (gpointer user_data)
 static void
 exo_icon_view_queue_layout (ExoIconView *icon_view)
 {
+    icon_view->priv->layout_all = TRUE;
+
     if (G_UNLIKELY (icon_view->priv->layout_idle_id == 0))
         icon_view->priv->layout_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, layout_callback, icon_view, layout_destroy);
 }
 
 
 
+/* Queue a layout of the items starting at index, after shift items were
+ * inserted (> 0) or removed (< 0) there.
+ */
+static void
+exo_icon_view_queue_layout_items (ExoIconView *icon_view,
+                                  gint         index,
+                                  gint         shift)
+{
+    ExoIconViewPrivate *priv = icon_view->priv;
+
+    if (priv->layout_dirty_last >= index)
+        priv->layout_dirty_last = MAX (priv->layout_dirty_last + shift, index);
+    else
+        priv->layout_dirty_last = index;
+    priv->layout_dirty_first = MIN (priv->layout_dirty_first, index);
+
+    if (G_UNLIKELY (priv->layout_idle_id == 0))
+        priv->layout_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, layout_callback, icon_view, layout_destroy);
+}
+
+
+
 static void
 exo_icon_view_set_cursor_item (ExoIconView     *icon_view,
                                ExoIconViewItem *item,
@@ -4082,6 +4322,71 @@ exo_icon_view_set_cursor_item (ExoIconView     *icon_view,
 
 
 
+static PtkItemGrid*
+exo_icon_view_get_item_grid (ExoIconViewPrivate *priv)
+{
+    ExoIconViewCellInfo *info;
+    ExoIconViewItem     *item;
+    GdkRectangle         rect;
+    GdkRectangle        *box;
+    GList               *items;
+    GList               *lp;
+
+    if (G_UNLIKELY (priv->item_grid == NULL))
+        priv->item_grid = ptk_item_grid_new ();
+    else if (G_LIKELY (priv->item_grid_valid))
+        return priv->item_grid;
+
+    ptk_item_grid_clear (priv->item_grid);
+    for (items = priv->items; items != NULL; items = items->next)
+    {
+        item = EXO_ICON_VIEW_ITEM (items->data);
+        if (G_UNLIKELY (item->area.width < 0))
+            continue;
+
+        /* the area as seen by exo_icon_view_item_at_coords() */
+        rect.x = item->area.x - priv->row_spacing / 2;
+        rect.y = item->area.y - priv->column_spacing / 2;
+        rect.width = item->area.width + 2 * (priv->row_spacing / 2);
+        rect.height = item->area.height + 2 * (priv->column_spacing / 2);
+
+        /* and the cells, for the rubberband */
+        for (lp = priv->cell_list; lp != NULL; lp = lp->next)
+        {
+            info = EXO_ICON_VIEW_CELL_INFO (lp->data);
+            if (info->position >= item->n_cells || !gtk_cell_renderer_get_visible (info->cell))
+                continue;
+
+            box = item->box + info->position;
+            if (box->width > 0 && box->height > 0)
+                gdk_rectangle_union (&rect, box, &rect);
+        }
+
+        ptk_item_grid_add (priv->item_grid, &rect, item);
+    }
+
+    priv->item_grid_valid = TRUE;
+
+    return priv->item_grid;
+}
+
+
+
+static gboolean
+exo_icon_view_item_at_coords (gpointer data,
+                              gint     x,
+                              gint     y,
+                              gpointer user_data)
+{
+    const ExoIconViewItem    *item = data;
+    const ExoIconViewPrivate *priv = user_data;
+
+    return (x >= item->area.x - priv->row_spacing / 2 && x <= item->area.x + item->area.width + priv->row_spacing / 2 &&
+            y >= item->area.y - priv->column_spacing / 2 && y <= item->area.y + item->area.height + priv->column_spacing / 2);
+}
+
+
+
 static ExoIconViewItem*
 exo_icon_view_get_item_at_coords (const ExoIconView    *icon_view,
                                   gint                  x,
@@ -4093,52 +4398,46 @@ exo_icon_view_get_item_at_coords (const ExoIconView    *icon_view,
     ExoIconViewCellInfo      *info;
     ExoIconViewItem          *item;
     GdkRectangle              box;
-    const GList              *items;
     const GList              *lp;
 
-    for (items = priv->items; items != NULL; items = items->next)
+    item = ptk_item_grid_find (exo_icon_view_get_item_grid (icon_view->priv), x, y,
+                               exo_icon_view_item_at_coords, icon_view->priv);
+    if (item == NULL)
+        return NULL;
+
+    if (only_in_cell || cell_at_pos)
     {
-        item = items->data;
-        if (x >= item->area.x - priv->row_spacing / 2 && x <= item->area.x + item->area.width + priv->row_spacing / 2 &&
-                y >= item->area.y - priv->column_spacing / 2 && y <= item->area.y + item->area.height + priv->column_spacing / 2)
+        exo_icon_view_set_cell_data (icon_view, item);
+        for (lp = priv->cell_list; lp != NULL; lp = lp->next)
         {
-            if (only_in_cell || cell_at_pos)
-            {
-                exo_icon_view_set_cell_data (icon_view, item);
-                for (lp = priv->cell_list; lp != NULL; lp = lp->next)
-                {
-                    /* check if the cell is visible */
-                    info = (ExoIconViewCellInfo *) lp->data;
-                    if (!gtk_cell_renderer_get_visible (info->cell))
-                        continue;
-
-                    box = item->box[info->position];
-                    if ((x >= box.x && x <= box.x + box.width &&
-                         y >= box.y && y <= box.y + box.height) ||
-                            (x >= box.x  &&
-                             x <= box.x + box.width &&
-                             y >= box.y &&
-                             y <= box.y + box.height))
-                    {
-                        if (cell_at_pos != NULL)
-                            *cell_at_pos = info;
-
-                        return item;
-                    }
-                }
-
-                if (only_in_cell)
-                    return NULL;
+            /* check if the cell is visible */
+            info = (ExoIconViewCellInfo *) lp->data;
+            if (!gtk_cell_renderer_get_visible (info->cell))
+                continue;
 
+            box = item->box[info->position];
+            if ((x >= box.x && x <= box.x + box.width &&
+                 y >= box.y && y <= box.y + box.height) ||
+                    (x >= box.x  &&
+                     x <= box.x + box.width &&
+                     y >= box.y &&
+                     y <= box.y + box.height))
+            {
                 if (cell_at_pos != NULL)
-                    *cell_at_pos = NULL;
-            }
+                    *cell_at_pos = info;
 
-            return item;
+                return item;
+            }
         }
+
+        if (only_in_cell)
+            return NULL;
+
+        if (cell_at_pos != NULL)
+            *cell_at_pos = NULL;
     }
 
-    return NULL;
+    return item;
 }
 
 
@@ -4203,7 +4502,7 @@ exo_icon_view_row_changed (GtkTreeModel *model,
    * indicates that the item needs to be layouted).
    */
     item->area.width = -1;
-    exo_icon_view_queue_layout (icon_view);
+    exo_icon_view_queue_layout_items (icon_view, gtk_tree_path_get_indices (path)[0], 0);
 }
 
 
@@ -4226,7 +4525,7 @@ exo_icon_view_row_inserted (GtkTreeModel *model,
     icon_view->priv->items = g_list_insert (icon_view->priv->items, item, index);
 
     /* recalculate the layout */
-    exo_icon_view_queue_layout (icon_view);
+    exo_icon_view_queue_layout_items (icon_view, index, 1);
 }
 
 
@@ -4278,12 +4577,13 @@ exo_icon_view_row_deleted (GtkTreeModel *model,
 
     /* drop the item from the list */
     icon_view->priv->items = g_list_delete_link (icon_view->priv->items, list);
+    icon_view->priv->item_grid_valid = FALSE;
 
     /* release the item */
     _exo_slice_free (ExoIconViewItem, item);
 
     /* recalculate the layout */
-    exo_icon_view_queue_layout (icon_view);
+    exo_icon_view_queue_layout_items (icon_view, gtk_tree_path_get_indices (path)[0], -1);
 
     /* if we removed a previous selected item, we need
    * to tell others that we have a new selection.
@@ -5666,6 +5966,7 @@ exo_icon_view_set_model (ExoIconView  *icon_view,
         }
         g_list_free (icon_view->priv->items);
         icon_view->priv->items = NULL;
+        icon_view->priv->item_grid_valid = FALSE;
 
         /* reset statistics */
         icon_view->priv->search_column = -1;
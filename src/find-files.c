@@ -19,10 +19,6 @@
  *      MA 02110-1301, USA.
  */
 
-/* FIXME: Currently this only works with GNU find-utils.
- * Compatibility with other systems like BSD, need to be improved.
- */
-
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
@@ -32,8 +28,6 @@
 #include <string.h>
 #include <time.h>
 #include <sys/types.h>
-#include <signal.h>
-#include <sys/wait.h>
 
 #include "pcmanfm.h"
 
@@ -43,6 +37,7 @@
 #include "vfs-file-info.h"
 
 #include "vfs-async-task.h"
+#include "vfs-search.h"
 #include "exo-tree-view.h"
 #include "vfs-volume.h"
 
@@ -64,6 +59,27 @@ enum
     N_RES_COLS
 };
 
+/* The rows of the result view.  Values are made when the view asks for
+ * them, so the icon and type of a file are only looked up once its row is
+ * shown. */
+typedef struct _ResultList
+{
+    GObject parent;
+    GPtrArray* rows;    /* FoundFile* */
+    gint stamp;
+}ResultList;
+
+typedef struct _ResultListClass
+{
+    GObjectClass parent_class;
+}ResultListClass;
+
+static void result_list_tree_model_init( GtkTreeModelIface* iface );
+
+G_DEFINE_TYPE_WITH_CODE( ResultList, result_list, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE( GTK_TYPE_TREE_MODEL,
+                                                result_list_tree_model_init ) )
+
 typedef struct _FindFile
 {
     GtkWidget* win;
@@ -110,16 +126,19 @@ typedef struct _FindFile
     /* search result pane */
     GtkWidget* search_result;
     GtkWidget* result_view;
-    GtkListStore* result_list;
+    ResultList* result_list;
+
+    /* found files loaded by the search, added to result_list in batches */
+    GMutex* found_mutex;
+    GQueue* found;
+    guint update_timeout;
 
     /* buttons */
     GtkWidget* start_btn;
     GtkWidget* stop_btn;
     GtkWidget* again_btn;
 
-    GPid pid;
-    int stdo;
-
+    VFSSearch* search;
     VFSAsyncTask* task;
 }FindFile;
 
@@ -127,8 +146,15 @@ typedef struct
 {
     VFSFileInfo* fi;
     char* dir_path;
+    gboolean mime_loaded;   /* sniffed when the row is first shown */
 }FoundFile;
 
+/* Files found are loaded by the workers of the search, and added to the
+ * result list in batches from a timeout, for at most RESULT_UPDATE_BUDGET
+ * each, so the view stays responsive however many files are found. */
+#define RESULT_UPDATE_INTERVAL  16      /* ms between batches */
+#define RESULT_UPDATE_BUDGET    0.008   /* seconds spent adding a batch */
+
 static const char menu_def[] =
 "<ui>"
 "<popup name=\"Popup\">"
@@ -300,19 +326,16 @@ static int get_date_offset( GtkCalendar* calendar )
     return ABS(offset);
 }
 
-static char** compose_command( FindFile* data )
+/* Fill crit from the dialog.  crit->dirs should be freed with g_strfreev(),
+ * the other strings belong to the widgets. */
+static void compose_criteria( FindFile* data, VFSSearchCriteria* crit )
 {
-    GArray* argv = g_array_sized_new( TRUE, TRUE, sizeof(char*), 10 );
-    char *arg, *tmp;
+    GPtrArray* dirs = g_ptr_array_new();
     GtkTreeIter it;
-    char size_units[] = {"ckMG"};
+    static const off64_t size_units[] = { 1, 1024, 1024 * 1024, 1024 * 1024 * 1024 };
+    static const int max_days[] = { -1, 1, 7, 30, 365 };
+    char *arg;
     int idx;
-    gboolean print = FALSE;
-
-    arg = g_strdup( "find" );
-    g_array_append_val( argv, arg );
-    arg = g_strdup("-H");
-    g_array_append_val( argv, arg );
 
     if( gtk_tree_model_get_iter_first( GTK_TREE_MODEL( data->places_list ), &it ) )
     {
@@ -321,332 +344,339 @@ static char** compose_command( FindFile* data )
             if( arg )
             {
                 if( *arg )
-                    g_array_append_val( argv, arg );
+                    g_ptr_array_add( dirs, arg );
                 else
                     g_free( arg );
             }
         }while( gtk_tree_model_iter_next( GTK_TREE_MODEL( data->places_list ), &it ) );
     }
+    g_ptr_array_add( dirs, NULL );
+    crit->dirs = (char**)g_ptr_array_free( dirs, FALSE );
+
+    crit->recursive = gtk_toggle_button_get_active( (GtkToggleButton*)data->include_sub );
+    crit->hidden = gtk_toggle_button_get_active( (GtkToggleButton*)data->search_hidden );
 
-    /* if include sub is excluded */  //MOD added
-    if( ! gtk_toggle_button_get_active((GtkToggleButton*)data->include_sub ) )
+    /* sizes are in bytes, KiB, MiB or GiB */
+    crit->size_lower = crit->size_upper = -1;
+    if( gtk_toggle_button_get_active((GtkToggleButton*)data->use_size_lower ) )
     {
-        arg = g_strdup("-maxdepth");
-        g_array_append_val( argv, arg );
-        arg = g_strdup("1");
-        g_array_append_val( argv, arg );
+        idx = gtk_combo_box_get_active( (GtkComboBox*)data->size_lower_unit );
+        crit->size_lower = gtk_spin_button_get_value_as_int( (GtkSpinButton*)data->size_lower )
+                                        * size_units[ CLAMP( idx, 0, 3 ) ];
     }
-
-    /* if hidden files is excluded */
-    if( ! gtk_toggle_button_get_active((GtkToggleButton*)data->search_hidden ) )
+    if( gtk_toggle_button_get_active((GtkToggleButton*)data->use_size_upper ) )
     {
-        arg = g_strdup("-name");
-        g_array_append_val( argv, arg );
-        arg = g_strdup(".*");
-        g_array_append_val( argv, arg );
-        arg = g_strdup("-prune");
-        g_array_append_val( argv, arg );
-        arg = g_strdup("-or");
-        g_array_append_val( argv, arg );
+        idx = gtk_combo_box_get_active( (GtkComboBox*)data->size_upper_unit );
+        crit->size_upper = gtk_spin_button_get_value_as_int( (GtkSpinButton*)data->size_upper )
+                                        * size_units[ CLAMP( idx, 0, 3 ) ];
     }
 
-    /* if lower limit of file size is set */
-    if( gtk_toggle_button_get_active((GtkToggleButton*)data->use_size_lower ) )
+    /* "*" matches any name */
+    crit->name = (char*)gtk_entry_get_text( (GtkEntry*)data->fn_pattern_entry );
+    if( crit->name && !strcmp( crit->name, "*" ) )
+        crit->name = NULL;
+    crit->name_case_sensitive = gtk_toggle_button_get_active((GtkToggleButton*)data->fn_case_sensitive);
+
+    /* match by mtime */
+    crit->max_days = crit->min_days = -1;
+    idx = gtk_combo_box_get_active( (GtkComboBox*)data->date_limit );
+    if( idx == 5 )  /* range */
     {
-//        arg = g_strdup("(");
-//        g_array_append_val( argv, arg );
+        crit->max_days = get_date_offset( (GtkCalendar*)data->date1 );
+        crit->min_days = get_date_offset( (GtkCalendar*)data->date2 );
+    }
+    else if( idx > 0 && idx < 5 )
+        crit->max_days = max_days[ idx ];
 
-        arg = g_strdup("-size");
-        g_array_append_val( argv, arg );
+    /* text inside files */
+    crit->text = (char*)gtk_entry_get_text( (GtkEntry*)data->fc_pattern );
+    crit->text_case_sensitive = gtk_toggle_button_get_active((GtkToggleButton*)data->fc_case_sensitive);
+    crit->text_regexp = gtk_toggle_button_get_active((GtkToggleButton*)data->fc_use_regexp);
+}
 
-        tmp = g_strdup_printf( "+%u%c",
-                        gtk_spin_button_get_value_as_int( (GtkSpinButton*)data->size_lower ),
-                        size_units[ gtk_combo_box_get_active( (GtkComboBox*)data->size_lower_unit ) ] );
-    g_array_append_val( argv, tmp );
+static void finish_search( FindFile* data )
+{
+    if( data->task )
+    {
+        g_object_unref( data->task );
+        data->task = NULL;
+    }
+    if( data->search )
+    {
+        vfs_search_free( data->search );
+        data->search = NULL;
+    }
+    gdk_window_set_cursor( gtk_widget_get_window( data->search_result ), NULL );
+    gtk_widget_hide( data->stop_btn );
+    gtk_widget_show( data->again_btn );
+}
 
-/*        arg = g_strdup( tmp + 1 );
-        g_array_append_val( argv, arg );
+static void found_file_free( FoundFile* ff )
+{
+    vfs_file_info_unref( ff->fi );
+    g_free( ff->dir_path );
+    g_slice_free( FoundFile, ff );
+}
 
-        arg = g_strdup("-o"); // -or
-        g_array_append_val( argv, arg );
+static void result_list_init( ResultList* list )
+{
+    list->rows = g_ptr_array_new();
+    list->stamp = g_random_int();
+}
 
-        arg = g_strdup("-size");
-        g_array_append_val( argv, arg );
+/* Remove all rows - only while the list isn't the model of a view, as no
+ * signals are emitted */
+static void result_list_clear( ResultList* list )
+{
+    g_ptr_array_foreach( list->rows, (GFunc)found_file_free, NULL );
+    g_ptr_array_set_size( list->rows, 0 );
+    ++list->stamp;
+}
 
-        g_array_append_val( argv, tmp );
+static void result_list_finalize( GObject* object )
+{
+    ResultList* list = (ResultList*)object;
 
-        arg = g_strdup(")");
-        g_array_append_val( argv, arg );
-*/    }
+    result_list_clear( list );
+    g_ptr_array_free( list->rows, TRUE );
+    G_OBJECT_CLASS( result_list_parent_class )->finalize( object );
+}
 
-    /* if upper limit of file size is set */
-    if( gtk_toggle_button_get_active((GtkToggleButton*)data->use_size_upper ) )
-    {
-//        arg = g_strdup("(");
-//        g_array_append_val( argv, arg );
+static void result_list_class_init( ResultListClass* klass )
+{
+    G_OBJECT_CLASS( klass )->finalize = result_list_finalize;
+}
 
-        arg = g_strdup("-size");
-        g_array_append_val( argv, arg );
+static void result_list_append( ResultList* list, FoundFile* ff )
+{
+    GtkTreeIter it;
+    GtkTreePath* tree_path;
 
-        tmp = g_strdup_printf( "-%u%c",
-                        gtk_spin_button_get_value_as_int( (GtkSpinButton*)data->size_upper ),
-                        size_units[ gtk_combo_box_get_active( (GtkComboBox*)data->size_upper_unit ) ] );
+    it.stamp = list->stamp;
+    it.user_data = GINT_TO_POINTER( list->rows->len );
+    it.user_data2 = ff;
+    g_ptr_array_add( list->rows, ff );
 
-        arg = g_strdup( tmp + 1 );
-        g_array_append_val( argv, arg );
-/*
-        arg = g_strdup("-o"); // -or
-        g_array_append_val( argv, arg );
+    tree_path = gtk_tree_path_new_from_indices( list->rows->len - 1, -1 );
+    gtk_tree_model_row_inserted( GTK_TREE_MODEL( list ), tree_path, &it );
+    gtk_tree_path_free( tree_path );
+}
 
-        arg = g_strdup("-size");
-        g_array_append_val( argv, arg );
+static gboolean result_list_set_iter( ResultList* list, GtkTreeIter* it, int n )
+{
+    if ( n < 0 || n >= list->rows->len )
+        return FALSE;
+    it->stamp = list->stamp;
+    it->user_data = GINT_TO_POINTER( n );
+    it->user_data2 = g_ptr_array_index( list->rows, n );
+    return TRUE;
+}
 
-        g_array_append_val( argv, tmp );
+static GtkTreeModelFlags result_list_get_flags( GtkTreeModel* model )
+{
+    return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+}
 
-        arg = g_strdup(")");
-        g_array_append_val( argv, arg );
-*/
-    }
+static gint result_list_get_n_columns( GtkTreeModel* model )
+{
+    return N_RES_COLS;
+}
 
-    /* If -name is used */
-    tmp = (char*)gtk_entry_get_text( (GtkEntry*)data->fn_pattern_entry );
-    if( tmp && strcmp(tmp, "*") )
-    {
-        if( gtk_toggle_button_get_active((GtkToggleButton*)data->fn_case_sensitive) )
-            arg = g_strdup("-name");
-        else
-            arg = g_strdup("-iname");
-        g_array_append_val( argv, arg );
-
-        arg = g_strdup( tmp );
-        g_array_append_val( argv, arg );
-    }
+static GType result_list_get_column_type( GtkTreeModel* model, gint index )
+{
+    if ( index == COL_ICON )
+        return GDK_TYPE_PIXBUF;
+    if ( index == COL_INFO )
+        return G_TYPE_POINTER;
+    return G_TYPE_STRING;
+}
 
-    /* match by mtime */
-    idx = gtk_combo_box_get_active( (GtkComboBox*)data->date_limit );
-    if( idx > 0 )
-    {
-        if( idx == 5 )  /* range */
-        {
-            arg = g_strdup("(");
-            g_array_append_val( argv, arg );
+static gboolean result_list_get_iter( GtkTreeModel* model, GtkTreeIter* it,
+                                      GtkTreePath* tree_path )
+{
+    g_return_val_if_fail( gtk_tree_path_get_depth( tree_path ) == 1, FALSE );
+    return result_list_set_iter( (ResultList*)model, it,
+                                 gtk_tree_path_get_indices( tree_path )[0] );
+}
 
-            arg = g_strdup( "-mtime" );
-            g_array_append_val( argv, arg );
+static GtkTreePath* result_list_get_path( GtkTreeModel* model, GtkTreeIter* it )
+{
+    g_return_val_if_fail( it->stamp == ((ResultList*)model)->stamp, NULL );
+    return gtk_tree_path_new_from_indices( GPOINTER_TO_INT( it->user_data ), -1 );
+}
 
-            /* date1 */
-            arg = g_strdup_printf( "-%d",  get_date_offset( (GtkCalendar*)data->date1 ) );
-            g_array_append_val( argv, arg );
+/* The search only gives a stat, so the mime type is guessed from the name
+ * until a column needing the real one is asked for.  With a fixed height
+ * view, those are the rows shown, and the rows opened */
+static void found_file_load_mime_type( FoundFile* ff )
+{
+    char* path;
 
-            arg = g_strdup( "-mtime" );
-            g_array_append_val( argv, arg );
+    if ( ff->mime_loaded )
+        return;
+    ff->mime_loaded = TRUE;
+    path = g_build_filename( ff->dir_path, vfs_file_info_get_name( ff->fi ),
+                                                                    NULL );
+    vfs_file_info_reload_mime_type( ff->fi, path );
+    g_free( path );
+}
 
-            /* date2 */
-            arg = g_strdup_printf( "+%d", get_date_offset( (GtkCalendar*)data->date2 ) );
-            g_array_append_val( argv, arg );
+static void result_list_get_value( GtkTreeModel* model, GtkTreeIter* it,
+                                   gint column, GValue* value )
+{
+    FoundFile* ff = (FoundFile*)it->user_data2;
 
-            arg = g_strdup(")");
-            g_array_append_val( argv, arg );
-        }
-        else
-        {
-            arg = g_strdup( "-mtime" );
-            g_array_append_val( argv, arg );
+    g_return_if_fail( it->stamp == ((ResultList*)model)->stamp );
 
-            switch( idx )
-            {
-            case 1: /* within one day */
-                arg = g_strdup( "-1" );
-                break;
-            case 2: /* within one week */
-                arg = g_strdup( "-7" );
-                break;
-            case 3: /* within one month */
-                arg = g_strdup( "-30" );
-                break;
-            case 4: /* within one year */
-                arg = g_strdup( "-365" );
-                break;
-            }
-            g_array_append_val( argv, arg );
-        }
-    }
+    if ( column == COL_ICON || column == COL_TYPE || column == COL_INFO )
+        found_file_load_mime_type( ff );
 
-    /* grep text inside files */
-    tmp = (char*)gtk_entry_get_text( (GtkEntry*)data->fc_pattern );
-    if( tmp && *tmp )
+    g_value_init( value, result_list_get_column_type( model, column ) );
+    switch( column )
     {
-        print = TRUE;
+    case COL_ICON:
+        g_value_take_object( value, vfs_file_info_get_small_icon( ff->fi ) );
+        break;
+    case COL_NAME:
+        g_value_set_string( value, vfs_file_info_get_disp_name( ff->fi ) );
+        break;
+    case COL_DIR:
+        g_value_set_string( value, ff->dir_path ); /* FIXME: non-UTF8? */
+        break;
+    case COL_SIZE:
+        g_value_set_string( value, vfs_file_info_get_disp_size( ff->fi ) );
+        break;
+    case COL_TYPE:
+        g_value_set_string( value, vfs_file_info_get_mime_type_desc( ff->fi ) );
+        break;
+    case COL_MTIME:
+        g_value_set_string( value, vfs_file_info_get_disp_mtime( ff->fi ) );
+        break;
+    case COL_INFO:
+        g_value_set_pointer( value, ff->fi );
+        break;
+    }
+}
 
-        /* ensure we only call 'grep' on regular files */
-        arg = g_strdup("-type");
-        g_array_append_val( argv, arg );
-        arg = g_strdup("f");
-        g_array_append_val( argv, arg );
+static gboolean result_list_iter_next( GtkTreeModel* model, GtkTreeIter* it )
+{
+    return result_list_set_iter( (ResultList*)model, it,
+                                 GPOINTER_TO_INT( it->user_data ) + 1 );
+}
 
-        arg = g_strdup("-exec");
-        g_array_append_val( argv, arg );
+static gboolean result_list_iter_nth_child( GtkTreeModel* model, GtkTreeIter* it,
+                                            GtkTreeIter* parent, gint n )
+{
+    return !parent && result_list_set_iter( (ResultList*)model, it, n );
+}
 
-        arg = g_strdup("grep");
-        g_array_append_val( argv, arg );
+static gboolean result_list_iter_children( GtkTreeModel* model, GtkTreeIter* it,
+                                           GtkTreeIter* parent )
+{
+    return result_list_iter_nth_child( model, it, parent, 0 );
+}
 
-        if( !gtk_toggle_button_get_active((GtkToggleButton*)data->fc_case_sensitive) )
-        {
-            arg = g_strdup("-i");
-            g_array_append_val( argv, arg );
-        }
+static gboolean result_list_iter_has_child( GtkTreeModel* model, GtkTreeIter* it )
+{
+    return FALSE;
+}
 
-        arg = g_strdup("--files-with-matches");
-        g_array_append_val( argv, arg );
+static gint result_list_iter_n_children( GtkTreeModel* model, GtkTreeIter* it )
+{
+    return it ? 0 : ((ResultList*)model)->rows->len;
+}
 
-        if( gtk_toggle_button_get_active((GtkToggleButton*)data->fc_use_regexp) )
-            arg = g_strdup( "--regexp" );
-        else
-            arg = g_strdup( "--fixed-strings" );
-        g_array_append_val( argv, arg );
+static gboolean result_list_iter_parent( GtkTreeModel* model, GtkTreeIter* it,
+                                         GtkTreeIter* child )
+{
+    return FALSE;
+}
 
-        arg = g_strdup(tmp);
-        g_array_append_val( argv, arg );
+static void result_list_tree_model_init( GtkTreeModelIface* iface )
+{
+    iface->get_flags = result_list_get_flags;
+    iface->get_n_columns = result_list_get_n_columns;
+    iface->get_column_type = result_list_get_column_type;
+    iface->get_iter = result_list_get_iter;
+    iface->get_path = result_list_get_path;
+    iface->get_value = result_list_get_value;
+    iface->iter_next = result_list_iter_next;
+    iface->iter_children = result_list_iter_children;
+    iface->iter_has_child = result_list_iter_has_child;
+    iface->iter_n_children = result_list_iter_n_children;
+    iface->iter_nth_child = result_list_iter_nth_child;
+    iface->iter_parent = result_list_iter_parent;
+}
 
-        arg = g_strdup("{}");
-        g_array_append_val( argv, arg );
+static gboolean on_result_update( FindFile* data )
+{
+    FoundFile* ff;
+    GTimer* timer;
+    gboolean more;
 
-        arg = g_strdup(";");
-        g_array_append_val( argv, arg );
-    }
+    GDK_THREADS_ENTER();
 
-    if( ! print )
+    /* add what was found until the time of this batch is used up */
+    timer = g_timer_new();
+    do
     {
-        arg = g_strdup("-print");
-        g_array_append_val( argv, arg );
-    }
-    return (char**)g_array_free( argv, FALSE );
+        g_mutex_lock( data->found_mutex );
+        ff = (FoundFile*)g_queue_pop_head( data->found );
+        g_mutex_unlock( data->found_mutex );
+        if ( !ff )
+            break;
+        result_list_append( data->result_list, ff );
+    } while ( g_timer_elapsed( timer, NULL ) < RESULT_UPDATE_BUDGET );
+    g_timer_destroy( timer );
+
+    /* once the search finished, stop when all are added */
+    more = ff || data->task;
+    if ( !more )
+        data->update_timeout = 0;
+
+    GDK_THREADS_LEAVE();
+    return more;
 }
 
-static void finish_search( FindFile* data )
+/* Drop the found files not added yet */
+static void clear_found_files( FindFile* data )
 {
-    if( data->pid )
+    if ( data->update_timeout )
     {
-        int status;
-        kill( data->pid, SIGTERM );
-        waitpid( data->pid, &status, 0 );
-        data->pid = 0;
-        /* g_debug( "find process is killed!" ); */
+        g_source_remove( data->update_timeout );
+        data->update_timeout = 0;
     }
-    if( data->task )
-    {
-        g_object_unref( data->task );
-        data->task = NULL;
-    }
-    gdk_window_set_cursor( gtk_widget_get_window( data->search_result ), NULL );
-    gtk_widget_hide( data->stop_btn );
-    gtk_widget_show( data->again_btn );
+    g_mutex_lock( data->found_mutex );
+    g_queue_foreach( data->found, (GFunc)found_file_free, NULL );
+    g_queue_clear( data->found );
+    g_mutex_unlock( data->found_mutex );
 }
 
-static void process_found_files( FindFile* data, GQueue* queue, const char* path )
+/* VFSSearchFoundCallback, in a worker of the search - makes the info of a
+ * found file from the stat the search already has */
+static void on_search_found( VFSSearch* search, const char* path,
+                             struct stat64* st, FindFile* data )
 {
-    char *name;
-    gsize len, term;
-    GtkTreeIter it;
-    VFSFileInfo* fi;
-    GdkPixbuf* icon;
+    char* name;
     FoundFile* ff;
 
-    if( path )
-    {
-        name = g_filename_display_basename( path );
-        fi = vfs_file_info_new();
-        if( vfs_file_info_get( fi, path, name ) )
-        {
-            ff = g_slice_new0( FoundFile );
-            ff->fi = fi;
-            ff->dir_path = g_path_get_dirname( path );
-            g_queue_push_tail( queue, ff );
-        }
-        else
-        {
-            vfs_file_info_unref( fi );
-        }
-        g_free( name );
-
-        /* we queue the found files, and not add them to the tree view direclty.
-         * when we queued more than 10 files, we add them at once. I think
-         * this can prevent locking gtk+ too frequently and improve responsiveness.
-         * FIXME: This could blocked the last queued files and delay their display
-         * to the end of the whole search. A better method is needed.
-         */
-//MOD disabled this - causes last queued files to not display
-//        if( g_queue_get_length( queue ) < 10 )
-//            return;
-    }
+    name = g_path_get_basename( path );
+    ff = g_slice_new0( FoundFile );
+    ff->fi = vfs_file_info_new();
+    vfs_file_info_get_from_stat( ff->fi, name, st );
+    ff->dir_path = g_path_get_dirname( path );
+    g_free( name );
 
-    while( ff = (FoundFile*)g_queue_pop_head(queue) )
-    {
-        GDK_THREADS_ENTER();
-        gtk_list_store_append( data->result_list, &it );
-        icon = vfs_file_info_get_small_icon( ff->fi );
-        gtk_list_store_set( data->result_list, &it,
-                                    COL_ICON, icon,
-                                    COL_NAME, vfs_file_info_get_disp_name(ff->fi),
-                                    COL_DIR, ff->dir_path, /* FIXME: non-UTF8? */
-                                    COL_TYPE, vfs_file_info_get_mime_type_desc( ff->fi ),
-                                    COL_SIZE, vfs_file_info_get_disp_size( ff->fi ),
-                                    COL_MTIME, vfs_file_info_get_disp_mtime( ff->fi ),
-                                    COL_INFO, ff->fi, -1 );
-        g_object_unref( icon );
-        GDK_THREADS_LEAVE();
-        g_slice_free( FoundFile, ff );
-    }
+    g_mutex_lock( data->found_mutex );
+    g_queue_push_tail( data->found, ff );
+    g_mutex_unlock( data->found_mutex );
 }
 
 static gpointer search_thread( VFSAsyncTask* task, FindFile* data )
 {
-    ssize_t rlen;
-    char buf[4096 ];
-    GString* path = g_string_new_len( NULL, 256 );
-    GQueue* queue = g_queue_new();
-
-    while( ! data->task->cancel && ( rlen = read( data->stdo, buf, sizeof(buf) - 1 ) ) > 0 )
-    {
-        char*pbuf, *eol;
-        buf[ rlen ] = '\0';
-        pbuf = buf;
-
-        while( ! data->task->cancel )
-        {
-            if( eol = strchr( pbuf, '\n' ) )    /* end of line is reached */
-            {
-                *eol = '\0';
-                g_string_append( path, pbuf );
-
-                /* we get a complete file path */
-                if( ! data->task->cancel )
-                {
-                    process_found_files( data, queue, path->str );
-                }
-
-                pbuf = eol + 1; /* start reading the next line */
-                g_string_assign( path, "" );   /* empty the line buffer */
-            }
-            else /* end of line is not reached */
-            {
-                g_string_append( path, pbuf );  /* store the partial path in the buffer */
-                break;
-            }
-        }
-    }
-    /* end of stream (EOF) is reached */
-    if( path->len > 0 ) /* this is the last line without eol character '\n' */
-    {
-        if( ! data->task->cancel )
-        {
-            process_found_files( data, queue, path->str );
-            process_found_files( data, queue, NULL );
-        }
-    }
-
-    g_queue_free( queue );
-    g_string_free( path, TRUE );
+    /* found files are queued by the workers as they're found */
+    vfs_search_start( data->search );
+    vfs_search_wait( data->search, -1 );
     return NULL;
 }
 
@@ -657,22 +687,33 @@ static void on_search_finish( VFSAsyncTask* task, gboolean cancelled, FindFile*
 
 static void on_start_search( GtkWidget* btn, FindFile* data )
 {
-    char** argv;
+    VFSSearchCriteria crit;
     GError* err = NULL;
-    int stdo, stde;
-    char* cmd_line;
+    GdkCursor* busy_cursor;
     GtkAllocation allocation;
 
+    compose_criteria( data, &crit );
+    data->search = vfs_search_new( &crit, (VFSSearchFoundCallback)on_search_found,
+                                   data, &err );
+    g_strfreev( crit.dirs );
+    if( !data->search )
+    {
+        ptk_show_error( GTK_WINDOW( data->win ), _("Invalid Regular Expression"),
+                        err->message );
+        g_error_free( err );
+        return;
+    }
+
     gtk_widget_get_allocation ( GTK_WIDGET( data->win ), &allocation );
     int width =  allocation.width;
     int height = allocation.height;
     if ( width && height )
     {
         char* str = g_strdup_printf( "%d", width );
-        xset_set( "main_search", "x", str );
+        xset_set( "main_search", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "main_search", "y", str );
+        xset_set( "main_search", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -682,37 +723,23 @@ static void on_start_search( GtkWidget* btn, FindFile* data )
     gtk_widget_hide( btn );
     gtk_widget_show( data->stop_btn );
 
-    argv = compose_command( data );
-
-    cmd_line = g_strjoinv( " ", argv );
-    g_debug( "find command: %s", cmd_line );
-    g_free( cmd_line );
-    if( g_spawn_async_with_pipes( g_get_home_dir(), argv, NULL,
-                                                  G_SPAWN_SEARCH_PATH | G_SPAWN_STDERR_TO_DEV_NULL,
-                                                  NULL, NULL, &data->pid,
-                                                  NULL, &data->stdo, NULL, &err ) )
-    {
-        GdkCursor* busy_cursor;
-        data->task = vfs_async_task_new( (VFSAsyncFunc)search_thread, data );
-        g_signal_connect( data->task, "finish", G_CALLBACK( on_search_finish ), data );
-        vfs_async_task_execute( data->task );
-
-        busy_cursor = gdk_cursor_new( GDK_WATCH );
-        gdk_window_set_cursor( gtk_widget_get_window (data->search_result), busy_cursor );
-        gdk_cursor_unref( busy_cursor );
-    }
-    else
-    {
-        g_error_free( err );
-    }
+    data->task = vfs_async_task_new( (VFSAsyncFunc)search_thread, data );
+    if ( !data->update_timeout )
+        data->update_timeout = g_timeout_add( RESULT_UPDATE_INTERVAL,
+                                        (GSourceFunc)on_result_update, data );
+    g_signal_connect( data->task, "finish", G_CALLBACK( on_search_finish ), data );
+    vfs_async_task_execute( data->task );
 
-    g_strfreev( argv );
+    busy_cursor = gdk_cursor_new( GDK_WATCH );
+    gdk_window_set_cursor( gtk_widget_get_window (data->search_result), busy_cursor );
+    gdk_cursor_unref( busy_cursor );
 }
 
 static void on_stop_search( GtkWidget* btn, FindFile* data )
 {
     if( data->task && ! vfs_async_task_is_finished( data->task ) )
     {
+        vfs_search_cancel( data->search );
         // see note in vfs-async-task.c: vfs_async_task_real_cancel()
         GDK_THREADS_LEAVE(); 
         vfs_async_task_cancel( data->task );
@@ -730,10 +757,10 @@ static void on_search_again( GtkWidget* btn, FindFile* data )
     if ( width && height )
     {
         char* str = g_strdup_printf( "%d", width );
-        xset_set( "main_search", "x", str );
+        xset_set( "main_search", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "main_search", "y", str );
+        xset_set( "main_search", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -743,9 +770,10 @@ static void on_search_again( GtkWidget* btn, FindFile* data )
     gtk_widget_hide( btn );
     gtk_widget_show( data->start_btn );
 
+    clear_found_files( data );
     g_object_ref( data->result_list );
     gtk_tree_view_set_model( (GtkTreeView*)data->result_view, NULL );
-    gtk_list_store_clear( data->result_list );
+    result_list_clear( data->result_list );
     gtk_tree_view_set_model( (GtkTreeView*)data->result_view, GTK_TREE_MODEL( data->result_list ) );
     g_object_unref( data->result_list );
 }
@@ -880,6 +908,21 @@ static void on_date_limit_changed( GtkWidget* date_limit, FindFile* data )
 
 static void free_data( FindFile* data )
 {
+    /* the window is gone - stop the search without touching it */
+    if( data->task )
+    {
+        g_signal_handlers_disconnect_by_func( data->task, on_search_finish, data );
+        vfs_search_cancel( data->search );
+        vfs_async_task_cancel( data->task );
+        g_object_unref( data->task );
+    }
+    if( data->search )
+        vfs_search_free( data->search );
+    clear_found_files( data );
+    g_queue_free( data->found );
+    g_mutex_free( data->found_mutex );
+    if( data->result_list )
+        g_object_unref( data->result_list );
     g_slice_free( FindFile, data );
 }
 
@@ -891,17 +934,11 @@ static void init_search_result( FindFile* data )
 
     gtk_tree_selection_set_mode( gtk_tree_view_get_selection((GtkTreeView*)data->result_view),
                                                  GTK_SELECTION_MULTIPLE );
-    data->result_list = gtk_list_store_new( N_RES_COLS,
-                                                            GDK_TYPE_PIXBUF, /* icon */
-                                                            G_TYPE_STRING,  /* name */
-                                                            G_TYPE_STRING, /* dir */
-                                                            G_TYPE_STRING,  /* type */
-                                                            G_TYPE_STRING,  /* size */
-                                                            G_TYPE_STRING, /* mtime */
-                                                            G_TYPE_POINTER /* VFSFileInfo */ );
+    /* kept until free_data(), as results may still be added after the view
+     * is gone */
+    data->result_list = (ResultList*)g_object_new( result_list_get_type(), NULL );
 
     gtk_tree_view_set_model( (GtkTreeView*)data->result_view, (GtkTreeModel*)data->result_list );
-    g_object_unref( data->result_list );
     col = gtk_tree_view_column_new();
     gtk_tree_view_column_set_title( col, _("Name") );
     render = gtk_cell_renderer_pixbuf_new();
@@ -912,6 +949,8 @@ static void init_search_result( FindFile* data )
     gtk_tree_view_column_pack_start( col, render, TRUE );
     gtk_tree_view_column_set_attributes( col, render, "text", COL_NAME, NULL );
     gtk_tree_view_column_set_expand ( col, TRUE );
+    gtk_tree_view_column_set_sizing( col, GTK_TREE_VIEW_COLUMN_FIXED );
+    gtk_tree_view_column_set_fixed_width ( col, 200 );
     gtk_tree_view_column_set_min_width( col, 200 );
     gtk_tree_view_column_set_resizable ( col, TRUE );
     gtk_tree_view_append_column( (GtkTreeView*)data->result_view, col );
@@ -920,11 +959,15 @@ static void init_search_result( FindFile* data )
     g_object_set( render, "ellipsize", PANGO_ELLIPSIZE_END, NULL );
     col = gtk_tree_view_column_new_with_attributes( _("Folder"), render, "text", COL_DIR, NULL );
     gtk_tree_view_column_set_expand ( col, TRUE );
+    gtk_tree_view_column_set_sizing( col, GTK_TREE_VIEW_COLUMN_FIXED );
+    gtk_tree_view_column_set_fixed_width ( col, 200 );
     gtk_tree_view_column_set_resizable ( col, TRUE );
     gtk_tree_view_column_set_min_width( col, 200 );
     gtk_tree_view_append_column( (GtkTreeView*)data->result_view, col );
 
     col = gtk_tree_view_column_new_with_attributes( _("Size"), gtk_cell_renderer_text_new(), "text", COL_SIZE, NULL );
+    gtk_tree_view_column_set_sizing( col, GTK_TREE_VIEW_COLUMN_FIXED );
+    gtk_tree_view_column_set_fixed_width ( col, 80 );
     gtk_tree_view_column_set_resizable ( col, TRUE );
     gtk_tree_view_append_column( (GtkTreeView*)data->result_view, col );
 
@@ -935,8 +978,14 @@ static void init_search_result( FindFile* data )
     gtk_tree_view_append_column( (GtkTreeView*)data->result_view, col );
 
     col = gtk_tree_view_column_new_with_attributes( _("Last Modified"), gtk_cell_renderer_text_new(), "text", COL_MTIME, NULL );
+    gtk_tree_view_column_set_sizing( col, GTK_TREE_VIEW_COLUMN_FIXED );
+    gtk_tree_view_column_set_fixed_width ( col, 140 );
     gtk_tree_view_column_set_resizable ( col, TRUE );
     gtk_tree_view_append_column( (GtkTreeView*)data->result_view, col );
+
+    /* only ask the model for the rows being shown, so the icons and types
+     * of the others are never looked up */
+    gtk_tree_view_set_fixed_height_mode( (GtkTreeView*)data->result_view, TRUE );
 }
 
 static gboolean on_view_button_press( GtkTreeView* view, GdkEventButton* evt, FindFile* data )
@@ -1025,6 +1074,8 @@ void fm_find_files( const char** search_dirs )
     GtkBuilder* builder = _gtk_builder_new_from_file( PACKAGE_UI_DIR "/find-files.ui", NULL );
 #endif
     data->win = (GtkWidget*)gtk_builder_get_object( builder, "win" );
+    data->found_mutex = g_mutex_new();
+    data->found = g_queue_new();
     g_object_set_data_full( G_OBJECT( data->win ), "find-files", data, (GDestroyNotify)free_data );
 
     GdkPixbuf* icon = NULL;
@@ -1148,8 +1199,8 @@ void fm_find_files( const char** search_dirs )
     pcmanfm_ref();
     g_signal_connect( data->win, "destroy", G_CALLBACK(pcmanfm_unref), NULL );
 
-    int width = xset_get_int( "main_search", "x" );
-    int height = xset_get_int( "main_search", "y" );
+    int width = xset_get_int( "main_search", XSET_VAR_X );
+    int height = xset_get_int( "main_search", XSET_VAR_Y );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( data->win ), width, height );
     
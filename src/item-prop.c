@@ -1604,8 +1604,8 @@ void xset_item_prop_dlg( XSetContext* context, XSet* set, int page )
     xset_set_window_icon( GTK_WINDOW( ctxt->dlg ) );
     gtk_window_set_role( GTK_WINDOW( ctxt->dlg ), "context_dialog" );
 
-    int width = xset_get_int( "context_dlg", "x" );
-    int height = xset_get_int( "context_dlg", "y" );
+    int width = xset_get_int( "context_dlg", XSET_VAR_X );
+    int height = xset_get_int( "context_dlg", XSET_VAR_Y );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( ctxt->dlg ), width, height );
     else
@@ -2519,10 +2519,10 @@ void xset_item_prop_dlg( XSetContext* context, XSet* set, int page )
     if ( width && height )
     {
         str = g_strdup_printf( "%d", width );
-        xset_set( "context_dlg", "x", str );
+        xset_set( "context_dlg", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "context_dlg", "y", str );
+        xset_set( "context_dlg", XSET_VAR_Y, str );
         g_free( str );
     }
 
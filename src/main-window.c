@@ -2218,13 +2218,13 @@ void fm_main_window_init( FMMainWindow* main_window )
     // restore panel sliders
     // do this after maximizing/showing window so slider positions are valid
     // in actual window size
-    int pos = xset_get_int( "panel_sliders", "x" );
+    int pos = xset_get_int( "panel_sliders", XSET_VAR_X );
     if ( pos < 200 ) pos = 200;
     gtk_paned_set_position( GTK_PANED( main_window->hpane_top ), pos );
-    pos = xset_get_int( "panel_sliders", "y" );
+    pos = xset_get_int( "panel_sliders", XSET_VAR_Y );
     if ( pos < 200 ) pos = 200;
     gtk_paned_set_position( GTK_PANED( main_window->hpane_bottom ), pos );
-    pos = xset_get_int( "panel_sliders", "s" );
+    pos = xset_get_int( "panel_sliders", XSET_VAR_S );
     if ( pos < 200 ) pos = -1;
     gtk_paned_set_position( GTK_PANED( main_window->vpane ), pos );
 
@@ -2313,7 +2313,7 @@ void fm_main_window_store_positions( FMMainWindow* main_window )
             if ( pos )
             {
                 posa = g_strdup_printf( "%d", pos );
-                xset_set( "panel_sliders", "x", posa );
+                xset_set( "panel_sliders", XSET_VAR_X, posa );
                 g_free( posa );
             }
             
@@ -2321,7 +2321,7 @@ void fm_main_window_store_positions( FMMainWindow* main_window )
             if ( pos )
             {
                 posa = g_strdup_printf( "%d", pos );
-                xset_set( "panel_sliders", "y", posa );
+                xset_set( "panel_sliders", XSET_VAR_Y, posa );
                 g_free( posa );
             }
             
@@ -2329,7 +2329,7 @@ void fm_main_window_store_positions( FMMainWindow* main_window )
             if ( pos )
             {
                 posa = g_strdup_printf( "%d", pos );
-                xset_set( "panel_sliders", "s", posa );
+                xset_set( "panel_sliders", XSET_VAR_S, posa );
                 g_free( posa );
             }
             if ( gtk_widget_get_visible( main_window->task_scroll ) )
@@ -2339,11 +2339,11 @@ void fm_main_window_store_positions( FMMainWindow* main_window )
                 {
                     // save slider pos for version < 0.9.2 (in case of downgrade)
                     posa = g_strdup_printf( "%d", pos );
-                    xset_set( "panel_sliders", "z", posa );
+                    xset_set( "panel_sliders", XSET_VAR_Z, posa );
                     g_free( posa );
                     // save absolute height introduced v0.9.2
                     posa = g_strdup_printf( "%d", allocation.height - pos );
-                    xset_set( "task_show_manager", "x", posa );
+                    xset_set( "task_show_manager", XSET_VAR_X, posa );
                     g_free( posa );
 //printf("CLOS  win %dx%d    task height %d   slider %d\n", allocation.width, allocation.height, allocation.height - pos, pos );
                 }
@@ -3020,9 +3020,9 @@ void fm_main_window_add_new_tab( FMMainWindow* main_window,
                     app_settings.show_thumbnail ? app_settings.max_thumb_size : 0 );
 
     ptk_file_browser_set_sort_order( file_browser, 
-            xset_get_int_panel( file_browser->mypanel, "list_detailed", "x" ) );
+            xset_get_int_panel( file_browser->mypanel, "list_detailed", XSET_VAR_X ) );
     ptk_file_browser_set_sort_type( file_browser,
-            xset_get_int_panel( file_browser->mypanel, "list_detailed", "y" ) );
+            xset_get_int_panel( file_browser->mypanel, "list_detailed", XSET_VAR_Y ) );
 
     gtk_widget_show( GTK_WIDGET( file_browser ) );
 
@@ -5108,7 +5108,7 @@ void on_task_columns_changed( GtkWidget *view, gpointer user_data )
             set = xset_get( task_names[j] );
             // save column position
             pos = g_strdup_printf( "%d", i );
-            xset_set_set( set, "x", pos );
+            xset_set_set( set, XSET_VAR_X, pos );
             g_free( pos );
             // if the window was opened maximized and stayed maximized, or the
             // window is unmaximized and not fullscreen, save the columns
@@ -5120,7 +5120,7 @@ void on_task_columns_changed( GtkWidget *view, gpointer user_data )
                 {
                     // save column width
                     pos = g_strdup_printf( "%d", width );
-                    xset_set_set( set, "y", pos );
+                    xset_set_set( set, XSET_VAR_Y, pos );
                     g_free( pos );
                 }
             }
@@ -5368,11 +5368,11 @@ static gboolean idle_set_task_height( FMMainWindow* main_window )
     }
 
     // restore height (in case window height changed)
-    taskh = xset_get_int( "task_show_manager", "x" ); // task height >=0.9.2
+    taskh = xset_get_int( "task_show_manager", XSET_VAR_X ); // task height >=0.9.2
     if ( taskh == 0 )
     {
         // use pre-0.9.2 slider pos to calculate height
-        pos = xset_get_int( "panel_sliders", "z" );       // < 0.9.2 slider pos
+        pos = xset_get_int( "panel_sliders", XSET_VAR_Z );       // < 0.9.2 slider pos
         if ( pos == 0 )
             taskh = 200;
         else
@@ -5414,11 +5414,11 @@ void show_task_manager( FMMainWindow* main_window, gboolean show )
             {
                 // save slider pos for version < 0.9.2 (in case of downgrade)
                 char* posa = g_strdup_printf( "%d", pos );
-                xset_set( "panel_sliders", "z", posa );
+                xset_set( "panel_sliders", XSET_VAR_Z, posa );
                 g_free( posa );
                 // save absolute height introduced v0.9.2
                 posa = g_strdup_printf( "%d", allocation.height - pos );
-                xset_set( "task_show_manager", "x", posa );
+                xset_set( "task_show_manager", XSET_VAR_X, posa );
                 g_free( posa );
 //printf("HIDE  win %dx%d    task height %d   slider %d\n", allocation.width, allocation.height, allocation.height - pos, pos );
             }
@@ -6129,7 +6129,7 @@ GtkWidget* main_task_view_new( FMMainWindow* main_window )
         // column order
         for ( j = 0; j < 13; j++ )
         {
-            if ( xset_get_int( task_names[j], "x" ) == i )
+            if ( xset_get_int( task_names[j], XSET_VAR_X ) == i )
                 break;
         }
         if ( j == 13 )
@@ -6137,7 +6137,7 @@ GtkWidget* main_task_view_new( FMMainWindow* main_window )
         else
         {
             // column width
-            width = xset_get_int( task_names[j], "y" );
+            width = xset_get_int( task_names[j], XSET_VAR_Y );
             if ( width == 0 )
                 width = 80;
             gtk_tree_view_column_set_fixed_width ( col, width );
@@ -7162,15 +7162,15 @@ _invalid_set:
                 *reply = g_strdup_printf( "%d\n",
                         xset_get_b_panel( file_browser->mypanel, "sort_extra" ) &&
                         xset_get_int_panel( file_browser->mypanel, "sort_extra",
-                                              "x" ) == XSET_B_TRUE ? 1 : 0 );
+                                              XSET_VAR_X ) == XSET_B_TRUE ? 1 : 0 );
             else if ( !strcmp( argv[i] + 5, "hidden_first" ) )
                 *reply = g_strdup_printf( "%d\n",
                         xset_get_int_panel( file_browser->mypanel, "sort_extra",
-                                              "z" ) == XSET_B_TRUE ? 1 : 0 );
+                                              XSET_VAR_Z ) == XSET_B_TRUE ? 1 : 0 );
             else if ( !strcmp( argv[i] + 5, "first" ) )
             {
                 switch ( xset_get_int_panel( file_browser->mypanel, "sort_extra",
-                                                                        "y" ) ) {
+                                                                        XSET_VAR_Y ) ) {
                     case 0:
                         str = "mixed";
                         break;
@@ -64,6 +64,172 @@
 #define    MAGIC_LIST    24
 #define    NAMESPACE_LIST    28
 
+/* magic list entries */
+#define    MAGIC_ENTRY_SIZE    16
+#define    MAGIC_RULE_SIZE    32
+#define    MAGIC_MAX_DEPTH    32
+
+/*
+ * The magic rules of a cache are decoded once at load, so sniffing a file
+ * doesn't byte swap and follow offsets in the cache for every rule.
+ * All rules are in one array, with the children of a rule consecutive.
+ */
+typedef struct
+{
+    guint32 offset;
+    guint32 range;
+    guint32 val_len;
+    const guchar* value;
+    const guchar* mask;     /* NULL for a plain comparison */
+    guint32 n_children;
+    guint32 first_child;
+} MagicRule;
+
+typedef struct
+{
+    const char* type;
+    guint32 n_rules;
+    guint32 first_rule;
+    /* bitmap of the values of data[0] the magic can match with */
+    guint32 first_bytes[ 8 ];
+} MagicEntry;
+
+static gboolean in_cache( MimeCache* cache, guint32 off, guint64 len )
+{
+    return off <= cache->size && len <= cache->size - off;
+}
+
+/* Count the rules in a (sub)tree, or return FALSE if it runs off the cache.
+ * Children may point back at rules already counted, so a cache can't have
+ * more rules than fit in it - a crafted one would count forever or wrap. */
+static gboolean count_magic_rules( MimeCache* cache, guint32 off, guint32 n,
+                                   int depth, guint32* count )
+{
+    const char* buffer = cache->buffer;
+    guint32 i;
+
+    if( depth > MAGIC_MAX_DEPTH || ! in_cache( cache, off, (guint64)n * MAGIC_RULE_SIZE ) )
+        return FALSE;
+    if( n > cache->size / MAGIC_RULE_SIZE - *count )
+        return FALSE;
+    *count += n;
+    for( i = 0; i < n; ++i, off += MAGIC_RULE_SIZE )
+    {
+        if( ! count_magic_rules( cache, VAL32( buffer, off + 28 ),
+                                 VAL32( buffer, off + 24 ), depth + 1, count ) )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Decode n rules at off and their children into rules[ *next ... ], which
+ * holds n_rules.  Returns the index of the first */
+static guint32 decode_magic_rules( MimeCache* cache, guint32 off, guint32 n,
+                                   MagicRule* rules, guint32 n_rules,
+                                   guint32* next )
+{
+    const char* buffer = cache->buffer;
+    guint32 first = *next;
+    guint32 i;
+
+    if( G_UNLIKELY( n > n_rules - *next ) )
+        return first;   /* can't happen after count_magic_rules() */
+    *next += n;
+    for( i = 0; i < n; ++i, off += MAGIC_RULE_SIZE )
+    {
+        MagicRule* rule = &rules[ first + i ];
+        guint32 val_off = VAL32( buffer, off + 16 );
+        guint32 mask_off = VAL32( buffer, off + 20 );
+
+        rule->offset = VAL32( buffer, off );
+        rule->range = VAL32( buffer, off + 4 );
+        rule->val_len = VAL32( buffer, off + 12 );
+        rule->value = (const guchar*)buffer + val_off;
+        rule->mask = mask_off ? (const guchar*)buffer + mask_off : NULL;
+        if( ! in_cache( cache, val_off, rule->val_len ) ||
+                ( mask_off && ! in_cache( cache, mask_off, rule->val_len ) ) )
+            rule->range = 0;    /* broken - never matches */
+        rule->n_children = VAL32( buffer, off + 24 );
+        if( rule->n_children > n_rules - *next )
+        {
+            rule->n_children = 0;
+            rule->range = 0;
+        }
+        rule->first_child = decode_magic_rules( cache, VAL32( buffer, off + 28 ),
+                                                rule->n_children, rules,
+                                                n_rules, next );
+    }
+    return first;
+}
+
+/* Which first bytes a magic can match: if each of its rules compares a
+ * value at offset 0 only, data[0] has to fit the first byte of one */
+static void get_magic_first_bytes( MagicEntry* entry, const MagicRule* rules )
+{
+    guint32 i;
+    int b;
+
+    memset( entry->first_bytes, 0, sizeof( entry->first_bytes ) );
+    for( i = 0; i < entry->n_rules; ++i )
+    {
+        const MagicRule* rule = &rules[ entry->first_rule + i ];
+        if( rule->offset != 0 || rule->range != 1 || rule->val_len == 0 )
+        {
+            memset( entry->first_bytes, 0xff, sizeof( entry->first_bytes ) );
+            return;
+        }
+        for( b = 0; b < 256; ++b )
+        {
+            guchar masked = rule->mask ? ( b & rule->mask[0] ) : b;
+            if( masked == rule->value[0] )
+                entry->first_bytes[ b >> 5 ] |= 1u << ( b & 31 );
+        }
+    }
+}
+
+static void compile_magics( MimeCache* cache )
+{
+    const char* buffer = cache->buffer;
+    guint32 off = cache->magics - buffer;
+    guint32 n_rules = 0, next = 0;
+    MagicEntry* entries;
+    MagicRule* rules;
+    guint32 i;
+
+    if( ! in_cache( cache, off, (guint64)cache->n_magics * MAGIC_ENTRY_SIZE ) )
+    {
+        cache->n_magics = 0;
+        return;
+    }
+    for( i = 0; i < cache->n_magics; ++i )
+    {
+        guint32 m = off + i * MAGIC_ENTRY_SIZE;
+        if( ! count_magic_rules( cache, VAL32( buffer, m + 12 ),
+                                 VAL32( buffer, m + 8 ), 0, &n_rules ) )
+        {
+            cache->n_magics = 0;
+            return;
+        }
+    }
+
+    entries = g_new( MagicEntry, cache->n_magics );
+    rules = g_new( MagicRule, n_rules + 1 );
+    for( i = 0; i < cache->n_magics; ++i )
+    {
+        guint32 m = off + i * MAGIC_ENTRY_SIZE;
+        entries[i].type = buffer + VAL32( buffer, m + 4 );
+        entries[i].n_rules = VAL32( buffer, m + 8 );
+        if( entries[i].n_rules > n_rules - next )
+            entries[i].n_rules = 0;
+        entries[i].first_rule = decode_magic_rules( cache, VAL32( buffer, m + 12 ),
+                                                    entries[i].n_rules, rules,
+                                                    n_rules, &next );
+        get_magic_first_bytes( &entries[i], rules );
+    }
+    cache->magic_entries = entries;
+    cache->magic_rules = rules;
+}
+
 MimeCache* mime_cache_new( const char* file_path )
 {
     MimeCache* cache = NULL;
@@ -83,6 +249,8 @@ static void mime_cache_unload( MimeCache* cache, gboolean clear )
         g_free( cache->buffer );
 #endif
     }
+    g_free( cache->magic_entries );
+    g_free( cache->magic_rules );
     g_free( cache->file_path );
     if( clear )
         memset( cache, 0, sizeof(MimeCache) );
@@ -186,92 +354,118 @@ gboolean mime_cache_load( MimeCache* cache, const char* file_path )
     cache->n_magics = VAL32( buffer, offset );
     cache->magic_max_extent = VAL32( buffer + offset, 4 );
     cache->magics = buffer + VAL32( buffer + offset, 8 );
+    compile_magics( cache );
 
     return TRUE;
 }
 
-static gboolean magic_rule_match( const char* buf, const char* rule, const char* data, int len )
+static gboolean masked_equal( const guchar* data, const guchar* value,
+                              const guchar* mask, guint32 len )
 {
-    gboolean match = FALSE;
-    guint32 offset = VAL32( rule, 0 );
-    guint32 range = VAL32( rule, 4 );
-
-    guint32 max_offset = offset + range;
-    guint32 val_len = VAL32( rule, 12 );
+    guint32 i = 0;
 
-    for( ; offset < max_offset && (offset + val_len) <= len ; ++offset )
+    /* eight bytes at a time */
+    for( ; i + 8 <= len; i += 8 )
     {
-        guint32 val_off = VAL32( rule, 16 );
-        guint32 mask_off = VAL32( rule, 20 );
-        const char* value = buf + val_off;
-        /* FIXME: word_size and byte order are not supported! */
+        guint64 d, v, m;
+        memcpy( &d, data + i, 8 );
+        memcpy( &v, value + i, 8 );
+        memcpy( &m, mask + i, 8 );
+        if( ( d & m ) != v )
+            return FALSE;
+    }
+    for( ; i < len; ++i )
+    {
+        if( ( data[i] & mask[i] ) != value[i] )
+            return FALSE;
+    }
+    return TRUE;
+}
 
-        if( G_UNLIKELY( mask_off > 0 ) )    /* compare with mask applied */
-        {
-            int i = 0;
-            const char* mask = buf + mask_off;
+/* First offset in [offset, end) where the rule's value is found, or
+ * G_MAXUINT32.  Unmasked values are located with memchr() and memcmp(),
+ * which libc vectorizes. */
+static guint32 find_rule_value( const MagicRule* rule, const guchar* data,
+                                guint32 offset, guint32 end )
+{
+    /* an empty range marks a broken rule, and an empty value never matched */
+    if( offset >= end || G_UNLIKELY( rule->val_len == 0 ) )
+        return G_MAXUINT32;
 
-            for( ; i < val_len; ++i )
-            {
-                if( (data[offset + i] & mask[i]) != value[i] )
-                    break;
-            }
-            if( i >= val_len )
-                match = TRUE;
-        }
-        else    /* direct comparison */
+    if( ! rule->mask )
+    {
+        guchar first = rule->value[0];
+        while( offset < end )
         {
-            if( 0 == memcmp( value, data + offset, val_len ) )
-                match = TRUE;
+            const guchar* p = memchr( data + offset, first, end - offset );
+            if( ! p )
+                break;
+            offset = p - data;
+            if( 0 == memcmp( data + offset + 1, rule->value + 1,
+                             rule->val_len - 1 ) )
+                return offset;
+            ++offset;
         }
+        return G_MAXUINT32;
+    }
 
-        if( match )
-        {
-            guint32 n_children = VAL32( rule, 24 );
-            if( n_children > 0 )
-            {
-                guint32 first_child_off = VAL32( rule, 28 );
-                guint i;
-                rule = buf + first_child_off;
-                for( i = 0; i < n_children; ++i, rule += 32 )
-                {
-                    if( magic_rule_match( buf, rule, data, len ) )
-                        return TRUE;
-                }
-            }
-            else
-                return TRUE;
-        }
+    for( ; offset < end; ++offset )
+    {
+        if( masked_equal( data + offset, rule->value, rule->mask,
+                          rule->val_len ) )
+            return offset;
     }
-    return FALSE;
+    return G_MAXUINT32;
 }
 
-static gboolean magic_match( const char* buf, const char* magic, const char* data, int len )
+static gboolean magic_rule_match( const MagicRule* rules, const MagicRule* rule,
+                                  const guchar* data, guint32 len )
 {
-    guint32 n_rules = VAL32( magic, 8 );
-    guint32 rules_off = VAL32( magic, 12 );
-    const char* rule = buf + rules_off;
-    int i;
+    guint64 end;
+    guint32 i;
 
-    for( i = 0; i < n_rules; ++i, rule += 32 )
-        if( magic_rule_match( buf, rule, data, len ) )
+    /* FIXME: word_size and byte order are not supported! */
+    if( rule->val_len > len || rule->offset > len - rule->val_len )
+        return FALSE;
+    /* the value may start anywhere in the range, if it fits in data */
+    end = MIN( (guint64)rule->offset + rule->range,
+               (guint64)len - rule->val_len + 1 );
+    if( G_MAXUINT32 == find_rule_value( rule, data, rule->offset, end ) )
+        return FALSE;
+
+    /* the children don't depend on where the value was found */
+    if( rule->n_children == 0 )
+        return TRUE;
+    for( i = 0; i < rule->n_children; ++i )
+    {
+        if( magic_rule_match( rules, &rules[ rule->first_child + i ],
+                              data, len ) )
             return TRUE;
+    }
     return FALSE;
 }
 
 const char* mime_cache_lookup_magic( MimeCache* cache, const char* data, int len )
 {
-    const char* magic = cache->magics;
+    const MagicEntry* entry = (const MagicEntry*)cache->magic_entries;
+    const MagicRule* rules = (const MagicRule*)cache->magic_rules;
+    guchar first;
     int i;
+    guint32 j;
 
-    if( G_UNLIKELY( ! data || (0 == len) || ! magic ) )
+    if( G_UNLIKELY( ! data || (0 == len) || ! entry ) )
         return NULL;
 
-    for( i = 0; i < cache->n_magics; ++i, magic += 16 )
+    first = (guchar)data[0];
+    for( i = 0; i < cache->n_magics; ++i, ++entry )
     {
-        if( magic_match( cache->buffer, magic, data, len ) )
+        if( ! ( entry->first_bytes[ first >> 5 ] & ( 1u << ( first & 31 ) ) ) )
+            continue;
+        for( j = 0; j < entry->n_rules; ++j )
         {
-            return cache->buffer + VAL32( magic, 4 );
+            if( magic_rule_match( rules, &rules[ entry->first_rule + j ],
+                                  (const guchar*)data, len ) )
+                return entry->type;
         }
     }
     return NULL;
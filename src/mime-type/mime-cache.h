@@ -54,6 +54,8 @@ struct _MimeCache
     guint32 n_magics;
     guint32 magic_max_extent;
     const char* magics;
+    gpointer magic_entries;     /* magics decoded at load, see mime-cache.c */
+    gpointer magic_rules;
 };
 typedef struct _MimeCache MimeCache;
 
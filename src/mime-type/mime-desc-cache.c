@@ -0,0 +1,456 @@
+/*
+ *      mime-desc-cache.c
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "mime-desc-cache.h"
+#include "mime-type.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "glib-mem.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/*
+ * File layout, in host byte order:
+ *   DescHeader
+ *   DescSlot[ n_slots ]    open addressing, linear probing
+ *   strings                nul-terminated, referenced by offset + 1
+ * Every type with an XML file in the database has a slot, so a type
+ * missing from the table has no description at all.
+ * The file is only ever replaced by rename, so a mapped copy stays valid.
+ */
+#define DESC_CACHE_MAGIC "SFMDSC01"
+#define DESC_CACHE_MAX_SLOTS ( 1 << 20 )
+
+typedef struct
+{
+    char magic[ 8 ];
+    guint64 db_stamp;
+    guint32 locale;         /* string offset + 1 */
+    guint32 n_slots;        /* power of 2, at most half used */
+    guint32 strings_offset;
+    guint32 strings_size;
+} DescHeader;
+
+typedef struct
+{
+    guint32 hash;
+    guint32 type;           /* string offsets + 1, 0 if none */
+    guint32 desc;
+    guint32 icon;
+} DescSlot;
+
+/* a type while building */
+typedef struct
+{
+    char* desc;
+    char* icon;
+} DescEntry;
+
+static char* cache_path = NULL;
+static guint64 cache_db_stamp = 0;
+static char* cache_locale = NULL;
+static gboolean cancel_build = FALSE;
+
+static char* map = NULL;
+static gsize map_size = 0;
+static const DescSlot* map_slots = NULL;
+static guint32 map_n_slots = 0;
+static const char* map_strings = NULL;
+static guint32 map_strings_size = 0;
+
+static GThread* build_thread = NULL;
+static gboolean building = FALSE;
+
+G_LOCK_DEFINE_STATIC( desc_cache );
+
+static guint32 desc_hash( const char* type )
+{
+    /* FNV-1a, stable between sessions unlike g_str_hash */
+    guint32 h = 2166136261u;
+    for ( ; *type; ++type )
+        h = ( h ^ (guchar)*type ) * 16777619u;
+    return h;
+}
+
+/* The locale the descriptions are read in, as in mime_type_get_desc_icon() */
+static char* get_locale()
+{
+    const char* const * langs = g_get_language_names();
+    char* dot = strchr( langs[0], '.' );
+    if ( dot )
+        return g_strndup( langs[0], (size_t)( dot - langs[0] ) );
+    return g_strdup( langs[0] );
+}
+
+static const char* map_string( guint32 off )
+{
+    // strings were checked to end with nul on map
+    if ( off == 0 || off > map_strings_size )
+        return NULL;
+    return map_strings + off - 1;
+}
+
+static void desc_cache_unmap()
+{
+    if ( map )
+        munmap( map, map_size );
+    map = NULL;
+    map_size = 0;
+    map_slots = NULL;
+    map_n_slots = 0;
+    map_strings = NULL;
+    map_strings_size = 0;
+}
+
+/* Returns FALSE if the file is missing or was saved for another database
+ * or locale */
+static gboolean desc_cache_map()
+{
+    int fd;
+    struct stat64 st;
+    const DescHeader* hdr;
+    const char* locale;
+
+    fd = open( cache_path, O_RDONLY );
+    if ( fd < 0 )
+        return FALSE;
+    if ( fstat64( fd, &st ) == -1 || st.st_size < sizeof( DescHeader ) ||
+                                     st.st_size > G_MAXUINT32 )
+    {
+        close( fd );
+        return FALSE;
+    }
+    map_size = st.st_size;
+    map = mmap( NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( map == MAP_FAILED )
+    {
+        map = NULL;
+        map_size = 0;
+        return FALSE;
+    }
+
+    hdr = (const DescHeader*)map;
+    if ( memcmp( hdr->magic, DESC_CACHE_MAGIC, sizeof( hdr->magic ) ) ||
+                        hdr->db_stamp != cache_db_stamp ||
+                        hdr->n_slots == 0 ||
+                        ( hdr->n_slots & ( hdr->n_slots - 1 ) ) ||
+                        hdr->n_slots > DESC_CACHE_MAX_SLOTS ||
+                        hdr->strings_offset < sizeof( DescHeader ) +
+                                    (gsize)hdr->n_slots * sizeof( DescSlot ) ||
+                        hdr->strings_size == 0 ||
+                        (gsize)hdr->strings_offset + hdr->strings_size > map_size ||
+                        map[ hdr->strings_offset + hdr->strings_size - 1 ] != '\0' )
+        goto _invalid;
+    map_strings = map + hdr->strings_offset;
+    map_strings_size = hdr->strings_size;
+    locale = map_string( hdr->locale );
+    if ( !locale || strcmp( locale, cache_locale ) )
+        goto _invalid;
+    map_n_slots = hdr->n_slots;
+    map_slots = (const DescSlot*)( map + sizeof( DescHeader ) );
+    return TRUE;
+
+_invalid:
+    desc_cache_unmap();
+    return FALSE;
+}
+
+gboolean mime_desc_cache_lookup( const char* type, char** desc,
+                                 char** icon_name )
+{
+    guint32 hash, mask, i, n;
+    const DescSlot* slot = NULL;
+
+    G_LOCK( desc_cache );
+    if ( !map_slots )
+    {
+        G_UNLOCK( desc_cache );
+        return FALSE;
+    }
+    hash = desc_hash( type );
+    mask = map_n_slots - 1;
+    for ( n = 0, i = hash & mask; n < map_n_slots; ++n, i = ( i + 1 ) & mask )
+    {
+        const char* name;
+        if ( map_slots[ i ].type == 0 )
+            break;
+        if ( map_slots[ i ].hash == hash &&
+                        ( name = map_string( map_slots[ i ].type ) ) &&
+                        !strcmp( name, type ) )
+        {
+            slot = &map_slots[ i ];
+            break;
+        }
+    }
+    *desc = slot ? g_strdup( map_string( slot->desc ) ) : NULL;
+    if ( icon_name )
+        *icon_name = slot ? g_strdup( map_string( slot->icon ) ) : NULL;
+    G_UNLOCK( desc_cache );
+    return TRUE;
+}
+
+static void desc_entry_free( DescEntry* entry )
+{
+    g_free( entry->desc );
+    g_free( entry->icon );
+    g_slice_free( DescEntry, entry );
+}
+
+/* Read <dir>/mime/<media>/<subtype>.xml into entries.  Dirs are read in
+ * order of priority, so the first description found is kept. */
+static void read_mime_dir( GHashTable* entries, const char* data_dir,
+                           const char* locale, gboolean is_local )
+{
+    char* mime_dir = g_build_filename( data_dir, "mime", NULL );
+    GDir* dir = g_dir_open( mime_dir, 0, NULL );
+    const char* media;
+
+    while ( dir && !cancel_build && ( media = g_dir_read_name( dir ) ) )
+    {
+        char* media_dir;
+        GDir* sub;
+        const char* name;
+
+        // packages holds the source XML, not per-type files
+        if ( !strcmp( media, "packages" ) )
+            continue;
+        media_dir = g_build_filename( mime_dir, media, NULL );
+        sub = g_dir_open( media_dir, 0, NULL );
+        while ( sub && ( name = g_dir_read_name( sub ) ) )
+        {
+            char* type;
+            char* file_path;
+            DescEntry* entry;
+            char* desc;
+            char* icon = NULL;
+
+            if ( !g_str_has_suffix( name, ".xml" ) )
+                continue;
+            type = g_strdup_printf( "%s/%.*s", media,
+                                    (int)( strlen( name ) - 4 ), name );
+            entry = (DescEntry*)g_hash_table_lookup( entries, type );
+            if ( entry && entry->desc )
+            {
+                g_free( type );
+                continue;
+            }
+            file_path = g_build_filename( media_dir, name, NULL );
+            desc = mime_type_read_desc_icon( file_path, locale, is_local,
+                                        entry && entry->icon ? NULL : &icon );
+            g_free( file_path );
+            if ( !entry )
+            {
+                entry = g_slice_new0( DescEntry );
+                g_hash_table_insert( entries, type, entry );
+            }
+            else
+                g_free( type );
+            entry->desc = desc;
+            if ( icon )
+                entry->icon = icon;
+        }
+        if ( sub )
+            g_dir_close( sub );
+        g_free( media_dir );
+    }
+    if ( dir )
+        g_dir_close( dir );
+    g_free( mime_dir );
+}
+
+static guint32 add_string( GString* strings, const char* str )
+{
+    guint32 off;
+    if ( !str )
+        return 0;
+    off = strings->len + 1;
+    g_string_append_len( strings, str, strlen( str ) + 1 );
+    return off;
+}
+
+static void desc_cache_save( GHashTable* entries, guint64 db_stamp,
+                             const char* locale )
+{
+    GHashTableIter it;
+    gpointer key, value;
+    DescHeader hdr;
+    DescSlot* slots;
+    GString* strings;
+    guint32 n_slots;
+    char* dir;
+    char* tmp_path;
+    FILE* file;
+    gboolean ok;
+
+    for ( n_slots = 16; n_slots < g_hash_table_size( entries ) * 2;
+                                                            n_slots <<= 1 );
+    if ( n_slots > DESC_CACHE_MAX_SLOTS )
+        return;
+    slots = g_new0( DescSlot, n_slots );
+    strings = g_string_new( NULL );
+    memcpy( hdr.magic, DESC_CACHE_MAGIC, sizeof( hdr.magic ) );
+    hdr.db_stamp = db_stamp;
+    hdr.locale = add_string( strings, locale );
+    hdr.n_slots = n_slots;
+
+    g_hash_table_iter_init( &it, entries );
+    while ( g_hash_table_iter_next( &it, &key, &value ) )
+    {
+        DescEntry* entry = (DescEntry*)value;
+        guint32 hash = desc_hash( (char*)key );
+        guint32 i = hash & ( n_slots - 1 );
+
+        while ( slots[ i ].type )
+            i = ( i + 1 ) & ( n_slots - 1 );
+        slots[ i ].hash = hash;
+        slots[ i ].type = add_string( strings, (char*)key );
+        slots[ i ].desc = add_string( strings, entry->desc );
+        slots[ i ].icon = add_string( strings, entry->icon );
+    }
+    hdr.strings_offset = sizeof( DescHeader ) + n_slots * sizeof( DescSlot );
+    hdr.strings_size = strings->len;
+
+    dir = g_path_get_dirname( cache_path );
+    g_mkdir_with_parents( dir, 0700 );
+    g_free( dir );
+    tmp_path = g_strdup_printf( "%s.%d", cache_path, getpid() );
+    ok = FALSE;
+    if ( ( file = fopen( tmp_path, "w" ) ) )
+    {
+        ok = fwrite( &hdr, sizeof( hdr ), 1, file ) == 1 &&
+             fwrite( slots, sizeof( DescSlot ), n_slots, file ) == n_slots &&
+             fwrite( strings->str, 1, strings->len, file ) == strings->len;
+        ok = ( fclose( file ) == 0 ) && ok;
+    }
+    if ( !ok || rename( tmp_path, cache_path ) == -1 )
+        unlink( tmp_path );
+    g_free( tmp_path );
+
+    g_string_free( strings, TRUE );
+    g_free( slots );
+}
+
+static gpointer desc_cache_build( gpointer user_data )
+{
+    GHashTable* entries;
+    const gchar* const * dir;
+    guint64 db_stamp;
+    char* locale;
+
+    G_LOCK( desc_cache );
+    while ( !cancel_build )
+    {
+        db_stamp = cache_db_stamp;
+        locale = g_strdup( cache_locale );
+        G_UNLOCK( desc_cache );
+
+        entries = g_hash_table_new_full( g_str_hash, g_str_equal, g_free,
+                                         (GDestroyNotify)desc_entry_free );
+        read_mime_dir( entries, g_get_user_data_dir(), locale, TRUE );
+        for ( dir = g_get_system_data_dirs(); *dir && !cancel_build; ++dir )
+            read_mime_dir( entries, *dir, locale, FALSE );
+        if ( !cancel_build )
+            desc_cache_save( entries, db_stamp, locale );
+        g_hash_table_destroy( entries );
+        g_free( locale );
+
+        G_LOCK( desc_cache );
+        // build again if the database changed meanwhile
+        if ( !cancel_build && db_stamp == cache_db_stamp )
+        {
+            desc_cache_map();
+            break;
+        }
+    }
+    building = FALSE;
+    G_UNLOCK( desc_cache );
+    return NULL;
+}
+
+/* called with the lock held */
+static void desc_cache_start_build()
+{
+    if ( building )
+        return;     // it notices the new stamp when done
+    if ( build_thread )
+        g_thread_join( build_thread );  // finished, but not joined yet
+    building = TRUE;
+    build_thread = g_thread_create( desc_cache_build, NULL, TRUE, NULL );
+    if ( !build_thread )
+        building = FALSE;
+}
+
+void mime_desc_cache_init( const char* path, guint64 db_stamp )
+{
+    G_LOCK( desc_cache );
+    if ( !cache_path )
+    {
+        cache_path = g_strdup( path );
+        cache_db_stamp = db_stamp;
+        cache_locale = get_locale();
+        cancel_build = FALSE;
+        if ( !desc_cache_map() )
+            desc_cache_start_build();
+    }
+    G_UNLOCK( desc_cache );
+}
+
+void mime_desc_cache_clear( guint64 db_stamp )
+{
+    G_LOCK( desc_cache );
+    if ( cache_path )
+    {
+        desc_cache_unmap();
+        cache_db_stamp = db_stamp;
+        desc_cache_start_build();
+    }
+    G_UNLOCK( desc_cache );
+}
+
+void mime_desc_cache_finalize()
+{
+    GThread* thread;
+
+    G_LOCK( desc_cache );
+    cancel_build = TRUE;
+    thread = build_thread;
+    build_thread = NULL;
+    G_UNLOCK( desc_cache );
+    if ( thread )
+        g_thread_join( thread );
+
+    G_LOCK( desc_cache );
+    desc_cache_unmap();
+    g_free( cache_path );
+    cache_path = NULL;
+    g_free( cache_locale );
+    cache_locale = NULL;
+    G_UNLOCK( desc_cache );
+}
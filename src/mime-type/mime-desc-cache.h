@@ -0,0 +1,47 @@
+/*
+ *      mime-desc-cache.h
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef _MIME_DESC_CACHE_H_INCLUDED_
+#define _MIME_DESC_CACHE_H_INCLUDED_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Descriptions in the current locale and icon names of all mime types,
+ * read once from the XML files of the shared mime database and kept in
+ * file path.  db_stamp identifies the database - the file is rebuilt in
+ * a thread when it was saved for another database or locale.
+ * All functions are MT-safe.
+ */
+void mime_desc_cache_init( const char* path, guint64 db_stamp );
+void mime_desc_cache_finalize();
+
+/* The database changed - rebuild */
+void mime_desc_cache_clear( guint64 db_stamp );
+
+/* Returns FALSE if the cache isn't ready.  Otherwise desc and, if not NULL,
+ * icon_name are set to newly allocated strings, or NULL when the type has
+ * none. */
+gboolean mime_desc_cache_lookup( const char* type, char** desc,
+                                 char** icon_name );
+
+G_END_DECLS
+#endif
@@ -0,0 +1,416 @@
+/*
+ *      mime-glob.c
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "mime-glob.h"
+
+#include <glib.h>
+#include "glib-mem.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <fnmatch.h>
+
+/* handle byte order here */
+#define    VAL32(buffer, idx)    GUINT32_FROM_BE(*(guint32*)(buffer + idx))
+
+/* cache header */
+#define    LITERAL_LIST    12
+#define    SUFFIX_TREE    16
+#define    GLOB_LIST    20
+
+/* entry sizes since mime.cache 1.1 */
+#define    STR_ENTRY_SIZE    12
+#define    SUFFIX_NODE_SIZE    12
+
+#define    MAX_SUFFIX_DEPTH    255
+
+typedef struct
+{
+    const char* type;
+    int cache;
+} LiteralEntry;
+
+/* Reverse suffix tree merged from all caches, flattened breadth first.
+ * The children of a node are consecutive and sorted by ch. */
+typedef struct
+{
+    gunichar ch;
+    guint32 first_child;
+    guint32 n_children;
+    int cache;              /* first cache with this suffix */
+    const char* type;       /* NULL if no suffix ends here */
+} SuffixNode;
+
+typedef struct
+{
+    char* glob;
+    const char* type;
+    int cache;
+    int len;
+    int order;
+    char tail;              /* last byte a match must end with, or 0 */
+} GlobEntry;
+
+struct _MimeGlobs
+{
+    GHashTable* literals;   /* file name => LiteralEntry* */
+    SuffixNode* suffixes;   /* suffixes[0] is the root */
+    guint n_suffixes;
+    GlobEntry* globs;       /* by cache, then longest first */
+    guint n_globs;
+    int n_ref;
+};
+
+/* used while building */
+typedef struct _BuildNode
+{
+    gunichar ch;
+    const char* type;
+    int cache;
+    GSList* children;
+    guint n_children;
+} BuildNode;
+
+/* Type names outlive the caches and matchers they came from */
+static GHashTable* type_names = NULL;
+G_LOCK_DEFINE_STATIC( type_names );
+
+static const char* intern_type( const char* type )
+{
+    char* name;
+
+    G_LOCK( type_names );
+    if ( G_UNLIKELY( !type_names ) )
+        type_names = g_hash_table_new( g_str_hash, g_str_equal );
+    name = (char*)g_hash_table_lookup( type_names, type );
+    if ( !name )
+    {
+        name = g_strdup( type );
+        g_hash_table_insert( type_names, name, name );
+    }
+    G_UNLOCK( type_names );
+    return name;
+}
+
+/* offset and count of a list in the cache, checked against its size */
+static gboolean get_list( MimeCache* cache, guint32 off, guint32 n,
+                          guint32 entry_size )
+{
+    return off <= cache->size &&
+           (guint64)n * entry_size <= cache->size - off;
+}
+
+static void add_literals( MimeGlobs* globs, MimeCache* cache, int idx )
+{
+    const char* entry = cache->literals;
+    guint32 i;
+
+    if ( !get_list( cache, entry - cache->buffer, cache->n_literals,
+                                                    STR_ENTRY_SIZE ) )
+        return;
+    for ( i = 0; i < cache->n_literals; ++i, entry += STR_ENTRY_SIZE )
+    {
+        const char* name = cache->buffer + VAL32( entry, 0 );
+        LiteralEntry* lit;
+
+        // an earlier cache takes priority
+        if ( g_hash_table_lookup( globs->literals, name ) )
+            continue;
+        lit = g_slice_new( LiteralEntry );
+        lit->type = intern_type( cache->buffer + VAL32( entry, 4 ) );
+        lit->cache = idx;
+        g_hash_table_insert( globs->literals, g_strdup( name ), lit );
+    }
+}
+
+static void add_globs( GArray* globs, MimeCache* cache, int idx )
+{
+    const char* entry = cache->globs;
+    guint32 i;
+
+    if ( !get_list( cache, entry - cache->buffer, cache->n_globs,
+                                                    STR_ENTRY_SIZE ) )
+        return;
+    for ( i = 0; i < cache->n_globs; ++i, entry += STR_ENTRY_SIZE )
+    {
+        GlobEntry glob;
+        char last;
+
+        glob.glob = g_strdup( cache->buffer + VAL32( entry, 0 ) );
+        glob.type = intern_type( cache->buffer + VAL32( entry, 4 ) );
+        glob.cache = idx;
+        glob.len = strlen( glob.glob );
+        glob.order = globs->len;
+        last = glob.len ? glob.glob[ glob.len - 1 ] : 0;
+        glob.tail = strchr( "*?]\\", last ) ? 0 : last;
+        g_array_append_val( globs, glob );
+    }
+}
+
+static int compare_globs( gconstpointer a, gconstpointer b )
+{
+    const GlobEntry* ga = (const GlobEntry*)a;
+    const GlobEntry* gb = (const GlobEntry*)b;
+
+    // the longest glob in the first cache with a match wins
+    if ( ga->cache != gb->cache )
+        return ga->cache - gb->cache;
+    if ( ga->len != gb->len )
+        return gb->len - ga->len;
+    return ga->order - gb->order;
+}
+
+static BuildNode* build_node_child( BuildNode* parent, gunichar ch )
+{
+    GSList* l;
+    BuildNode* child;
+
+    for ( l = parent->children; l; l = l->next )
+    {
+        if ( ( (BuildNode*)l->data )->ch == ch )
+            return (BuildNode*)l->data;
+    }
+    child = g_slice_new0( BuildNode );
+    child->ch = ch;
+    parent->children = g_slist_prepend( parent->children, child );
+    parent->n_children++;
+    return child;
+}
+
+static void build_node_free( BuildNode* node )
+{
+    g_slist_foreach( node->children, (GFunc)build_node_free, NULL );
+    g_slist_free( node->children );
+    g_slice_free( BuildNode, node );
+}
+
+static void add_suffix_nodes( BuildNode* parent, MimeCache* cache, int idx,
+                              const char* nodes, guint32 n, int depth )
+{
+    guint32 i;
+
+    if ( depth > MAX_SUFFIX_DEPTH ||
+         !get_list( cache, nodes - cache->buffer, n, SUFFIX_NODE_SIZE ) )
+        return;
+    for ( i = 0; i < n; ++i, nodes += SUFFIX_NODE_SIZE )
+    {
+        gunichar ch = VAL32( nodes, 0 );
+        if ( ch == 0 )
+        {
+            // leaf - the suffix leading here maps to a type
+            if ( !parent->type )
+            {
+                parent->type = intern_type( cache->buffer + VAL32( nodes, 4 ) );
+                parent->cache = idx;
+            }
+        }
+        else
+            add_suffix_nodes( build_node_child( parent, ch ), cache, idx,
+                              cache->buffer + VAL32( nodes, 8 ),
+                              VAL32( nodes, 4 ), depth + 1 );
+    }
+}
+
+static int compare_build_nodes( gconstpointer a, gconstpointer b )
+{
+    gunichar ca = ( *(BuildNode**)a )->ch;
+    gunichar cb = ( *(BuildNode**)b )->ch;
+    return ca < cb ? -1 : ( ca > cb ? 1 : 0 );
+}
+
+static void flatten_suffixes( MimeGlobs* globs, BuildNode* root )
+{
+    GArray* nodes = g_array_new( FALSE, FALSE, sizeof( SuffixNode ) );
+    GPtrArray* build = g_ptr_array_new();
+    SuffixNode node;
+    guint i;
+
+    node.ch = 0;
+    node.type = root->type;
+    node.cache = root->cache;
+    g_array_append_val( nodes, node );
+    g_ptr_array_add( build, root );
+
+    // breadth first, so each node's children end up next to each other
+    for ( i = 0; i < nodes->len; ++i )
+    {
+        BuildNode* bnode = (BuildNode*)g_ptr_array_index( build, i );
+        BuildNode** children;
+        GSList* l;
+        guint j;
+
+        g_array_index( nodes, SuffixNode, i ).first_child = nodes->len;
+        g_array_index( nodes, SuffixNode, i ).n_children = bnode->n_children;
+
+        children = g_new( BuildNode*, bnode->n_children + 1 );
+        for ( l = bnode->children, j = 0; l; l = l->next, ++j )
+            children[ j ] = (BuildNode*)l->data;
+        qsort( children, bnode->n_children, sizeof( BuildNode* ),
+                                                compare_build_nodes );
+        for ( j = 0; j < bnode->n_children; ++j )
+        {
+            node.ch = children[ j ]->ch;
+            node.type = children[ j ]->type;
+            node.cache = children[ j ]->cache;
+            g_array_append_val( nodes, node );
+            g_ptr_array_add( build, children[ j ] );
+        }
+        g_free( children );
+    }
+
+    globs->n_suffixes = nodes->len;
+    globs->suffixes = (SuffixNode*)g_array_free( nodes, FALSE );
+    g_ptr_array_free( build, TRUE );
+}
+
+static void literal_entry_free( LiteralEntry* lit )
+{
+    g_slice_free( LiteralEntry, lit );
+}
+
+MimeGlobs* mime_globs_new( MimeCache** caches, int n_caches )
+{
+    MimeGlobs* globs;
+    BuildNode* root;
+    GArray* glob_list;
+    int i;
+
+    for ( i = 0; i < n_caches; ++i )
+    {
+        if ( caches[i]->buffer && !caches[i]->has_reverse_suffix )
+            return NULL;
+    }
+
+    globs = g_slice_new0( MimeGlobs );
+    globs->n_ref = 1;
+    globs->literals = g_hash_table_new_full( g_str_hash, g_str_equal, g_free,
+                                    (GDestroyNotify)literal_entry_free );
+    root = g_slice_new0( BuildNode );
+    glob_list = g_array_new( FALSE, FALSE, sizeof( GlobEntry ) );
+
+    for ( i = 0; i < n_caches; ++i )
+    {
+        MimeCache* cache = caches[i];
+        if ( !cache->buffer )
+            continue;
+        add_literals( globs, cache, i );
+        add_suffix_nodes( root, cache, i, cache->suffix_roots,
+                          cache->n_suffix_roots, 0 );
+        add_globs( glob_list, cache, i );
+    }
+
+    flatten_suffixes( globs, root );
+    build_node_free( root );
+
+    g_array_sort( glob_list, compare_globs );
+    globs->n_globs = glob_list->len;
+    globs->globs = (GlobEntry*)g_array_free( glob_list, FALSE );
+    return globs;
+}
+
+MimeGlobs* mime_globs_ref( MimeGlobs* globs )
+{
+    g_atomic_int_inc( &globs->n_ref );
+    return globs;
+}
+
+void mime_globs_unref( MimeGlobs* globs )
+{
+    guint i;
+
+    if ( !g_atomic_int_dec_and_test( &globs->n_ref ) )
+        return;
+    g_hash_table_destroy( globs->literals );
+    g_free( globs->suffixes );
+    for ( i = 0; i < globs->n_globs; ++i )
+        g_free( globs->globs[ i ].glob );
+    g_free( globs->globs );
+    g_slice_free( MimeGlobs, globs );
+}
+
+static const SuffixNode* find_child( MimeGlobs* globs, const SuffixNode* node,
+                                                       gunichar ch )
+{
+    const SuffixNode* children = globs->suffixes + node->first_child;
+    int lower = 0, upper = (int)node->n_children - 1;
+
+    while ( lower <= upper )
+    {
+        int middle = ( lower + upper ) / 2;
+        if ( ch < children[ middle ].ch )
+            upper = middle - 1;
+        else if ( ch > children[ middle ].ch )
+            lower = middle + 1;
+        else
+            return &children[ middle ];
+    }
+    return NULL;
+}
+
+const char* mime_globs_lookup( MimeGlobs* globs, const char* filename )
+{
+    const LiteralEntry* lit;
+    const SuffixNode* node = globs->suffixes;
+    const SuffixNode* best = NULL;
+    const char* p;
+    int len;
+    guint i;
+
+    if ( G_UNLIKELY( !filename || !*filename ) )
+        return NULL;
+
+    /* Each cache is searched for a literal, then a suffix, before the next
+     * cache is tried.  Within a cache the longest suffix wins. */
+    lit = (const LiteralEntry*)g_hash_table_lookup( globs->literals,
+                                                    filename );
+    len = strlen( filename );
+    if ( node->type )
+        best = node;
+    for ( p = filename + len; node->n_children && p > filename; )
+    {
+        p = g_utf8_find_prev_char( filename, p );
+        if ( !p )
+            break;
+        node = find_child( globs, node,
+                           g_unichar_tolower( g_utf8_get_char( p ) ) );
+        if ( !node )
+            break;
+        if ( node->type && ( !best || node->cache <= best->cache ) )
+            best = node;
+    }
+    if ( lit && ( !best || lit->cache <= best->cache ) )
+        return lit->type;
+    if ( best )
+        return best->type;
+
+    // the longest glob in the first cache with a match
+    for ( i = 0; i < globs->n_globs; ++i )
+    {
+        const GlobEntry* glob = &globs->globs[ i ];
+        if ( glob->tail && glob->tail != filename[ len - 1 ] )
+            continue;
+        if ( 0 == fnmatch( glob->glob, filename, 0 ) )
+            return glob->type;
+    }
+    return NULL;
+}
@@ -0,0 +1,47 @@
+/*
+ *      mime-glob.h
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef _MIME_GLOB_H_INCLUDED_
+#define _MIME_GLOB_H_INCLUDED_
+
+#include <glib.h>
+#include "mime-cache.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The literals, suffixes and globs of a set of mime caches compiled into
+ * one matcher.  Lookups give the same result as querying the caches in
+ * order, but don't touch the caches, so a matcher stays usable after its
+ * caches are reloaded.  A matcher is read only once built, so lookups are
+ * MT-safe.
+ */
+typedef struct _MimeGlobs MimeGlobs;
+
+/* Returns NULL if a cache predates mime.cache 1.1 and can't be compiled */
+MimeGlobs* mime_globs_new( MimeCache** caches, int n_caches );
+MimeGlobs* mime_globs_ref( MimeGlobs* globs );
+void mime_globs_unref( MimeGlobs* globs );
+
+/* The mime type of filename, or NULL if no pattern matches.
+ * The returned string is never freed. */
+const char* mime_globs_lookup( MimeGlobs* globs, const char* filename );
+
+G_END_DECLS
+#endif
@@ -0,0 +1,452 @@
+/*
+ *      mime-sniff-cache.c
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // st_mtim
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "mime-sniff-cache.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "glib-mem.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/*
+ * File layout, in host byte order (the cache is never shared between hosts):
+ *   SniffHeader
+ *   SniffRecord[ n_slots ]    open addressing, linear probing
+ *   type names                n_types nul-terminated strings
+ * The file is only ever replaced by rename, so a mapped copy stays valid.
+ */
+#define SNIFF_CACHE_MAGIC "SFMSNF01"
+#define SNIFF_CACHE_MAX 65536   /* records kept, least recently used go first */
+
+typedef struct
+{
+    char magic[ 8 ];
+    guint64 db_stamp;
+    guint32 generation;     /* bumped every session that saves */
+    guint32 n_slots;        /* power of 2, at most half used */
+    guint32 n_types;
+    guint32 types_offset;
+    guint32 types_size;
+    guint32 reserved;
+} SniffHeader;
+
+typedef struct
+{
+    guint64 dev;
+    guint64 ino;
+    gint64 size;
+    gint64 mtime;
+    guint32 mtime_nsec;
+    guint32 mode;
+    guint32 type;           /* index + 1 in the type names, 0 if unused */
+    guint32 generation;     /* session the record was last used in */
+} SniffRecord;
+
+/* a record used in this session */
+typedef struct
+{
+    SniffRecord rec;
+    const char* type;
+} SessionRecord;
+
+static char* cache_path = NULL;
+static guint64 cache_db_stamp = 0;
+static guint32 generation = 1;
+static gboolean dirty = FALSE;
+
+/* the cache saved by the last session */
+static char* map = NULL;
+static gsize map_size = 0;
+static const SniffRecord* map_records = NULL;
+static guint32 map_n_slots = 0;
+static const char** map_types = NULL;
+static guint32 map_n_types = 0;
+
+static GHashTable* session = NULL;     /* SessionRecord* => itself */
+static GHashTable* type_names = NULL;  /* interned, never freed */
+
+G_LOCK_DEFINE_STATIC( sniff_cache );
+
+static void record_init( SniffRecord* rec, const struct stat64* st )
+{
+    memset( rec, 0, sizeof( SniffRecord ) );
+    rec->dev = st->st_dev;
+    rec->ino = st->st_ino;
+    rec->size = st->st_size;
+    rec->mtime = st->st_mtime;
+    rec->mtime_nsec = st->st_mtim.tv_nsec;
+    // the executable fallback depends on the permissions
+    rec->mode = st->st_mode;
+}
+
+static guint record_hash( const SniffRecord* rec )
+{
+    guint64 h = rec->ino * G_GUINT64_CONSTANT( 0x9E3779B97F4A7C15 );
+    h ^= rec->dev + ( h << 6 ) + ( h >> 2 );
+    h ^= (guint64)rec->size + ( h << 6 ) + ( h >> 2 );
+    h ^= (guint64)rec->mtime + rec->mtime_nsec + ( h << 6 ) + ( h >> 2 );
+    return (guint)( h ^ ( h >> 32 ) );
+}
+
+static gboolean record_equal( const SniffRecord* a, const SniffRecord* b )
+{
+    return a->ino == b->ino && a->dev == b->dev && a->size == b->size &&
+           a->mtime == b->mtime && a->mtime_nsec == b->mtime_nsec &&
+           a->mode == b->mode;
+}
+
+static guint session_hash( gconstpointer key )
+{
+    return record_hash( &( (SessionRecord*)key )->rec );
+}
+
+static gboolean session_equal( gconstpointer a, gconstpointer b )
+{
+    return record_equal( &( (SessionRecord*)a )->rec,
+                         &( (SessionRecord*)b )->rec );
+}
+
+static void session_record_free( SessionRecord* srec )
+{
+    g_slice_free( SessionRecord, srec );
+}
+
+static const char* intern_type( const char* type )
+{
+    char* name = (char*)g_hash_table_lookup( type_names, type );
+    if ( !name )
+    {
+        name = g_strdup( type );
+        g_hash_table_insert( type_names, name, name );
+    }
+    return name;
+}
+
+static void sniff_cache_unmap()
+{
+    if ( map )
+        munmap( map, map_size );
+    map = NULL;
+    map_size = 0;
+    map_records = NULL;
+    map_n_slots = 0;
+    g_free( map_types );
+    map_types = NULL;
+    map_n_types = 0;
+}
+
+static void sniff_cache_map()
+{
+    int fd;
+    struct stat64 st;
+    const SniffHeader* hdr;
+    const char* p;
+    const char* end;
+    guint32 i;
+
+    fd = open( cache_path, O_RDONLY );
+    if ( fd < 0 )
+        return;
+    if ( fstat64( fd, &st ) == -1 || st.st_size < sizeof( SniffHeader ) ||
+                                     st.st_size > G_MAXUINT32 )
+    {
+        close( fd );
+        return;
+    }
+    map_size = st.st_size;
+    map = mmap( NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( map == MAP_FAILED )
+    {
+        map = NULL;
+        map_size = 0;
+        return;
+    }
+
+    hdr = (const SniffHeader*)map;
+    if ( memcmp( hdr->magic, SNIFF_CACHE_MAGIC, sizeof( hdr->magic ) ) ||
+                        hdr->db_stamp != cache_db_stamp ||
+                        hdr->n_slots == 0 ||
+                        ( hdr->n_slots & ( hdr->n_slots - 1 ) ) ||
+                        hdr->n_slots > SNIFF_CACHE_MAX * 4 ||
+                        hdr->types_offset < sizeof( SniffHeader ) +
+                                    (gsize)hdr->n_slots * sizeof( SniffRecord ) ||
+                        (gsize)hdr->types_offset + hdr->types_size > map_size )
+        goto _invalid;
+
+    // the type names are interned so they survive an unmap
+    map_types = g_new( const char*, hdr->n_types + 1 );
+    p = map + hdr->types_offset;
+    end = p + hdr->types_size;
+    for ( i = 0; i < hdr->n_types; ++i )
+    {
+        const char* nul = memchr( p, '\0', end - p );
+        if ( !nul )
+            goto _invalid;
+        map_types[ i ] = intern_type( p );
+        p = nul + 1;
+    }
+    map_n_types = hdr->n_types;
+    map_n_slots = hdr->n_slots;
+    map_records = (const SniffRecord*)( map + sizeof( SniffHeader ) );
+    generation = hdr->generation + 1;
+    return;
+
+_invalid:
+    sniff_cache_unmap();
+}
+
+static const SniffRecord* map_lookup( const SniffRecord* key )
+{
+    guint32 mask = map_n_slots - 1;
+    guint32 i = record_hash( key ) & mask;
+    guint32 n;
+
+    for ( n = 0; n < map_n_slots; ++n, i = ( i + 1 ) & mask )
+    {
+        const SniffRecord* rec = &map_records[ i ];
+        if ( rec->type == 0 )
+            break;
+        if ( record_equal( rec, key ) )
+            return rec->type <= map_n_types ? rec : NULL;
+    }
+    return NULL;
+}
+
+static SessionRecord* session_add( const SniffRecord* key, const char* type )
+{
+    SessionRecord* srec;
+
+    if ( g_hash_table_size( session ) >= SNIFF_CACHE_MAX )
+        return NULL;
+    srec = g_slice_new( SessionRecord );
+    srec->rec = *key;
+    srec->rec.generation = generation;
+    srec->type = type;
+    g_hash_table_replace( session, srec, srec );
+    dirty = TRUE;
+    return srec;
+}
+
+const char* mime_sniff_cache_lookup( const struct stat64* st )
+{
+    SniffRecord key;
+    SessionRecord skey;
+    SessionRecord* srec;
+    const SniffRecord* rec;
+    const char* type = NULL;
+
+    record_init( &key, st );
+    skey.rec = key;
+
+    G_LOCK( sniff_cache );
+    if ( session )
+    {
+        srec = (SessionRecord*)g_hash_table_lookup( session, &skey );
+        if ( srec )
+            type = srec->type;
+        else if ( map && ( rec = map_lookup( &key ) ) )
+        {
+            type = map_types[ rec->type - 1 ];
+            // copy it so it is saved as recently used
+            session_add( &key, type );
+        }
+    }
+    G_UNLOCK( sniff_cache );
+    return type;
+}
+
+void mime_sniff_cache_insert( const struct stat64* st, const char* type )
+{
+    SniffRecord key;
+
+    // a file modified within this second may still change without
+    // its mtime changing
+    if ( st->st_mtime >= time( NULL ) - 1 )
+        return;
+    record_init( &key, st );
+
+    G_LOCK( sniff_cache );
+    if ( session )
+        session_add( &key, intern_type( type ) );
+    G_UNLOCK( sniff_cache );
+}
+
+void mime_sniff_cache_clear( guint64 db_stamp )
+{
+    G_LOCK( sniff_cache );
+    if ( session )
+    {
+        sniff_cache_unmap();
+        g_hash_table_remove_all( session );
+        cache_db_stamp = db_stamp;
+        dirty = TRUE;
+    }
+    G_UNLOCK( sniff_cache );
+}
+
+void mime_sniff_cache_init( const char* path, guint64 db_stamp )
+{
+    G_LOCK( sniff_cache );
+    if ( !session )
+    {
+        cache_path = g_strdup( path );
+        cache_db_stamp = db_stamp;
+        if ( !type_names )
+            type_names = g_hash_table_new( g_str_hash, g_str_equal );
+        session = g_hash_table_new_full( session_hash, session_equal,
+                                    (GDestroyNotify)session_record_free, NULL );
+        sniff_cache_map();
+    }
+    G_UNLOCK( sniff_cache );
+}
+
+static int compare_generation( gconstpointer a, gconstpointer b )
+{
+    guint32 ga = ( (SessionRecord*)a )->rec.generation;
+    guint32 gb = ( (SessionRecord*)b )->rec.generation;
+    return ga > gb ? -1 : ( ga < gb ? 1 : 0 );
+}
+
+static void sniff_cache_save()
+{
+    GArray* recs;
+    GHashTable* type_index;
+    GString* types;
+    GHashTableIter it;
+    gpointer key;
+    SessionRecord* srec;
+    SessionRecord tmp;
+    SniffHeader hdr;
+    SniffRecord* slots;
+    guint32 n_slots, i;
+    char* dir;
+    char* tmp_path;
+    FILE* file;
+    gboolean ok;
+
+    // this session's records, then the unused ones from the last session
+    recs = g_array_sized_new( FALSE, FALSE, sizeof( SessionRecord ),
+                              g_hash_table_size( session ) );
+    g_hash_table_iter_init( &it, session );
+    while ( g_hash_table_iter_next( &it, &key, NULL ) )
+        g_array_append_val( recs, *(SessionRecord*)key );
+    for ( i = 0; map && i < map_n_slots; ++i )
+    {
+        if ( map_records[ i ].type == 0 || map_records[ i ].type > map_n_types )
+            continue;
+        tmp.rec = map_records[ i ];
+        if ( g_hash_table_lookup( session, &tmp ) )
+            continue;
+        tmp.type = map_types[ tmp.rec.type - 1 ];
+        g_array_append_val( recs, tmp );
+    }
+    if ( recs->len > SNIFF_CACHE_MAX )
+    {
+        g_array_sort( recs, compare_generation );
+        g_array_set_size( recs, SNIFF_CACHE_MAX );
+    }
+
+    for ( n_slots = 16; n_slots < recs->len * 2; n_slots <<= 1 );
+    slots = g_new0( SniffRecord, n_slots );
+    type_index = g_hash_table_new( g_direct_hash, g_direct_equal );
+    types = g_string_new( NULL );
+    memcpy( hdr.magic, SNIFF_CACHE_MAGIC, sizeof( hdr.magic ) );
+    hdr.db_stamp = cache_db_stamp;
+    hdr.generation = generation;
+    hdr.n_slots = n_slots;
+    hdr.n_types = 0;
+    hdr.reserved = 0;
+    for ( i = 0; i < recs->len; ++i )
+    {
+        guint32 slot;
+
+        srec = &g_array_index( recs, SessionRecord, i );
+        // type names are interned, so compare pointers
+        srec->rec.type = GPOINTER_TO_UINT( g_hash_table_lookup( type_index,
+                                                                srec->type ) );
+        if ( !srec->rec.type )
+        {
+            srec->rec.type = ++hdr.n_types;
+            g_hash_table_insert( type_index, (gpointer)srec->type,
+                                 GUINT_TO_POINTER( srec->rec.type ) );
+            g_string_append_len( types, srec->type, strlen( srec->type ) + 1 );
+        }
+        slot = record_hash( &srec->rec ) & ( n_slots - 1 );
+        while ( slots[ slot ].type )
+            slot = ( slot + 1 ) & ( n_slots - 1 );
+        slots[ slot ] = srec->rec;
+    }
+    hdr.types_offset = sizeof( SniffHeader ) + n_slots * sizeof( SniffRecord );
+    hdr.types_size = types->len;
+
+    dir = g_path_get_dirname( cache_path );
+    g_mkdir_with_parents( dir, 0700 );
+    g_free( dir );
+    tmp_path = g_strdup_printf( "%s.%d", cache_path, getpid() );
+    ok = FALSE;
+    if ( ( file = fopen( tmp_path, "w" ) ) )
+    {
+        ok = fwrite( &hdr, sizeof( hdr ), 1, file ) == 1 &&
+             fwrite( slots, sizeof( SniffRecord ), n_slots, file ) == n_slots &&
+             fwrite( types->str, 1, types->len, file ) == types->len;
+        ok = ( fclose( file ) == 0 ) && ok;
+    }
+    if ( !ok || rename( tmp_path, cache_path ) == -1 )
+        unlink( tmp_path );
+    g_free( tmp_path );
+
+    g_string_free( types, TRUE );
+    g_hash_table_destroy( type_index );
+    g_free( slots );
+    g_array_free( recs, TRUE );
+}
+
+void mime_sniff_cache_finalize()
+{
+    G_LOCK( sniff_cache );
+    if ( session )
+    {
+        if ( dirty )
+            sniff_cache_save();
+        sniff_cache_unmap();
+        g_hash_table_destroy( session );
+        session = NULL;
+        g_free( cache_path );
+        cache_path = NULL;
+        dirty = FALSE;
+        // type_names stays - returned types are never freed
+    }
+    G_UNLOCK( sniff_cache );
+}
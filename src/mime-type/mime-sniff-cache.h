@@ -0,0 +1,51 @@
+/*
+ *      mime-sniff-cache.h
+ *
+ *      This program is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation; either version 3 of the License, or
+ *      (at your option) any later version.
+ *
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with this program; if not, write to the Free Software
+ *      Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ *      MA 02110-1301, USA.
+ */
+
+#ifndef _MIME_SNIFF_CACHE_H_INCLUDED_
+#define _MIME_SNIFF_CACHE_H_INCLUDED_
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Results of content sniffing, keyed by device, inode, size, mtime and mode.
+ * The cache is kept in file path between sessions and memory-mapped on load.
+ * db_stamp identifies the mime database the results came from - a cache
+ * saved with another stamp is ignored.
+ * All functions are MT-safe.
+ */
+void mime_sniff_cache_init( const char* path, guint64 db_stamp );
+
+/* Write the cache back to disk if it changed and free it */
+void mime_sniff_cache_finalize();
+
+/* Forget all results, eg. after the mime database changed */
+void mime_sniff_cache_clear( guint64 db_stamp );
+
+/* The type sniffed from the file with stat st, or NULL if it is not cached.
+ * The returned string is never freed. */
+const char* mime_sniff_cache_lookup( const struct stat64* st );
+
+void mime_sniff_cache_insert( const struct stat64* st, const char* type );
+
+G_END_DECLS
+#endif
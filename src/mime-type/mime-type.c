@@ -31,6 +31,9 @@
 
 #include "mime-type.h"
 #include "mime-cache.h"
+#include "mime-sniff-cache.h"
+#include "mime-glob.h"
+#include "mime-desc-cache.h"
 
 #include <string.h>
 
@@ -68,6 +71,10 @@ static MimeCache** caches = NULL;
 static guint n_caches = 0;
 guint32 mime_cache_max_extent = 0;
 
+/* file name patterns of all caches, rebuilt when a cache is reloaded */
+static MimeGlobs* mime_globs = NULL;
+G_LOCK_DEFINE_STATIC(mime_globs);
+
 /* allocated buffer used for mime magic checking to
      prevent frequent memory allocation */
 static char* mime_magic_buf = NULL;
@@ -83,8 +90,6 @@ static void mime_cache_load_all();
 /* free all mime.cache files on the system */
 static void mime_cache_free_all();
 
-static gboolean mime_type_is_data_plain_text( const char* data, int len );
-
 /*
  * Get mime-type of the specified file (quick, but less accurate):
  * Mime-type of the file is determined by cheking the filename only.
@@ -95,10 +100,22 @@ const char* mime_type_get_by_filename( const char* filename, struct stat64* stat
     const char* type = NULL, *suffix_pos = NULL, *prev_suffix_pos = (const char*)-1;
     int i;
     MimeCache* cache;
+    MimeGlobs* globs;
 
     if( G_UNLIKELY( statbuf && S_ISDIR( statbuf->st_mode ) ) )
         return XDG_MIME_TYPE_DIRECTORY;
 
+    G_LOCK( mime_globs );
+    globs = mime_globs ? mime_globs_ref( mime_globs ) : NULL;
+    G_UNLOCK( mime_globs );
+    if( G_LIKELY( globs ) )
+    {
+        type = mime_globs_lookup( globs, filename );
+        mime_globs_unref( globs );
+        return type && *type ? type : XDG_MIME_TYPE_UNKNOWN;
+    }
+
+    /* a cache older than mime.cache 1.1 - query them one by one */
     for( i = 0; ! type && i < n_caches; ++i )
     {
         cache = caches[i];
@@ -190,6 +207,20 @@ const char* mime_type_get_by_file( const char* filepath, struct stat64* statbuf,
     {
         int fd = -1;
         char* data;
+        struct stat64 id_stat;
+        gboolean have_id;
+
+        /* An unchanged file sniffed before isn't read again.  A statbuf from
+         * the caller may only carry st_mode, so stat here unless we did. */
+        if ( statbuf == &_statbuf )
+        {
+            id_stat = _statbuf;
+            have_id = TRUE;
+        }
+        else
+            have_id = stat64( filepath, &id_stat ) == 0;
+        if ( have_id && ( type = mime_sniff_cache_lookup( &id_stat ) ) )
+            return type;
 
         /* Open the file and map it into memory */
         fd = open ( filepath, O_RDONLY, 0 );
@@ -239,6 +270,10 @@ const char* mime_type_get_by_file( const char* filepath, struct stat64* statbuf,
                         type = XDG_MIME_TYPE_PLAIN_TEXT;
                 }
 
+                if( have_id )
+                    mime_sniff_cache_insert( &id_stat, type && *type ?
+                                             type : XDG_MIME_TYPE_UNKNOWN );
+
 #ifdef HAVE_MMAP
                 munmap ( (char*)data, len );
 #else
@@ -271,8 +306,8 @@ static char* parse_xml_icon( const char* buf, size_t len, gboolean is_local )
         icon_tag = g_strstr_len( buf, len, "<icon name=" );
         if ( icon_tag )
         {
+            len -= icon_tag + 11 - buf;
             icon_tag += 11;
-            len -= 11;
         }
     }
     if ( !icon_tag && !is_local )
@@ -281,8 +316,8 @@ static char* parse_xml_icon( const char* buf, size_t len, gboolean is_local )
         icon_tag = g_strstr_len( buf, len, "<generic-icon name=" );
         if ( icon_tag )
         {
+            len -= icon_tag + 19 - buf;
             icon_tag += 19;
-            len -= 19;
         }
     }
     if ( !icon_tag )
@@ -319,8 +354,8 @@ static char* parse_xml_desc( const char* buf, size_t len, const char* locale )
     eng_comment = g_strstr_len( buf, len, "<comment>" );    /* default English comment */
     if( G_UNLIKELY( ! eng_comment ) ) /* This xml file is invalid */
         return NULL;
-    len -= 9;
     eng_comment += 9;
+    len = buf_end - eng_comment;
     comment_end = g_strstr_len( eng_comment, len, end_comment_tag ); /* find </comment> */
     if( G_UNLIKELY( ! comment_end ) )
         return NULL;
@@ -333,8 +368,8 @@ static char* parse_xml_desc( const char* buf, size_t len, const char* locale )
         len = (buf_end - buf);
         if( G_LIKELY( ( comment = g_strstr_len( buf, len, target ) ) ) )
         {
-            len -= target_len;
             comment += target_len;
+            len = buf_end - comment;
             comment_end = g_strstr_len( comment, len, end_comment_tag );    /* find </comment> */
             if( G_LIKELY( comment_end ) )
                 comment_len = (comment_end - comment);
@@ -347,10 +382,8 @@ static char* parse_xml_desc( const char* buf, size_t len, const char* locale )
     return g_strndup( eng_comment, eng_comment_len );
 }
 
-static char* _mime_type_get_desc_icon( const char* file_path,
-                                       const char* locale,
-                                       gboolean is_local,
-                                       char** icon_name )
+char* mime_type_read_desc_icon( const char* file_path, const char* locale,
+                                gboolean is_local, char** icon_name )
 {
     int fd;
     struct stat statbuf;   // skip stat64
@@ -421,7 +454,17 @@ char* mime_type_get_desc_icon( const char* type, const char* locale,
     const gchar* const * dir;
     char file_path[ 256 ];
     int acc;
-    
+    char* icon = NULL;
+
+    /* the indexed XML tree answers without touching the files */
+    if ( !locale && mime_desc_cache_lookup( type, &desc,
+                            icon_name && *icon_name == NULL ? &icon : NULL ) )
+    {
+        if ( icon )
+            *icon_name = icon;
+        return desc;
+    }
+
     /*  //sfm 0.7.7+ FIXED:
      * According to specs on freedesktop.org, user_data_dir has
      * higher priority than system_data_dirs, but in most cases, there was
@@ -440,7 +483,7 @@ char* mime_type_get_desc_icon( const char* type, const char* locale,
 #endif
     if ( acc != -1 )
     {
-        desc = _mime_type_get_desc_icon( file_path, locale, TRUE, icon_name );
+        desc = mime_type_read_desc_icon( file_path, locale, TRUE, icon_name );
         if ( desc )
             return desc;
     }
@@ -460,7 +503,7 @@ char* mime_type_get_desc_icon( const char* type, const char* locale,
 #endif
         if ( acc != -1 )
         {
-            desc = _mime_type_get_desc_icon( file_path, locale, FALSE,
+            desc = mime_type_read_desc_icon( file_path, locale, FALSE,
                                                                 icon_name );
             if ( G_LIKELY(desc) )
                 return desc;
@@ -478,6 +521,8 @@ void mime_type_finalize()
         table = NULL;
     }
 */
+    mime_desc_cache_finalize();
+    mime_sniff_cache_finalize();
     mime_cache_free_all();
 }
 
@@ -518,9 +563,37 @@ void test_alias( const char* type )
 }
 #endif
 
+/* Identifies the loaded mime database, so sniff results from another
+ * version are not reused */
+static guint64 mime_cache_get_stamp()
+{
+    struct stat64 st;
+    guint64 stamp = n_caches;
+    int i;
+
+    for( i = 0; i < n_caches; ++i )
+    {
+        stamp *= G_GUINT64_CONSTANT( 1099511628211 );
+        if( caches[i]->file_path && stat64( caches[i]->file_path, &st ) == 0 )
+            stamp ^= ( (guint64)st.st_mtime << 20 ) ^ st.st_size ^
+                     st.st_ino;
+    }
+    return stamp;
+}
+
 void mime_type_init()
 {
+    char* path;
+
     mime_cache_load_all();
+    path = g_build_filename( g_get_user_cache_dir(), "spacefm",
+                             "mime-sniff.cache", NULL );
+    mime_sniff_cache_init( path, mime_cache_get_stamp() );
+    g_free( path );
+    path = g_build_filename( g_get_user_cache_dir(), "spacefm",
+                             "mime-desc.cache", NULL );
+    mime_desc_cache_init( path, mime_cache_get_stamp() );
+    g_free( path );
 //    table = g_hash_table_new_full( g_str_hash, g_str_equal, g_free, (GDestroyNotify)mime_type_unref );
 }
 
@@ -554,12 +627,19 @@ void mime_cache_load_all()
             mime_cache_max_extent = caches[i]->magic_max_extent;
     }
     mime_magic_buf = g_malloc( mime_cache_max_extent );
+    mime_globs = mime_globs_new( caches, n_caches );
     return ;
 }
 
 /* free all mime.cache files on the system */
 void mime_cache_free_all()
 {
+    G_LOCK( mime_globs );
+    if( mime_globs )
+        mime_globs_unref( mime_globs );
+    mime_globs = NULL;
+    G_UNLOCK( mime_globs );
+
     mime_cache_foreach( (GFunc)mime_cache_free, NULL );
     g_slice_free1( n_caches * sizeof(MimeCache*), caches );
     n_caches = 0;
@@ -581,7 +661,17 @@ void mime_cache_foreach( GFunc func, gpointer user_data )
 gboolean mime_cache_reload( MimeCache* cache )
 {
     int i;
+    MimeGlobs* globs;
     gboolean ret = mime_cache_load( cache, cache->file_path );
+
+    /* lookups in progress keep their ref to the old matcher */
+    globs = mime_globs_new( caches, n_caches );
+    G_LOCK( mime_globs );
+    if( mime_globs )
+        mime_globs_unref( mime_globs );
+    mime_globs = globs;
+    G_UNLOCK( mime_globs );
+
     /* recalculate max magic extent */
     for( i = 0; i < n_caches; ++i )
     {
@@ -595,21 +685,16 @@ gboolean mime_cache_reload( MimeCache* cache )
 
     G_UNLOCK( mime_magic_buf );
 
+    mime_sniff_cache_clear( mime_cache_get_stamp() );
+    mime_desc_cache_clear( mime_cache_get_stamp() );
     return ret;
 }
 
 gboolean mime_type_is_data_plain_text( const char* data, int len )
 {
-    int i;
+    /* memchr is vectorized by libc, many times faster than a byte loop */
     if ( G_LIKELY( len >= 0 && data ) )
-    {
-        for ( i = 0; i < len; ++i )
-        {
-            if ( data[ i ] == '\0' )
-                return FALSE;
-        }
-        return TRUE;
-    }
+        return memchr( data, '\0', len ) == NULL;
     return FALSE;
 }
 
@@ -80,6 +80,9 @@ const char* mime_type_get_by_file( const char* filepath, struct stat64* statbuf,
 
 gboolean mime_type_is_text_file( const char * file_path, const char * mime_type );
 
+/* Check if data looks like text: it has no nul bytes */
+gboolean mime_type_is_data_plain_text( const char* data, int len );
+
 gboolean mime_type_is_executable_file( const char * file_path, const char * mime_type );
 
 /* Check if the specified mime_type is the subclass of the specified parent type */
@@ -117,6 +120,11 @@ char** mime_type_get_alias( const char* type );
 char* mime_type_get_desc_icon( const char* type, const char* locale,
                                                  char** icon_name );
 
+/* Same as above for a single XML file of the mime database.  <icon> is only
+ * read if is_local. */
+char* mime_type_read_desc_icon( const char* file_path, const char* locale,
+                                gboolean is_local, char** icon_name );
+
 /*
  * Iterate through all mime caches
  * Can be used to hook file alteration monitor for the cache files to handle reloading.
@@ -597,9 +597,9 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
         if ( g_strcmp0( etext, xset_get_s( "date_format" ) ) )
         {
             if ( etext[0] == '\0' )
-                xset_set( "date_format", "s", "%Y-%m-%d %H:%M" );
+                xset_set( "date_format", XSET_VAR_S, "%Y-%m-%d %H:%M" );
             else
-                xset_set( "date_format", "s", etext );
+                xset_set( "date_format", XSET_VAR_S, etext );
             g_free( etext );
             if ( app_settings.date_format )
                 g_free( app_settings.date_format );
@@ -684,7 +684,7 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
         
         char* s = g_strdup_printf( "%d",
                     gtk_combo_box_get_active( GTK_COMBO_BOX( data->drag_action ) ) );
-        xset_set( "drag_action", "x", s );
+        xset_set( "drag_action", XSET_VAR_X, s );
         g_free( s );
 
         // terminal su command
@@ -698,13 +698,13 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
             if ( custom_su )
             {
                 if ( idx == 0 )
-                    xset_set( "su_command", "s", custom_su );
+                    xset_set( "su_command", XSET_VAR_S, custom_su );
                 else
-                    xset_set( "su_command", "s", su_commands[idx - 1] );
+                    xset_set( "su_command", XSET_VAR_S, su_commands[idx - 1] );
                 g_free( custom_su );
             }
             else
-                xset_set( "su_command", "s", su_commands[idx] );
+                xset_set( "su_command", XSET_VAR_S, su_commands[idx] );
         }
         
         // graphical su command
@@ -723,17 +723,17 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
             if ( custom_gsu )
             {
                 if ( idx == 0 )
-                    xset_set( "gsu_command", "s", custom_gsu );
+                    xset_set( "gsu_command", XSET_VAR_S, custom_gsu );
                 else
-                    xset_set( "gsu_command", "s", gsu_commands[idx - 1] );
+                    xset_set( "gsu_command", XSET_VAR_S, gsu_commands[idx - 1] );
                 g_free( custom_gsu );
             }
             else
-                xset_set( "gsu_command", "s", gsu_commands[idx] );
+                xset_set( "gsu_command", XSET_VAR_S, gsu_commands[idx] );
         }
         
         //MOD editors
-        xset_set( "editor", "s", gtk_entry_get_text( GTK_ENTRY( data->editor ) ) );
+        xset_set( "editor", XSET_VAR_S, gtk_entry_get_text( GTK_ENTRY( data->editor ) ) );
         xset_set_b( "editor", gtk_toggle_button_get_active(
                                             (GtkToggleButton*)data->editor_terminal ) );
         const char* root_editor = gtk_entry_get_text( GTK_ENTRY( data->root_editor ) );
@@ -742,13 +742,13 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
         {
             if ( root_editor[0] != '\0' )
             {
-                xset_set( "root_editor", "s", root_editor );
+                xset_set( "root_editor", XSET_VAR_S, root_editor );
                 root_set_change = TRUE;
             }
         }
         else if ( strcmp( root_editor, old_root_editor ) )
         {
-            xset_set( "root_editor", "s", root_editor );
+            xset_set( "root_editor", XSET_VAR_S, root_editor );
             root_set_change = TRUE;
         }
         if ( !!gtk_toggle_button_get_active(
@@ -766,7 +766,7 @@ static void on_response( GtkDialog* dlg, int response, FMPrefDlg* user_data )
         g_strstrip( terminal );
         if ( g_strcmp0( terminal, old_terminal ) )
         {
-            xset_set( "main_terminal", "s", terminal[0] == '\0' ? NULL : terminal );
+            xset_set( "main_terminal", XSET_VAR_S, terminal[0] == '\0' ? NULL : terminal );
             root_set_change = TRUE;
             if ( terminal && ( strstr( terminal, "lxterminal" ) ||
                                strstr( terminal, "urxvtc" ) ||
@@ -1093,7 +1093,7 @@ gboolean fm_edit_preference( GtkWindow* parent, int page )
                                                         xset_get_b( "root_bar" ) );
         gtk_widget_set_sensitive( data->root_bar, geteuid() == 0 );
 
-        int drag_action = xset_get_int( "drag_action", "x" );
+        int drag_action = xset_get_int( "drag_action", XSET_VAR_X );
         int drag_action_set = 0;
         for ( i = 0; i < G_N_ELEMENTS( drag_actions ); ++i )
         {
@@ -209,8 +209,8 @@ GtkWidget* app_chooser_dialog_new( GtkWindow* parent, VFSMimeType* mime_type,
     gtk_dialog_set_alternative_button_order( GTK_DIALOG(dlg), GTK_RESPONSE_OK, GTK_RESPONSE_CANCEL, -1 );
     ptk_dialog_fit_small_screen( GTK_DIALOG(dlg) );
 
-    int width = xset_get_int( "app_dlg", "x" );
-    int height = xset_get_int( "app_dlg", "y" );
+    int width = xset_get_int( "app_dlg", XSET_VAR_X );
+    int height = xset_get_int( "app_dlg", XSET_VAR_Y );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( dlg ), width, height );
     else
@@ -457,10 +457,10 @@ static void on_dlg_response( GtkDialog* dlg, int id, gpointer user_data )
     if ( width && height )
     {
         char* str = g_strdup_printf( "%d", width );
-        xset_set( "app_dlg", "x", str );
+        xset_set( "app_dlg", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "app_dlg", "y", str );
+        xset_set( "app_dlg", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -833,7 +833,7 @@ gboolean on_dir_tree_view_drag_motion ( GtkWidget *widget,
         /* Several different actions are available. We have to figure out a good default action. */
         else
         {
-            int drag_action = xset_get_int( "drag_action", "x" );
+            int drag_action = xset_get_int( "drag_action", XSET_VAR_X );
             if ( drag_action == 1 )
                 suggested_action = GDK_ACTION_COPY;
             else if ( drag_action == 2 )
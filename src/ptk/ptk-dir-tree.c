@@ -833,6 +833,55 @@ static PtkDirTreeNode* find_node( PtkDirTreeNode* parent, const char* name )
     return NULL;
 }
 
+/* Bring the children of an expanded node up to date with its dir, after
+ * the monitor lost events */
+static void reload_children( PtkDirTreeNode* node, const char* path )
+{
+    PtkDirTreeNode *child, *next;
+    GDir *dir;
+    char *file_path;
+    const char *name;
+
+    for( child = node->children; child; child = next )
+    {
+        next = child->next;
+        if( !child->file )
+            continue;
+        file_path = g_build_filename( path,
+                                      vfs_file_info_get_name( child->file ),
+                                      NULL );
+        if( ! g_file_test( file_path, G_FILE_TEST_IS_DIR ) )
+            ptk_dir_tree_delete_child( node->tree, child );
+        g_free( file_path );
+    }
+
+    dir = g_dir_open( path, 0, NULL );
+    if( dir )
+    {
+        while( (name = g_dir_read_name( dir )) )
+        {
+            if( find_node( node, name ) )
+                continue;
+            file_path = g_build_filename( path, name, NULL );
+            if( g_file_test( file_path, G_FILE_TEST_IS_DIR ) )
+                ptk_dir_tree_insert_child( node->tree, node, file_path, name );
+            g_free( file_path );
+        }
+        g_dir_close( dir );
+    }
+
+    /* remove the place holder if real children were found */
+    for( child = node->children; child; child = child->next )
+    {
+        if( !child->file )
+        {
+            if( node->n_children > 1 )
+                ptk_dir_tree_delete_child( node->tree, child );
+            break;
+        }
+    }
+}
+
 void on_file_monitor_event ( VFSFileMonitor* fm,
                              VFSFileMonitorEvent event,
                              const char* file_name,
@@ -875,6 +924,10 @@ void on_file_monitor_event ( VFSFileMonitor* fm,
             ptk_dir_tree_delete_child( node->tree, child );
         }
         break;
+    case VFS_FILE_MONITOR_OVERFLOW:
+        /* events were lost - file_name is the dir itself */
+        reload_children( node, fm->path );
+        break;
 /* //MOD Change isn't needed?  Creates this warning and triggers subsequent
  * errors and causes visible redrawing problems:
 Gtk-CRITICAL **: /tmp/buildd/gtk+2.0-2.24.3/gtk/gtktreeview.c:6072 (validate_visible_area): assertion `has_next' failed.
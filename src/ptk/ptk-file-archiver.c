@@ -597,8 +597,8 @@ void ptk_file_archiver_create( DesktopWindow *desktop,
     gtk_file_chooser_set_current_folder( GTK_FILE_CHOOSER( dlg ), cwd );
 
     // Setting dimension and position
-    int width = xset_get_int( "arc_dlg", "x" );
-    int height = xset_get_int( "arc_dlg", "y" );
+    int width = xset_get_int( "arc_dlg", XSET_VAR_X );
+    int height = xset_get_int( "arc_dlg", XSET_VAR_Y );
     if ( width && height )
     {
         // filechooser won't honor default size or size request ?
@@ -642,7 +642,7 @@ void ptk_file_archiver_create( DesktopWindow *desktop,
 
             handler_xset = xset_get( xset_name );
             // Saving selected archive handler name as default
-            xset_set( "arc_dlg", "s", xset_name );
+            xset_set( "arc_dlg", XSET_VAR_S, xset_name );
             g_free( xset_name );
             
             // run in the terminal or not
@@ -806,10 +806,10 @@ void ptk_file_archiver_create( DesktopWindow *desktop,
     if ( width && height )
     {
         str = g_strdup_printf( "%d", width );
-        xset_set( "arc_dlg", "x", str );
+        xset_set( "arc_dlg", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "arc_dlg", "y", str );
+        xset_set( "arc_dlg", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -1162,7 +1162,7 @@ void ptk_file_archiver_extract( DesktopWindow *desktop,
         gtk_toggle_button_set_active( GTK_TOGGLE_BUTTON( chk_parent ),
                                               xset_get_b( "arc_dlg" ) );
         gtk_toggle_button_set_active( GTK_TOGGLE_BUTTON( chk_write ),
-                                xset_get_int( "arc_dlg", "z" ) == 1 &&
+                                xset_get_int( "arc_dlg", XSET_VAR_Z ) == 1 &&
                                 geteuid() != 0 );
         gtk_widget_set_sensitive( chk_write, xset_get_b( "arc_dlg" ) &&
                                              geteuid() != 0 );
@@ -1177,8 +1177,8 @@ void ptk_file_archiver_extract( DesktopWindow *desktop,
         gtk_file_chooser_set_current_folder( GTK_FILE_CHOOSER (dlg), cwd );
 
         // Fetching saved dialog dimensions and applying
-        int width = xset_get_int( "arc_dlg", "x" );
-        int height = xset_get_int( "arc_dlg", "y" );
+        int width = xset_get_int( "arc_dlg", XSET_VAR_X );
+        int height = xset_get_int( "arc_dlg", XSET_VAR_Y );
         if ( width && height )
         {
             // filechooser won't honor default size or size request ?
@@ -1204,7 +1204,7 @@ void ptk_file_archiver_extract( DesktopWindow *desktop,
                 write_access = create_parent && 
                     gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( chk_write ) );
                 xset_set_b( "arc_dlg", create_parent );
-                xset_set( "arc_dlg", "z", write_access ? "1" : "0" );
+                xset_set( "arc_dlg", XSET_VAR_Z, write_access ? "1" : "0" );
                 break;
             }
             else if ( res == GTK_RESPONSE_NONE )
@@ -1237,10 +1237,10 @@ void ptk_file_archiver_extract( DesktopWindow *desktop,
         if ( width && height )
         {
             str = g_strdup_printf( "%d", width );
-            xset_set( "arc_dlg", "x", str );
+            xset_set( "arc_dlg", XSET_VAR_X, str );
             g_free( str );
             str = g_strdup_printf( "%d", height );
-            xset_set( "arc_dlg", "y", str );
+            xset_set( "arc_dlg", XSET_VAR_Y, str );
             g_free( str );
         }
 
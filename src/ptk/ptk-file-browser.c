@@ -121,6 +121,9 @@ on_folder_view_row_activated ( GtkTreeView *tree_view,
 static void
 on_folder_view_item_sel_change ( ExoIconView *iconview,
                                  PtkFileBrowser* file_browser );
+static void
+on_folder_view_scrolled( GtkAdjustment* adj,
+                         PtkFileBrowser* file_browser );
 
 static gboolean
 on_folder_view_button_press_event ( GtkWidget *widget,
@@ -1330,6 +1333,10 @@ void ptk_file_browser_init( PtkFileBrowser* file_browser )
                                                                 FALSE, FALSE );
     gtk_paned_pack2 ( GTK_PANED( file_browser->hpane ), 
                                     file_browser->folder_view_scroll, TRUE, TRUE );
+    g_signal_connect( gtk_scrolled_window_get_vadjustment(
+                        GTK_SCROLLED_WINDOW( file_browser->folder_view_scroll ) ),
+                      "value-changed", G_CALLBACK( on_folder_view_scrolled ),
+                      file_browser );
 
     // fill side
     file_browser->side_toolbox = gtk_hbox_new( FALSE, 0 );
@@ -1481,6 +1488,17 @@ void ptk_file_browser_finalize( GObject *obj )
         g_object_unref( file_browser->dir );
     }
 
+    if ( file_browser->thumbnail_scroll_timer )
+    {
+        g_source_remove( file_browser->thumbnail_scroll_timer );
+        file_browser->thumbnail_scroll_timer = 0;
+    }
+    if ( file_browser->sel_change_idle )
+    {
+        g_source_remove( file_browser->sel_change_idle );
+        file_browser->sel_change_idle = 0;
+    }
+
     /* Remove all idle handlers which are not called yet. */
     do
     {}
@@ -1832,7 +1850,7 @@ void ptk_file_browser_update_views( GtkWidget* item, PtkFileBrowser* file_browse
         ptk_file_browser_view_as_compact_list( file_browser );
     else
     {
-        xset_set_panel( p, "list_detailed", "b", "1" );
+        xset_set_panel( p, "list_detailed", XSET_VAR_B, "1" );
         ptk_file_browser_view_as_list( file_browser );
     }
 
@@ -1858,6 +1876,7 @@ GtkWidget* ptk_file_browser_new( int curpanel, GtkWidget* notebook,
     file_browser->main_window = main_window;
     file_browser->task_view = task_view;
     file_browser->sel_change_idle = 0;
+    file_browser->thumbnail_scroll_timer = 0;
     file_browser->inhibit_focus = file_browser->busy = FALSE;
     file_browser->seek_name = NULL;
     file_browser->book_set_name = NULL;
@@ -1882,7 +1901,7 @@ GtkWidget* ptk_file_browser_new( int curpanel, GtkWidget* notebook,
     }
     else
     {
-        xset_set_panel( curpanel, "list_detailed", "b", "1" );
+        xset_set_panel( curpanel, "list_detailed", XSET_VAR_B, "1" );
         view_mode = PTK_FB_LIST_VIEW;
     }
 
@@ -2646,10 +2665,10 @@ static void on_sort_col_changed( GtkTreeSortable* sortable,
 //        ptk_file_browser_set_sort_order( PTK_FILE_BROWSER( file_browser ), app_settings.sort_order );
 
     char* val = g_strdup_printf( "%d", col );
-    xset_set_panel( file_browser->mypanel, "list_detailed", "x", val );
+    xset_set_panel( file_browser->mypanel, "list_detailed", XSET_VAR_X, val );
     g_free( val );
     val = g_strdup_printf( "%d", file_browser->sort_type );
-    xset_set_panel( file_browser->mypanel, "list_detailed", "y", val );
+    xset_set_panel( file_browser->mypanel, "list_detailed", XSET_VAR_Y, val );
     g_free( val );
 }
 
@@ -2876,7 +2895,7 @@ void ptk_file_browser_go_default( GtkWidget* item, PtkFileBrowser* file_browser
 void ptk_file_browser_set_default_folder( GtkWidget* item,
                                           PtkFileBrowser* file_browser )
 {
-    xset_set( "go_set_default", "s", ptk_file_browser_get_cwd( file_browser ) );
+    xset_set( "go_set_default", XSET_VAR_S, ptk_file_browser_get_cwd( file_browser ) );
 }
 
 GtkWidget* ptk_file_browser_get_folder_view( PtkFileBrowser* file_browser )
@@ -3576,6 +3595,52 @@ void on_folder_view_item_sel_change( ExoIconView *iconview,
                             file_browser );
 }
 
+static gboolean on_thumbnail_scroll_timer( PtkFileBrowser* file_browser )
+{
+    GtkTreePath* start = NULL;
+    GtkTreePath* end = NULL;
+    gboolean visible;
+
+    file_browser->thumbnail_scroll_timer = 0;
+    if ( !file_browser->file_list || !file_browser->folder_view ||
+                                     !file_browser->max_thumbnail )
+        return FALSE;
+
+    if ( file_browser->view_mode == PTK_FB_ICON_VIEW ||
+                    file_browser->view_mode == PTK_FB_COMPACT_VIEW )
+        visible = exo_icon_view_get_visible_range(
+                                EXO_ICON_VIEW( file_browser->folder_view ),
+                                &start, &end );
+    else
+        visible = gtk_tree_view_get_visible_range(
+                                GTK_TREE_VIEW( file_browser->folder_view ),
+                                &start, &end );
+    if ( visible )
+    {
+        ptk_file_list_prioritize_thumbnails(
+                                PTK_FILE_LIST( file_browser->file_list ),
+                                gtk_tree_path_get_indices( start )[0],
+                                gtk_tree_path_get_indices( end )[0] );
+        gtk_tree_path_free( start );
+        gtk_tree_path_free( end );
+    }
+    return FALSE;
+}
+
+static void on_folder_view_scrolled( GtkAdjustment* adj,
+                                     PtkFileBrowser* file_browser )
+{
+    /* Thumbnails of the rows scrolled into sight are loaded first.  Wait
+     * for the scrolling to settle rather than reordering on every step */
+    if ( !file_browser->max_thumbnail )
+        return;
+    if ( file_browser->thumbnail_scroll_timer )
+        g_source_remove( file_browser->thumbnail_scroll_timer );
+    file_browser->thumbnail_scroll_timer = g_timeout_add( 100,
+                            (GSourceFunc)on_thumbnail_scroll_timer,
+                            file_browser );
+}
+
 static void show_popup_menu( PtkFileBrowser* file_browser,
                              GdkEventButton *event )
 {
@@ -4423,7 +4488,7 @@ void init_list_view( PtkFileBrowser* file_browser, GtkTreeView* list_view )
         // column order
         for ( j = 0; j < G_N_ELEMENTS( cols ); j++ )
         {
-            if ( xset_get_int_panel( p, column_names[j], "x" ) == i )
+            if ( xset_get_int_panel( p, column_names[j], XSET_VAR_X ) == i )
                 break;
         }
         if ( j == G_N_ELEMENTS( cols ) )
@@ -5159,7 +5224,7 @@ gboolean on_folder_view_drag_motion ( GtkWidget *widget,
         /* Several different actions are available. We have to figure out a good default action. */
         else
         {
-            int drag_action = xset_get_int( "drag_action", "x" );
+            int drag_action = xset_get_int( "drag_action", XSET_VAR_X );
             if ( drag_action == 1 )
                 suggested_action = GDK_ACTION_COPY;
             else if ( drag_action == 2 )
@@ -5474,7 +5539,7 @@ void ptk_file_browser_copycmd( PtkFileBrowser* file_browser, GList* sel_files,
             else
                 move_dest = path;
             set2 = xset_get( "copy_loc_last" );
-            xset_set_set( set2, "desc", path );
+            xset_set_set( set2, XSET_VAR_DESC, path );
         }
         else
             return;
@@ -5741,10 +5806,10 @@ void ptk_file_browser_read_sort_extra( PtkFileBrowser* file_browser )
 
     list->sort_natural = xset_get_b_panel( file_browser->mypanel, "sort_extra" );
     list->sort_case = xset_get_int_panel( file_browser->mypanel, "sort_extra",
-                                                            "x" ) == XSET_B_TRUE;
-    list->sort_dir = xset_get_int_panel( file_browser->mypanel, "sort_extra", "y" );
+                                                            XSET_VAR_X ) == XSET_B_TRUE;
+    list->sort_dir = xset_get_int_panel( file_browser->mypanel, "sort_extra", XSET_VAR_Y );
     list->sort_hidden_first = xset_get_int_panel( file_browser->mypanel,
-                                            "sort_extra", "z" ) == XSET_B_TRUE;
+                                            "sort_extra", XSET_VAR_Z ) == XSET_B_TRUE;
 }
 
 void ptk_file_browser_set_sort_extra( PtkFileBrowser* file_browser,
@@ -5774,38 +5839,38 @@ void ptk_file_browser_set_sort_extra( PtkFileBrowser* file_browser,
     {
         list->sort_case = set->b == XSET_B_TRUE;
         val = g_strdup_printf( "%d", set->b );
-        xset_set_panel( panel, "sort_extra", "x", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_X, val );
     }
     else if ( !strcmp( name, "folders" ) )
     {
         list->sort_dir = PTK_LIST_SORT_DIR_FIRST;
         val = g_strdup_printf( "%d", PTK_LIST_SORT_DIR_FIRST );
-        xset_set_panel( panel, "sort_extra", "y", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_Y, val );
     }
     else if ( !strcmp( name, "files" ) )
     {
         list->sort_dir = PTK_LIST_SORT_DIR_LAST;
         val = g_strdup_printf( "%d", PTK_LIST_SORT_DIR_LAST );
-        xset_set_panel( panel, "sort_extra", "y", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_Y, val );
     }
     else if ( !strcmp( name, "mix" ) )
     {
         list->sort_dir = PTK_LIST_SORT_DIR_MIXED;
         val = g_strdup_printf( "%d", PTK_LIST_SORT_DIR_MIXED );
-        xset_set_panel( panel, "sort_extra", "y", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_Y, val );
     }
     else if ( !strcmp( name, "hidfirst" ) )
     {
         list->sort_hidden_first = set->b == XSET_B_TRUE;
         val = g_strdup_printf( "%d", set->b );
-        xset_set_panel( panel, "sort_extra", "z", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_Z, val );
     }
     else if ( !strcmp( name, "hidlast" ) )
     {
         list->sort_hidden_first = set->b != XSET_B_TRUE;
         val = g_strdup_printf( "%d", set->b == XSET_B_TRUE ?
                                                     XSET_B_FALSE : XSET_B_TRUE );
-        xset_set_panel( panel, "sort_extra", "z", val );
+        xset_set_panel( panel, "sort_extra", XSET_VAR_Z, val );
     }
     g_free( val );
     ptk_file_list_sort( list );
@@ -58,6 +58,7 @@ struct _PtkFileBrowser
     int n_sel_files;
     off_t sel_size;
     guint sel_change_idle;
+    guint thumbnail_scroll_timer;
     
     // path bar auto seek
     gboolean inhibit_focus;
@@ -94,6 +94,7 @@ static void ptk_file_list_set_default_sort_func( GtkTreeSortable *sortable,
                                                  GDestroyNotify destroy );
 
 //static void ptk_file_list_sort ( PtkFileList* list );  //sfm made non-static
+static void ptk_file_list_resort_rows( PtkFileList* list );
 
 /* signal handlers */
 
@@ -174,7 +175,10 @@ GType ptk_file_list_get_type ( void )
 void ptk_file_list_init ( PtkFileList *list )
 {
     list->n_files = 0;
-    list->files = NULL;
+    list->files = g_sequence_new( (GDestroyNotify)vfs_file_info_unref );
+    list->file_hash = g_hash_table_new( g_direct_hash, g_direct_equal );
+    list->resort_files = g_hash_table_new_full( g_direct_hash, g_direct_equal,
+                                (GDestroyNotify)vfs_file_info_unref, NULL );
     list->sort_order = -1;
     list->sort_col = -1;
     /* Random int to check whether an iter belongs to our model */
@@ -243,6 +247,9 @@ void ptk_file_list_finalize ( GObject *object )
     PtkFileList *list = ( PtkFileList* ) object;
 
     ptk_file_list_set_dir( list, NULL );
+    g_sequence_free( list->files );
+    g_hash_table_destroy( list->file_hash );
+    g_hash_table_destroy( list->resort_files );
     /* must chain up - finalize parent */
     ( * parent_class->finalize ) ( object );
 }
@@ -256,6 +263,15 @@ PtkFileList *ptk_file_list_new ( VFSDir* dir, gboolean show_hidden )
     return list;
 }
 
+static gboolean on_resort_timeout( PtkFileList* list )
+{
+    GDK_THREADS_ENTER();
+    list->resort_timeout = 0;
+    ptk_file_list_resort_rows( list );
+    GDK_THREADS_LEAVE();
+    return FALSE;
+}
+
 static void _ptk_file_list_file_changed( VFSDir* dir, VFSFileInfo* file,
                                         PtkFileList* list )
 {
@@ -264,9 +280,24 @@ static void _ptk_file_list_file_changed( VFSDir* dir, VFSFileInfo* file,
 
     ptk_file_list_file_changed( dir, file, list );
 
+    /* files listed by name only were sorted before their info arrived -
+     * move the rows whose info came in, a batch at a time */
+    if ( vfs_dir_is_loading_info( dir ) &&
+                            ( list->sort_col != COL_FILE_NAME ||
+                              list->sort_dir != PTK_LIST_SORT_DIR_MIXED ) )
+    {
+        g_hash_table_insert( list->resort_files, vfs_file_info_ref( file ),
+                                                                    NULL );
+        if ( !list->resort_timeout )
+            list->resort_timeout = g_timeout_add_full( G_PRIORITY_LOW, 500,
+                                        (GSourceFunc)on_resort_timeout,
+                                        list, NULL );
+    }
+
     /* check if reloading of thumbnail is needed.
      * See also desktop-window.c:on_file_changed() */
-    if ( list->max_thumbnail != 0 && (
+    if ( list->max_thumbnail != 0 &&
+            !( file->flags & VFS_FILE_INFO_PENDING ) && (
 #ifdef HAVE_FFMPEG
          ( vfs_file_info_is_video( file ) &&
            time( NULL ) - *vfs_file_info_get_mtime( file ) > 5 ) ||
@@ -280,31 +311,54 @@ static void _ptk_file_list_file_changed( VFSDir* dir, VFSFileInfo* file,
     }
 }
 
-static void _ptk_file_list_file_created( VFSDir* dir, VFSFileInfo* file,
-                                        PtkFileList* list )
+/* Files listed by name only have no size yet - their thumbnails are
+ * requested once the info is loaded and the file is changed */
+static gboolean can_show_thumbnail( PtkFileList* list, VFSFileInfo* file )
 {
-    ptk_file_list_file_created( dir, file, list );
-
-    /* check if reloading of thumbnail is needed. */
-    if ( list->max_thumbnail != 0 && (
+    return list->max_thumbnail != 0 &&
+             !( file->flags & VFS_FILE_INFO_PENDING ) && (
 #ifdef HAVE_FFMPEG
-         vfs_file_info_is_video( file ) ||
+             vfs_file_info_is_video( file ) ||
 #endif
-         ( file->size /*vfs_file_info_get_size( file )*/ < list->max_thumbnail
-                                    && vfs_file_info_is_image( file ) ) ) )
+             ( file->size /*vfs_file_info_get_size( file )*/ < list->max_thumbnail
+                                        && vfs_file_info_is_image( file ) ) );
+}
+
+static void _ptk_file_list_files_created( VFSDir* dir, GList* files,
+                                          PtkFileList* list )
+{
+    GList* l;
+    VFSFileInfo* file;
+
+    ptk_file_list_files_created( dir, files, list );
+
+    /* check if reloading of thumbnail is needed. */
+    for ( l = files; l; l = l->next )
     {
-        if( ! vfs_file_info_is_thumbnail_loaded( file, list->big_thumbnail ) )
-            vfs_thumbnail_loader_request( list->dir, file, list->big_thumbnail );
+        file = (VFSFileInfo*)l->data;
+        if ( can_show_thumbnail( list, file ) )
+        {
+            if( ! vfs_file_info_is_thumbnail_loaded( file, list->big_thumbnail ) )
+                vfs_thumbnail_loader_request( list->dir, file, list->big_thumbnail );
+        }
     }
 }
 
 void ptk_file_list_set_dir( PtkFileList* list, VFSDir* dir )
 {
     GList* l;
+    VFSFileInfo* file;
 
     if( list->dir == dir )
         return;
 
+    if ( list->resort_timeout )
+    {
+        g_source_remove( list->resort_timeout );
+        list->resort_timeout = 0;
+    }
+    g_hash_table_remove_all( list->resort_files );
+
     if ( list->dir )
     {
         if( list->max_thumbnail > 0 )
@@ -312,10 +366,11 @@ void ptk_file_list_set_dir( PtkFileList* list, VFSDir* dir )
             /* cancel all possible pending requests */
             vfs_thumbnail_loader_cancel_all_requests( list->dir, list->big_thumbnail );
         }
-        g_list_foreach( list->files, (GFunc)vfs_file_info_unref, NULL );
-        g_list_free( list->files );
+        g_hash_table_remove_all( list->file_hash );
+        g_sequence_remove_range( g_sequence_get_begin_iter( list->files ),
+                                 g_sequence_get_end_iter( list->files ) );
         g_signal_handlers_disconnect_by_func( list->dir,
-                                              _ptk_file_list_file_created, list );
+                                              _ptk_file_list_files_created, list );
         g_signal_handlers_disconnect_by_func( list->dir,
                                               ptk_file_list_file_deleted, list );
         g_signal_handlers_disconnect_by_func( list->dir,
@@ -326,15 +381,14 @@ void ptk_file_list_set_dir( PtkFileList* list, VFSDir* dir )
     }
 
     list->dir = dir;
-    list->files = NULL;
     list->n_files = 0;
     if( ! dir )
         return;
 
     g_object_ref( list->dir );
 
-    g_signal_connect( list->dir, "file-created",
-                      G_CALLBACK(_ptk_file_list_file_created),
+    g_signal_connect( list->dir, "files-created",
+                      G_CALLBACK(_ptk_file_list_files_created),
                       list );
     g_signal_connect( list->dir, "file-deleted",
                       G_CALLBACK(ptk_file_list_file_deleted),
@@ -347,10 +401,12 @@ void ptk_file_list_set_dir( PtkFileList* list, VFSDir* dir )
     {
         for( l = dir->file_list; l; l = l->next )
         {
-            if( list->show_hidden ||
-                    ((VFSFileInfo*)l->data)->disp_name[0] != '.' )
+            file = (VFSFileInfo*)l->data;
+            if( list->show_hidden || file->disp_name[0] != '.' )
             {
-                list->files = g_list_prepend( list->files, vfs_file_info_ref( (VFSFileInfo*)l->data) );
+                g_hash_table_insert( list->file_hash, file,
+                        g_sequence_prepend( list->files,
+                                            vfs_file_info_ref( file ) ) );
                 ++list->n_files;
             }
         }
@@ -382,7 +438,7 @@ gboolean ptk_file_list_get_iter ( GtkTreeModel *tree_model,
 {
     PtkFileList *list;
     gint *indices, n, depth;
-    GList* l;
+    GSequenceIter* l;
 
     g_assert(PTK_IS_FILE_LIST(tree_model));
     g_assert(path!=NULL);
@@ -400,14 +456,12 @@ gboolean ptk_file_list_get_iter ( GtkTreeModel *tree_model,
     if ( n >= list->n_files || n < 0 )
         return FALSE;
 
-    l = g_list_nth( list->files, n );
-
-    g_assert(l != NULL);
+    l = g_sequence_get_iter_at_pos( list->files, n );
 
     /* We simply store a pointer in the iter */
     iter->stamp = list->stamp;
     iter->user_data  = l;
-    iter->user_data2 = l->data;
+    iter->user_data2 = g_sequence_get( l );
     iter->user_data3 = NULL;   /* unused */
 
     return TRUE;
@@ -417,7 +471,7 @@ GtkTreePath *ptk_file_list_get_path ( GtkTreeModel *tree_model,
                                       GtkTreeIter *iter )
 {
     GtkTreePath* path;
-    GList* l;
+    GSequenceIter* l;
     PtkFileList* list = PTK_FILE_LIST(tree_model);
 
     g_return_val_if_fail (list, NULL);
@@ -425,10 +479,10 @@ GtkTreePath *ptk_file_list_get_path ( GtkTreeModel *tree_model,
     g_return_val_if_fail (iter != NULL, NULL);
     g_return_val_if_fail (iter->user_data != NULL, NULL);
 
-    l = (GList*) iter->user_data;
+    l = (GSequenceIter*) iter->user_data;
 
     path = gtk_tree_path_new();
-    gtk_tree_path_append_index(path, g_list_index(list->files, l->data) );
+    gtk_tree_path_append_index(path, g_sequence_iter_get_position( l ) );
     return path;
 }
 
@@ -437,7 +491,7 @@ void ptk_file_list_get_value ( GtkTreeModel *tree_model,
                                gint column,
                                GValue *value )
 {
-    GList* l;
+    GSequenceIter* l;
     PtkFileList* list = PTK_FILE_LIST(tree_model);
     VFSFileInfo* info;
     GdkPixbuf* icon;
@@ -448,11 +502,21 @@ void ptk_file_list_get_value ( GtkTreeModel *tree_model,
 
     g_value_init (value, column_types[column] );
 
-    l = (GList*) iter->user_data;
+    l = (GSequenceIter*) iter->user_data;
     g_return_if_fail ( l != NULL );
 
     info = (VFSFileInfo*)iter->user_data2;
 
+    if ( G_UNLIKELY( info->flags & VFS_FILE_INFO_PENDING ) )
+    {
+        /* only the name is known yet - this row is being shown, so load
+         * the rest next, and show nothing rather than bogus stat info */
+        vfs_dir_request_file_info( list->dir, info );
+        if ( column == COL_FILE_SIZE || column == COL_FILE_PERM ||
+                    column == COL_FILE_OWNER || column == COL_FILE_MTIME )
+            return;
+    }
+
     switch(column)
     {
     case COL_FILE_BIG_ICON:
@@ -523,7 +587,7 @@ void ptk_file_list_get_value ( GtkTreeModel *tree_model,
 gboolean ptk_file_list_iter_next ( GtkTreeModel *tree_model,
                                    GtkTreeIter *iter )
 {
-    GList* l;
+    GSequenceIter* l;
     PtkFileList* list;
 
     g_return_val_if_fail (PTK_IS_FILE_LIST (tree_model), FALSE);
@@ -532,15 +596,15 @@ gboolean ptk_file_list_iter_next ( GtkTreeModel *tree_model,
         return FALSE;
 
     list = PTK_FILE_LIST(tree_model);
-    l = (GList *) iter->user_data;
+    l = g_sequence_iter_next( (GSequenceIter *) iter->user_data );
 
     /* Is this the last l in the list? */
-    if ( ! l->next )
+    if ( g_sequence_iter_is_end( l ) )
         return FALSE;
 
     iter->stamp = list->stamp;
-    iter->user_data = l->next;
-    iter->user_data2 = l->next->data;
+    iter->user_data = l;
+    iter->user_data2 = g_sequence_get( l );
 
     return TRUE;
 }
@@ -561,13 +625,13 @@ gboolean ptk_file_list_iter_children ( GtkTreeModel *tree_model,
     list = PTK_FILE_LIST( tree_model );
 
     /* No rows => no first row */
-    if ( list->dir->n_files == 0 )
+    if ( list->n_files == 0 )
         return FALSE;
 
     /* Set iter to first item in list */
     iter->stamp = list->stamp;
-    iter->user_data = list->files;
-    iter->user_data2 = list->files->data;
+    iter->user_data = g_sequence_get_begin_iter( list->files );
+    iter->user_data2 = g_sequence_get( iter->user_data );
     return TRUE;
 }
 
@@ -595,7 +659,7 @@ gboolean ptk_file_list_iter_nth_child ( GtkTreeModel *tree_model,
                                         GtkTreeIter *parent,
                                         gint n )
 {
-    GList* l;
+    GSequenceIter* l;
     PtkFileList* list;
 
     g_return_val_if_fail (PTK_IS_FILE_LIST (tree_model), FALSE);
@@ -609,12 +673,11 @@ gboolean ptk_file_list_iter_nth_child ( GtkTreeModel *tree_model,
     if( n >= list->n_files || n < 0 )
         return FALSE;
 
-    l = g_list_nth( list->files, n );
-    g_assert( l != NULL );
+    l = g_sequence_get_iter_at_pos( list->files, n );
 
     iter->stamp = list->stamp;
     iter->user_data = l;
-    iter->user_data2 = l->data;
+    iter->user_data2 = g_sequence_get( l );
 
     return TRUE;
 }
@@ -740,10 +803,10 @@ static gint ptk_file_list_compare( gconstpointer a,
     if ( list->sort_natural )
     {
         // natural
-        if ( list->sort_case )
-            result = strcmp( file_a->collate_key, file_b->collate_key );
-        else
-            result = strcmp( file_a->collate_icase_key, file_b->collate_icase_key );
+        result = strcmp( vfs_file_info_get_collate_key( file_a,
+                                                        !list->sort_case ),
+                         vfs_file_info_get_collate_key( file_b,
+                                                        !list->sort_case ) );
     }
     else
     {
@@ -813,24 +876,25 @@ void ptk_file_list_sort ( PtkFileList* list )
     GHashTable* old_order;
     gint *new_order;
     GtkTreePath *path;
-    GList* l;
+    GSequenceIter* l;
     int i;
 
     if( list->n_files <=1 )
         return;
 
     old_order = g_hash_table_new( g_direct_hash, g_direct_equal );
-    /* save old order */
-    for( i = 0, l = list->files; l; l = l->next, ++i )
+    /* save old order - sorting moves the nodes, so iters stay valid */
+    for( i = 0, l = g_sequence_get_begin_iter( list->files );
+                !g_sequence_iter_is_end( l ); l = g_sequence_iter_next( l ), ++i )
         g_hash_table_insert( old_order, l, GINT_TO_POINTER(i) );
 
     /* sort the list */
-    list->files = g_list_sort_with_data( list->files,
-                                         ptk_file_list_compare, list );
+    g_sequence_sort( list->files, ptk_file_list_compare, list );
 
     /* save new order */
     new_order = g_new( int, list->n_files );
-    for( i = 0, l = list->files; l; l = l->next, ++i )
+    for( i = 0, l = g_sequence_get_begin_iter( list->files );
+                !g_sequence_iter_is_end( l ); l = g_sequence_iter_next( l ), ++i )
         new_order[i] = GPOINTER_TO_INT( g_hash_table_lookup( old_order, l ) );
     g_hash_table_destroy( old_order );
     path = gtk_tree_path_new ();
@@ -842,12 +906,24 @@ void ptk_file_list_sort ( PtkFileList* list )
 
 gboolean ptk_file_list_find_iter(  PtkFileList* list, GtkTreeIter* it, VFSFileInfo* fi )
 {
-    GList* l;
-    for( l = list->files; l; l = l->next )
+    GSequenceIter* l;
+    VFSFileInfo* fi2;
+
+    if( G_LIKELY( ( l = g_hash_table_lookup( list->file_hash, fi ) ) ) )
     {
-        VFSFileInfo* fi2 = (VFSFileInfo*)l->data;
-        if( G_UNLIKELY( fi2 == fi
-            || 0 == strcmp( vfs_file_info_get_name(fi), vfs_file_info_get_name(fi2) ) ) )
+        it->stamp = list->stamp;
+        it->user_data = l;
+        it->user_data2 = fi;
+        return TRUE;
+    }
+
+    /* not the same VFSFileInfo - look for a file of the same name */
+    for( l = g_sequence_get_begin_iter( list->files );
+                !g_sequence_iter_is_end( l ); l = g_sequence_iter_next( l ) )
+    {
+        fi2 = (VFSFileInfo*)g_sequence_get( l );
+        if( G_UNLIKELY( 0 == strcmp( vfs_file_info_get_name(fi),
+                                     vfs_file_info_get_name(fi2) ) ) )
         {
             it->stamp = list->stamp;
             it->user_data = l;
@@ -858,87 +934,185 @@ gboolean ptk_file_list_find_iter(  PtkFileList* list, GtkTreeIter* it, VFSFileIn
     return FALSE;
 }
 
-void ptk_file_list_file_created( VFSDir* dir,
-                                 VFSFileInfo* file,
-                                 PtkFileList* list )
+/* Returns TRUE if file, or another file of the same name, is already a row.
+ * Only the rows comparing equal to file can share its name, and those sit
+ * right before its sorted insertion point pos.  Desktop entries are the
+ * exception - they sort by their Name=, which an older row of the same file
+ * may not share, so all rows are checked for them. */
+static gboolean ptk_file_list_is_duplicate( PtkFileList* list,
+                                            GSequenceIter* pos,
+                                            VFSFileInfo* file )
 {
-    GList* l, *ll = NULL;
-    GtkTreeIter it;
-    GtkTreePath* path;
     VFSFileInfo* file2;
-    
-    if( ! list->show_hidden && vfs_file_info_get_name(file)[0] == '.' )
-        return;
 
-    gboolean is_desktop = vfs_file_info_is_desktop_entry( file ); //sfm
-    gboolean is_desktop2;
-    
-    for( l = list->files; l; l = l->next )
+    if( G_UNLIKELY( g_hash_table_lookup( list->file_hash, file ) ) )
+        return TRUE;
+
+    // by suffix - a pending file isn't flagged as a desktop entry yet
+    if ( file->name && g_str_has_suffix( file->name, ".desktop" ) )
     {
-        file2 = (VFSFileInfo*)l->data;
-        if( G_UNLIKELY( file == file2 ) )
-        {
-            /* The file is already in the list */
-            return;
-        }
-        
-        is_desktop2 = vfs_file_info_is_desktop_entry( file2 );
-        if ( is_desktop || is_desktop2 )
-        {
-            // at least one is a desktop file, need to compare filenames
-            if ( file->name && file2->name )
-            {
-                if ( !strcmp( file->name, file2->name ) )
-                    return;
-            }
-        }
-        else if ( ptk_file_list_compare( file2, file, list ) == 0 )
+        for ( pos = g_sequence_get_begin_iter( list->files );
+                    !g_sequence_iter_is_end( pos );
+                    pos = g_sequence_iter_next( pos ) )
         {
-            // disp_name matches ?
-            // ptk_file_list_compare may return 0 on differing display names
-            // if case-insensitive - need to compare filenames
-            if ( list->sort_natural && list->sort_case )
-                return;
-            else if ( !strcmp( file->name, file2->name ) )
-                return;
+            file2 = (VFSFileInfo*)g_sequence_get( pos );
+            if ( file2->name && !strcmp( file->name, file2->name ) )
+                return TRUE;
         }
+        return FALSE;
+    }
 
-        if ( !ll && ptk_file_list_compare( file2, file, list ) > 0 )
-        {
-            if ( !is_desktop && !is_desktop2 )
-                break;
-            else
-                ll = l; // store insertion location based on disp_name
-        }
+    while ( !g_sequence_iter_is_begin( pos ) )
+    {
+        pos = g_sequence_iter_prev( pos );
+        file2 = (VFSFileInfo*)g_sequence_get( pos );
+        if ( ptk_file_list_compare( file2, file, list ) != 0 )
+            break;
+        if ( file->name && file2->name && !strcmp( file->name, file2->name ) )
+            return TRUE;
     }
+    return FALSE;
+}
 
-    if ( ll )
-        l = ll;
+/* Insert file before pos, which is at row index n, and notify the view */
+static void ptk_file_list_insert_row( PtkFileList* list, GSequenceIter* pos,
+                                      gint n, VFSFileInfo* file )
+{
+    GtkTreeIter it;
+    GtkTreePath* path;
 
-    list->files = g_list_insert_before( list->files, l, vfs_file_info_ref( file ) );
+    pos = g_sequence_insert_before( pos, vfs_file_info_ref( file ) );
+    g_hash_table_insert( list->file_hash, file, pos );
     ++list->n_files;
 
-    if( l )
-        l = l->prev;
-    else
-        l = g_list_last( list->files );
-
     it.stamp = list->stamp;
-    it.user_data = l;
+    it.user_data = pos;
     it.user_data2 = file;
 
-    path = gtk_tree_path_new_from_indices( g_list_index(list->files, l->data), -1 );
+    path = gtk_tree_path_new_from_indices( n, -1 );
 
     gtk_tree_model_row_inserted( GTK_TREE_MODEL(list), path, &it );
 
     gtk_tree_path_free( path );
 }
 
-void ptk_file_list_file_deleted( VFSDir* dir,
+/* Move the rows of the files in resort_files to where they sort now.  All
+ * of them are taken out first, as the binary search for where one goes
+ * needs the rest of the rows in order.  Each is deleted and inserted again,
+ * like a file deleted and created */
+static void ptk_file_list_resort_rows( PtkFileList* list )
+{
+    GHashTableIter it;
+    gpointer file;
+    GSequenceIter* l;
+    GtkTreePath* path;
+
+    g_hash_table_iter_init( &it, list->resort_files );
+    while ( g_hash_table_iter_next( &it, &file, NULL ) )
+    {
+        l = g_hash_table_lookup( list->file_hash, file );
+        if ( !l )
+        {
+            g_hash_table_iter_remove( &it );
+            continue;
+        }
+        path = gtk_tree_path_new_from_indices( g_sequence_iter_get_position( l ), -1 );
+        gtk_tree_model_row_deleted( GTK_TREE_MODEL(list), path );
+        gtk_tree_path_free( path );
+
+        // resort_files still holds a ref
+        g_hash_table_remove( list->file_hash, file );
+        g_sequence_remove( l );
+        --list->n_files;
+    }
+
+    g_hash_table_iter_init( &it, list->resort_files );
+    while ( g_hash_table_iter_next( &it, &file, NULL ) )
+    {
+        l = g_sequence_search( list->files, file, ptk_file_list_compare, list );
+        ptk_file_list_insert_row( list, l, g_sequence_iter_get_position( l ),
+                                  (VFSFileInfo*)file );
+    }
+    g_hash_table_remove_all( list->resort_files );
+}
+
+void ptk_file_list_file_created( VFSDir* dir,
                                  VFSFileInfo* file,
                                  PtkFileList* list )
+{
+    GSequenceIter* pos;
+
+    if( ! list->show_hidden && vfs_file_info_get_name(file)[0] == '.' )
+        return;
+
+    /* binary search for the first row sorting after file */
+    pos = g_sequence_search( list->files, file, ptk_file_list_compare, list );
+    if ( ptk_file_list_is_duplicate( list, pos, file ) )
+        return;
+
+    ptk_file_list_insert_row( list, pos, g_sequence_iter_get_position( pos ),
+                              file );
+}
+
+void ptk_file_list_files_created( VFSDir* dir,
+                                  GList* files,
+                                  PtkFileList* list )
 {
     GList* l;
+    GList* sorted = NULL;
+    GSequenceIter* pos;
+    VFSFileInfo* file;
+    guint n_new = 0;
+    gint n;
+
+    for ( l = files; l; l = l->next )
+    {
+        file = (VFSFileInfo*)l->data;
+        if( list->show_hidden || vfs_file_info_get_name(file)[0] != '.' )
+        {
+            sorted = g_list_prepend( sorted, file );
+            ++n_new;
+        }
+    }
+    if ( !sorted )
+        return;
+
+    if ( n_new * g_bit_storage( list->n_files ) < list->n_files )
+    {
+        /* a few files into a big list - binary search each one */
+        for ( l = sorted; l; l = l->next )
+            ptk_file_list_file_created( dir, (VFSFileInfo*)l->data, list );
+    }
+    else
+    {
+        /* merge the sorted run of new files in a single pass, tracking the
+         * row index as we go so no position lookups are needed */
+        sorted = g_list_sort_with_data( sorted, ptk_file_list_compare, list );
+        pos = g_sequence_get_begin_iter( list->files );
+        n = 0;
+        for ( l = sorted; l; l = l->next )
+        {
+            file = (VFSFileInfo*)l->data;
+            while ( !g_sequence_iter_is_end( pos ) &&
+                    ptk_file_list_compare( g_sequence_get( pos ), file, list ) <= 0 )
+            {
+                pos = g_sequence_iter_next( pos );
+                ++n;
+            }
+            if ( ptk_file_list_is_duplicate( list, pos, file ) )
+                continue;
+            ptk_file_list_insert_row( list, pos, n, file );
+            ++n;
+        }
+    }
+    g_list_free( sorted );
+}
+
+void ptk_file_list_file_deleted( VFSDir* dir,
+                                 VFSFileInfo* file,
+                                 PtkFileList* list )
+{
+    GSequenceIter* l;
     GtkTreePath* path;
 
     /* If there is no file info, that means the dir itself was deleted. */
@@ -946,12 +1120,12 @@ void ptk_file_list_file_deleted( VFSDir* dir,
     {
         /* Clear the whole list */
         path = gtk_tree_path_new_from_indices(0, -1);
-        for( l = list->files; l; l = list->files )
+        while( list->n_files > 0 )
         {
             gtk_tree_model_row_deleted( GTK_TREE_MODEL(list), path );
-            file = (VFSFileInfo*)l->data;
-            list->files = g_list_delete_link( list->files, l );
-            vfs_file_info_unref( file );
+            l = g_sequence_get_begin_iter( list->files );
+            g_hash_table_remove( list->file_hash, g_sequence_get( l ) );
+            g_sequence_remove( l );  /* unrefs file */
             --list->n_files;
         }
         gtk_tree_path_free( path );
@@ -961,18 +1135,23 @@ void ptk_file_list_file_deleted( VFSDir* dir,
     if( ! list->show_hidden && vfs_file_info_get_name(file)[0] == '.' )
         return;
 
-    l = g_list_find( list->files, file );
+    l = g_hash_table_lookup( list->file_hash, file );
     if( ! l )
         return;
 
-    path = gtk_tree_path_new_from_indices( g_list_index(list->files, l->data), -1 );
+    path = gtk_tree_path_new_from_indices( g_sequence_iter_get_position( l ), -1 );
 
     gtk_tree_model_row_deleted( GTK_TREE_MODEL(list), path );
 
     gtk_tree_path_free( path );
 
-    list->files = g_list_delete_link( list->files, l );
-    vfs_file_info_unref( file );
+    /* a thumbnail not loaded yet would never be shown */
+    if( list->max_thumbnail > 0 )
+        vfs_thumbnail_loader_cancel_request( list->dir, file,
+                                             list->big_thumbnail );
+
+    g_hash_table_remove( list->file_hash, file );
+    g_sequence_remove( l );  /* unrefs file */
     --list->n_files;
 }
 
@@ -980,22 +1159,22 @@ void ptk_file_list_file_changed( VFSDir* dir,
                                  VFSFileInfo* file,
                                  PtkFileList* list )
 {
-    GList* l;
+    GSequenceIter* l;
     GtkTreeIter it;
     GtkTreePath* path;
 
     if( ! list->show_hidden && vfs_file_info_get_name(file)[0] == '.' )
         return;
-    l = g_list_find( list->files, file );
+    l = g_hash_table_lookup( list->file_hash, file );
 
     if( ! l )
         return;
 
     it.stamp = list->stamp;
     it.user_data = l;
-    it.user_data2 = l->data;
+    it.user_data2 = file;
 
-    path = gtk_tree_path_new_from_indices( g_list_index(list->files, l->data), -1 );
+    path = gtk_tree_path_new_from_indices( g_sequence_iter_get_position( l ), -1 );
 
     gtk_tree_model_row_changed( GTK_TREE_MODEL(list), path, &it );
 
@@ -1011,7 +1190,7 @@ void on_thumbnail_loaded( VFSDir* dir, VFSFileInfo* file, PtkFileList* list )
 void ptk_file_list_show_thumbnails( PtkFileList* list, gboolean is_big,
                                     int max_file_size )
 {
-    GList* l;
+    GSequenceIter* l;
     VFSFileInfo* file;
     int old_max_thumbnail;
 
@@ -1030,9 +1209,10 @@ void ptk_file_list_show_thumbnails( PtkFileList* list, gboolean is_big,
             vfs_thumbnail_loader_cancel_all_requests( list->dir, list->big_thumbnail );
             g_signal_handlers_disconnect_by_func( list->dir, on_thumbnail_loaded, list );
 
-            for( l = list->files; l; l = l->next )
+            for( l = g_sequence_get_begin_iter( list->files );
+                        !g_sequence_iter_is_end( l ); l = g_sequence_iter_next( l ) )
             {
-                file = (VFSFileInfo*)l->data;
+                file = (VFSFileInfo*)g_sequence_get( l );
                 if ( ( vfs_file_info_is_image( file )
 #ifdef HAVE_FFMPEG
                        || vfs_file_info_is_video( file )
@@ -1054,15 +1234,11 @@ void ptk_file_list_show_thumbnails( PtkFileList* list, gboolean is_big,
     g_signal_connect( list->dir, "thumbnail-loaded",
                                     G_CALLBACK(on_thumbnail_loaded), list );
 
-    for( l = list->files; l; l = l->next )
+    for( l = g_sequence_get_begin_iter( list->files );
+                !g_sequence_iter_is_end( l ); l = g_sequence_iter_next( l ) )
     {
-        file = (VFSFileInfo*)l->data;
-        if ( list->max_thumbnail != 0 && (
-#ifdef HAVE_FFMPEG
-             vfs_file_info_is_video( file ) ||
-#endif
-             ( file->size /*vfs_file_info_get_size( file )*/ < list->max_thumbnail
-                                        && vfs_file_info_is_image( file ) ) ) )
+        file = (VFSFileInfo*)g_sequence_get( l );
+        if ( can_show_thumbnail( list, file ) )
         {
             if( vfs_file_info_is_thumbnail_loaded( file, is_big ) )
                 ptk_file_list_file_changed( list->dir, file, list );
@@ -1074,3 +1250,26 @@ void ptk_file_list_show_thumbnails( PtkFileList* list, gboolean is_big,
         }
     }
 }
+
+void ptk_file_list_prioritize_thumbnails( PtkFileList* list, int first,
+                                                             int last )
+{
+    GSequenceIter* l;
+    GList* files = NULL;
+    VFSFileInfo* file;
+
+    if ( !list->dir || list->max_thumbnail == 0 )
+        return;
+    l = g_sequence_get_iter_at_pos( list->files, first );
+    for( ; first <= last && !g_sequence_iter_is_end( l );
+                                    ++first, l = g_sequence_iter_next( l ) )
+    {
+        file = (VFSFileInfo*)g_sequence_get( l );
+        if ( can_show_thumbnail( list, file ) &&
+                !vfs_file_info_is_thumbnail_loaded( file, list->big_thumbnail ) )
+            files = g_list_prepend( files, file );
+    }
+    files = g_list_reverse( files );
+    vfs_thumbnail_loader_prioritize( list->dir, files, list->big_thumbnail );
+    g_list_free( files );
+}
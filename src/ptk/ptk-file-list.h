@@ -60,7 +60,8 @@ struct _PtkFileList
     GObject parent;
     /* <private> */
     VFSDir* dir;
-    GList* files;
+    GSequence* files;  /* rows; each iter's user_data is a GSequenceIter */
+    GHashTable* file_hash;  /* VFSFileInfo* -> GSequenceIter* in files */
     guint n_files;
 
     gboolean show_hidden : 1;
@@ -73,6 +74,8 @@ struct _PtkFileList
     gboolean sort_case;  //sfm
     gboolean sort_hidden_first;  //sfm
     char sort_dir;  //sfm
+    guint resort_timeout;  /* re-sort while the dir is loading file info */
+    GHashTable* resort_files;  /* refs of rows whose info came in since */
     /* Random integer to check whether an iter belongs to our model */
     gint stamp;
 };
@@ -98,6 +101,9 @@ gboolean ptk_file_list_find_iter(  PtkFileList* list, GtkTreeIter* it, VFSFileIn
 void ptk_file_list_file_created( VFSDir* dir, VFSFileInfo* file,
                                         PtkFileList* list );
 
+void ptk_file_list_files_created( VFSDir* dir, GList* files,
+                                        PtkFileList* list );
+
 void ptk_file_list_file_deleted( VFSDir* dir, VFSFileInfo* file,
                                         PtkFileList* list );
 
@@ -106,6 +112,9 @@ void ptk_file_list_file_changed( VFSDir* dir, VFSFileInfo* file,
 
 void ptk_file_list_show_thumbnails( PtkFileList* list, gboolean is_big,
                                     int max_file_size );
+/* Load the thumbnails of rows first to last before the others */
+void ptk_file_list_prioritize_thumbnails( PtkFileList* list, int first,
+                                                             int last );
 void ptk_file_list_sort ( PtkFileList* list );   //sfm 
 
 G_END_DECLS
@@ -321,14 +321,14 @@ void on_popup_sortby( GtkMenuItem *menuitem, PtkFileBrowser* file_browser, int o
         else
             v = GTK_SORT_DESCENDING;
         val = g_strdup_printf( "%d", v );
-        xset_set_panel( file_browser->mypanel, "list_detailed", "y", val );
+        xset_set_panel( file_browser->mypanel, "list_detailed", XSET_VAR_Y, val );
         g_free( val );
         ptk_file_browser_set_sort_type( file_browser, v );
     }
     else
     {
         val = g_strdup_printf( "%d", sort_order );
-        xset_set_panel( file_browser->mypanel, "list_detailed", "x", val );
+        xset_set_panel( file_browser->mypanel, "list_detailed", XSET_VAR_X, val );
         g_free( val );    
         ptk_file_browser_set_sort_order( file_browser, sort_order );
     }
@@ -553,18 +553,18 @@ void ptk_file_menu_add_panel_view_menu( PtkFileBrowser* browser,
         set->b = xset_get_panel_mode( p, "detcol_date", mode )->b;
 
         xset_set_cb( "view_reorder_col", on_reorder, browser );
-        set = xset_set( "view_columns", "disable", "0" );
+        set = xset_set( "view_columns", XSET_VAR_DISABLE, "0" );
         desc = g_strdup_printf( "panel%d_detcol_size panel%d_detcol_type panel%d_detcol_perm panel%d_detcol_owner panel%d_detcol_date sep_v4 view_reorder_col",
                                                         p, p, p, p, p );
-        xset_set_set( set, "desc", desc );
+        xset_set_set( set, XSET_VAR_DESC, desc );
         g_free( desc );
         set = xset_set_cb( "rubberband", main_window_rubberband_all, NULL );
         set->disable = FALSE;
     }
     else
     {
-        xset_set( "view_columns", "disable", "1" );
-        xset_set( "rubberband", "disable", "1" );
+        xset_set( "view_columns", XSET_VAR_DISABLE, "1" );
+        xset_set( "rubberband", XSET_VAR_DISABLE, "1" );
     }
 
     set = xset_set_cb( "view_thumb", main_window_toggle_thumbnails_all_windows,
@@ -678,18 +678,18 @@ void ptk_file_menu_add_panel_view_menu( PtkFileBrowser* browser,
     set = xset_get( "view_list_style" );
     desc = g_strdup_printf( "panel%d_list_detailed panel%d_list_compact panel%d_list_icons sep_v5 view_thumb panel%d_list_large rubberband sep_v6 panel%d_font_file",
                                     p, p, p, p, p );
-    xset_set_set( set, "desc", desc );
+    xset_set_set( set, XSET_VAR_DESC, desc );
     g_free( desc );
     set = xset_get( "view_fonts" );
     desc = g_strdup_printf( "panel%d_font_device panel%d_font_dir panel%d_font_book panel%d_font_files panel%d_font_tabs panel%d_font_status panel%d_font_pathbar",
                                     p, p, p, p, p, p ,p );
-    xset_set_set( set, "desc", desc );
+    xset_set_set( set, XSET_VAR_DESC, desc );
     g_free( desc );
     set = xset_get( "con_view" );
     set->disable = !browser->file_list;
     desc = g_strdup_printf( "panel%d_show_toolbox panel%d_show_sidebar panel%d_show_devmon panel%d_show_book panel%d_show_dirtree sep_v7 panel%d_show_hidden view_list_style view_sortby view_columns sep_v8 view_refresh",
                                     p, p, p, p, p, p );
-    xset_set_set( set, "desc", desc );
+    xset_set_set( set, XSET_VAR_DESC, desc );
     g_free( desc );
     xset_add_menuitem( NULL, browser, menu, accel_group, set );
 }
@@ -1282,7 +1282,7 @@ GtkWidget* ptk_file_menu_new( DesktopWindow* desktop, PtkFileBrowser* browser,
             xset_set_cb( "new_app", on_popup_desktop_new_app_activate, desktop );
 
             set = xset_get( "open_new" );
-            xset_set_set( set, "desc", "new_file new_folder new_link new_archive sep_o1 new_app" );
+            xset_set_set( set, XSET_VAR_DESC, "new_file new_folder new_link new_archive sep_o1 new_app" );
         }
         else
         {
@@ -1294,7 +1294,7 @@ GtkWidget* ptk_file_menu_new( DesktopWindow* desktop, PtkFileBrowser* browser,
             set->disable = !browser;
 
             set = xset_get( "open_new" );
-            xset_set_set( set, "desc", "new_file new_folder new_link new_archive sep_o1 tab_new tab_new_here new_bookmark" );
+            xset_set_set( set, XSET_VAR_DESC, "new_file new_folder new_link new_archive sep_o1 tab_new tab_new_here new_bookmark" );
         }
         xset_add_menuitem( desktop, browser, popup, accel_group, set );
 
@@ -1588,7 +1588,7 @@ GtkWidget* ptk_file_menu_new( DesktopWindow* desktop, PtkFileBrowser* browser,
             desc = g_strdup_printf( "prop_info prop_perm prop_root" );
         else
             desc = g_strdup_printf( "prop_info prop_perm prop_quick prop_root" );
-        xset_set_set( set, "desc", desc );
+        xset_set_set( set, XSET_VAR_DESC, desc );
         g_free( desc );
         xset_add_menuitem( desktop, browser, popup, accel_group, set );
     }
@@ -956,8 +956,8 @@ void on_create_browse_button_press( GtkWidget* widget, MoveSet* mset )
     g_free( dir );
     g_free( name );
 
-    int width = xset_get_int( "move_dlg_help", "x" );
-    int height = xset_get_int( "move_dlg_help", "y" );
+    int width = xset_get_int( "move_dlg_help", XSET_VAR_X );
+    int height = xset_get_int( "move_dlg_help", XSET_VAR_Y );
     if ( width && height )
     {
         // filechooser won't honor default size or size request ?
@@ -1002,10 +1002,10 @@ void on_create_browse_button_press( GtkWidget* widget, MoveSet* mset )
     if ( width && height )
     {
         char* str = g_strdup_printf( "%d", width );
-        xset_set( "move_dlg_help", "x", str );
+        xset_set( "move_dlg_help", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "move_dlg_help", "y", str );
+        xset_set( "move_dlg_help", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -1056,7 +1056,7 @@ void on_browse_button_press( GtkWidget* widget, MoveSet* mset )
     
     XSet* set = xset_get( "move_dlg_help" );
     if ( set->z )
-        mode_default = xset_get_int( "move_dlg_help", "z" );
+        mode_default = xset_get_int( "move_dlg_help", XSET_VAR_Z );
 
     // action create folder does not work properly so not used:
     //  it creates a folder by default with no way to stop it
@@ -1115,8 +1115,8 @@ void on_browse_button_press( GtkWidget* widget, MoveSet* mset )
     g_object_set_data( G_OBJECT( dlg ), "mode", mode );
     gtk_widget_show_all( hbox );
 
-    int width = xset_get_int( "move_dlg_help", "x" );
-    int height = xset_get_int( "move_dlg_help", "y" );
+    int width = xset_get_int( "move_dlg_help", XSET_VAR_X );
+    int height = xset_get_int( "move_dlg_help", XSET_VAR_Y );
     if ( width && height )
     {
         // filechooser won't honor default size or size request ?
@@ -1168,10 +1168,10 @@ void on_browse_button_press( GtkWidget* widget, MoveSet* mset )
     if ( width && height )
     {
         str = g_strdup_printf( "%d", width );
-        xset_set( "move_dlg_help", "x", str );
+        xset_set( "move_dlg_help", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "move_dlg_help", "y", str );
+        xset_set( "move_dlg_help", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -1181,7 +1181,7 @@ void on_browse_button_press( GtkWidget* widget, MoveSet* mset )
         if ( gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( mode[i] ) ) )
         {
             str = g_strdup_printf( "%d", i );
-            xset_set( "move_dlg_help", "z", str );
+            xset_set( "move_dlg_help", XSET_VAR_Z, str );
             g_free( str );
             break;
         }
@@ -2214,8 +2214,8 @@ int ptk_rename_file( DesktopWindow* desktop, PtkFileBrowser* file_browser,
         mset->open = NULL;
 
     // Window
-    int width = xset_get_int( "move_dlg_font", "x" );
-    int height = xset_get_int( "move_dlg_font", "y" );
+    int width = xset_get_int( "move_dlg_font", XSET_VAR_X );
+    int height = xset_get_int( "move_dlg_font", XSET_VAR_Y );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( mset->dlg ), width, height );
     else
@@ -2740,7 +2740,7 @@ int ptk_rename_file( DesktopWindow* desktop, PtkFileBrowser* file_browser,
 
     /* instead of using last used widget, just use first visible
     // last widget
-    int last = xset_get_int( "move_dlg_font", "z" );
+    int last = xset_get_int( "move_dlg_font", XSET_VAR_Z );
     if ( last == 1 )
         mset->last_widget = mset->input_name;
     else if ( last == 2 )
@@ -3272,10 +3272,10 @@ _continue_free:
     if ( width && height )
     {
         str = g_strdup_printf( "%d", width );
-        xset_set( "move_dlg_font", "x", str );
+        xset_set( "move_dlg_font", XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "move_dlg_font", "y", str );
+        xset_set( "move_dlg_font", XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -3292,7 +3292,7 @@ _continue_free:
     else
         last = 0;
     str = g_strdup_printf( "%d", last );
-    xset_set( "move_dlg_font", "z", str );
+    xset_set( "move_dlg_font", XSET_VAR_Z, str );
     g_free( str );
     
     // destroy
@@ -4127,7 +4127,7 @@ void ptk_file_misc_rootcmd( DesktopWindow* desktop, PtkFileBrowser* file_browser
                                                 _("Choose Location"), folder, NULL );
         if ( path && g_file_test( path, G_FILE_TEST_IS_DIR ) )
         {
-            xset_set_set( set, "desc", path );
+            xset_set_set( set, XSET_VAR_DESC, path );
             char* quote_path = bash_quote( path );
             
             if ( !strcmp( setname, "root_move2" ) )
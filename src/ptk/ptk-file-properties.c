@@ -32,6 +32,7 @@
 #include "ptk-utils.h"
 
 #include "vfs-file-info.h"
+#include "vfs-dir-size.h"
 #include "vfs-app-desktop.h"
 #include "ptk-app-chooser.h"
 #include "main-window.h"
@@ -83,63 +84,18 @@ on_dlg_response ( GtkDialog *dialog,
                                 gint response_id,
                                 gpointer user_data );
 
-/*
-* void get_total_size_of_dir( const char* path, off_t* size )
-* Recursively count total size of all files in the specified directory.
-* If the path specified is a file, the size of the file is directly returned.
-* cancel is used to cancel the operation. This function will check the value
-* pointed by cancel in every iteration. If cancel is set to TRUE, the
-* calculation is cancelled.
-* NOTE: path is encoded in on-disk encoding and not necessarily UTF-8.
-*/
-static void calc_total_size_of_files( const char* path, FilePropertiesDialogData* data )
-{
-    GDir * dir;
-    const char* name;
-    char* full_path;
-    struct stat64 file_stat;
-
-    if ( data->cancel )
-        return ;
-
-    if ( lstat64( path, &file_stat ) )
-        return ;
-
-    data->total_size += file_stat.st_size;
-    data->size_on_disk += ( file_stat.st_blocks << 9 ); /* block x 512 */
-
-    dir = g_dir_open( path, 0, NULL );
-    if ( dir )
-    {
-        ++data->total_count_dir;
-        while ( !data->cancel && ( name = g_dir_read_name( dir ) ) )
-        {
-            full_path = g_build_filename( path, name, NULL );
-            lstat64( full_path, &file_stat );
-            if ( S_ISDIR( file_stat.st_mode ) )
-            {
-                calc_total_size_of_files( full_path, data );
-            }
-            else
-            {
-                data->total_size += file_stat.st_size;
-                data->size_on_disk += ( file_stat.st_blocks << 9 );
-                ++data->total_count;
-            }
-            g_free( full_path );
-        }
-        g_dir_close( dir );
-    }
-    else
-        ++data->total_count;
-}
-
 static gpointer calc_size( gpointer user_data )
 {
     FilePropertiesDialogData * data = ( FilePropertiesDialogData* ) user_data;
+    VFSDirSize* size_scan;
+    VFSDirSizeTotals totals;
+    gboolean done = FALSE;
     GList* l;
     char* path;
     VFSFileInfo* file;
+    struct stat64 st, target;
+
+    size_scan = vfs_dir_size_new();
     for ( l = data->file_list; l; l = l->next )
     {
         if ( data->cancel )
@@ -147,12 +103,28 @@ static gpointer calc_size( gpointer user_data )
         file = ( VFSFileInfo* ) l->data;
         path = g_build_filename( data->dir_path,
                                  vfs_file_info_get_name( file ), NULL );
-        if ( path )
+        if ( path && lstat64( path, &st ) == 0 )
         {
-            calc_total_size_of_files( path, data );
-            g_free( path );
+            // a selected link to a dir counts what's in the dir, but links
+            // inside the tree are counted as links
+            if ( S_ISLNK( st.st_mode ) && stat64( path, &target ) == 0 &&
+                                            S_ISDIR( target.st_mode ) )
+                st = target;
+            vfs_dir_size_add( size_scan, path, &st );
         }
+        g_free( path );
+    }
+    // update the totals as they grow
+    while ( !done && !data->cancel )
+    {
+        done = vfs_dir_size_wait( size_scan, 100 );
+        vfs_dir_size_get_totals( size_scan, &totals );
+        data->total_size = totals.size;
+        data->size_on_disk = totals.size_on_disk;
+        data->total_count = totals.n_files;
+        data->total_count_dir = totals.n_dirs;
     }
+    vfs_dir_size_free( size_scan );
     data->done = TRUE;
     return NULL;
 }
@@ -366,8 +338,8 @@ GtkWidget* file_properties_dlg_new( GtkWindow* parent,
     gtk_dialog_set_alternative_button_order( GTK_DIALOG(dlg), GTK_RESPONSE_OK, GTK_RESPONSE_CANCEL, -1 );
     ptk_dialog_fit_small_screen( GTK_DIALOG(dlg) );
 
-    int width = xset_get_int( "app_dlg", "s" );
-    int height = xset_get_int( "app_dlg", "z" );
+    int width = xset_get_int( "app_dlg", XSET_VAR_S );
+    int height = xset_get_int( "app_dlg", XSET_VAR_Z );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( dlg ), width, -1 );
 
@@ -784,10 +756,10 @@ on_dlg_response ( GtkDialog *dialog,
     if ( width && height )
     {
         char* str = g_strdup_printf( "%d", width );
-        xset_set( "app_dlg", "s", str );
+        xset_set( "app_dlg", XSET_VAR_S, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( "app_dlg", "z", str );
+        xset_set( "app_dlg", XSET_VAR_Z, str );
         g_free( str );
     }
 
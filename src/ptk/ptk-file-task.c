@@ -166,16 +166,16 @@ void save_progress_dialog_size( PtkFileTask* ptask )
 
     s = g_strdup_printf( "%d", allocation.width );
     if ( ptask->task->type == VFS_FILE_TASK_EXEC )
-        xset_set( "task_pop_top", "s", s );
+        xset_set( "task_pop_top", XSET_VAR_S, s );
     else
-        xset_set( "task_pop_top", "x", s );
+        xset_set( "task_pop_top", XSET_VAR_X, s );
     g_free( s );
 
     s = g_strdup_printf( "%d", allocation.height );
     if ( ptask->task->type == VFS_FILE_TASK_EXEC )
-        xset_set( "task_pop_top", "z", s );
+        xset_set( "task_pop_top", XSET_VAR_Z, s );
     else
-        xset_set( "task_pop_top", "y", s );
+        xset_set( "task_pop_top", XSET_VAR_Y, s );
     g_free( s );
 }
 
@@ -1107,13 +1107,13 @@ void ptk_file_task_progress_open( PtkFileTask* ptask )
     int win_width, win_height;
     if ( task->type == VFS_FILE_TASK_EXEC )
     {
-        win_width = xset_get_int( "task_pop_top", "s" );
-        win_height = xset_get_int( "task_pop_top", "z" );
+        win_width = xset_get_int( "task_pop_top", XSET_VAR_S );
+        win_height = xset_get_int( "task_pop_top", XSET_VAR_Z );
     }
     else
     {
-        win_width = xset_get_int( "task_pop_top", "x" );
-        win_height = xset_get_int( "task_pop_top", "y" );
+        win_width = xset_get_int( "task_pop_top", XSET_VAR_X );
+        win_height = xset_get_int( "task_pop_top", XSET_VAR_Y );
     }
     if ( !win_width ) win_width = 750;
     if ( !win_height ) win_height = -1;
@@ -2059,10 +2059,10 @@ void query_overwrite_response( GtkDialog *dlg, gint response, PtkFileTask* ptask
         gint has_overwrite_btn = GPOINTER_TO_INT( (gpointer)g_object_get_data( 
                                         G_OBJECT( dlg ), "has_overwrite_btn" ) );
         str = g_strdup_printf( "%d", allocation.width );
-        xset_set( "task_popups", has_overwrite_btn ? "x" : "s", str );
+        xset_set( "task_popups", has_overwrite_btn ? XSET_VAR_X : XSET_VAR_S, str );
         g_free( str );
         str = g_strdup_printf( "%d", allocation.height );
-        xset_set( "task_popups", has_overwrite_btn ? "y" : "z", str );
+        xset_set( "task_popups", has_overwrite_btn ? XSET_VAR_Y : XSET_VAR_Z, str );
         g_free( str );
     }
 
@@ -2297,13 +2297,13 @@ static void query_overwrite( PtkFileTask* ptask )
     int width, height;
     if ( has_overwrite_btn )
     {
-        width = xset_get_int( "task_popups", "x" );
-        height = xset_get_int( "task_popups", "y" );
+        width = xset_get_int( "task_popups", XSET_VAR_X );
+        height = xset_get_int( "task_popups", XSET_VAR_Y );
     }
     else
     {
-        width = xset_get_int( "task_popups", "s" );
-        height = xset_get_int( "task_popups", "z" );
+        width = xset_get_int( "task_popups", XSET_VAR_S );
+        height = xset_get_int( "task_popups", XSET_VAR_Z );
     }
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( dlg ), width, height );
@@ -1321,7 +1321,7 @@ void ptk_handler_import( int mode, GtkWidget* handler_dlg, XSet* set )
     if ( g_strcmp0( xset_get_s( handler_conf_xset[mode] ), "" ) <= 0 )
     {
         // No handlers present - adding new handler
-        xset_set( handler_conf_xset[mode], "s", new_handler_xset->name );
+        xset_set( handler_conf_xset[mode], XSET_VAR_S, new_handler_xset->name );
     }
     else
     {
@@ -1329,7 +1329,7 @@ void ptk_handler_import( int mode, GtkWidget* handler_dlg, XSet* set )
         gchar* new_handlers_list = g_strdup_printf( "%s %s",
                             new_handler_xset->name,
                             xset_get_s( handler_conf_xset[mode] ) );
-        xset_set( handler_conf_xset[mode], "s", new_handlers_list );
+        xset_set( handler_conf_xset[mode], XSET_VAR_S, new_handlers_list );
         g_free( new_handlers_list );
     }    
 
@@ -1637,7 +1637,7 @@ static void on_configure_drag_end( GtkWidget* widget,
     while(gtk_tree_model_iter_next( GTK_TREE_MODEL( hnd->list ), &iter ));
 
     // Saving the new archive handlers list
-    xset_set( handler_conf_xset[hnd->mode], "s", archive_handlers );
+    xset_set( handler_conf_xset[hnd->mode], XSET_VAR_S, archive_handlers );
     g_free(archive_handlers);
 
     // Saving settings
@@ -1730,9 +1730,9 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
                                 GTK_TOGGLE_BUTTON( hnd->chkbtn_handler_enabled )
                               ) ? XSET_B_TRUE : XSET_B_FALSE;
         new_handler_xset->disable = FALSE;  // not default - save in session
-        xset_set_set( new_handler_xset, "label", handler_name );
-        xset_set_set( new_handler_xset, "s", handler_mime );  // Mime Type(s) or whitelist
-        xset_set_set( new_handler_xset, "x", handler_extension );  // Extension(s) or blacklist
+        xset_set_set( new_handler_xset, XSET_VAR_LABEL, handler_name );
+        xset_set_set( new_handler_xset, XSET_VAR_S, handler_mime );  // Mime Type(s) or whitelist
+        xset_set_set( new_handler_xset, XSET_VAR_X, handler_extension );  // Extension(s) or blacklist
         new_handler_xset->in_terminal = handler_compress_term ?
                                                 XSET_B_TRUE : XSET_B_UNSET;
         new_handler_xset->keep_terminal = handler_extract_term ?
@@ -1743,7 +1743,7 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
         if ( hnd->mode == HANDLER_MODE_FILE )
         {
             if ( handler_icon )
-                 xset_set_set( new_handler_xset, "icn", handler_icon );
+                 xset_set_set( new_handler_xset, XSET_VAR_ICN, handler_icon );
         }
         else
         {
@@ -1780,7 +1780,7 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
         if (g_strcmp0( xset_get_s( handler_conf_xset[hnd->mode] ), "" ) <= 0)
         {
             // No handlers present - adding new handler
-            xset_set( handler_conf_xset[hnd->mode], "s", new_handler_xset->name );
+            xset_set( handler_conf_xset[hnd->mode], XSET_VAR_S, new_handler_xset->name );
         }
         else
         {
@@ -1788,7 +1788,7 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
             gchar* new_handlers_list = g_strdup_printf( "%s %s",
                                 new_handler_xset->name,
                                 xset_get_s( handler_conf_xset[hnd->mode] ) );
-            xset_set( handler_conf_xset[hnd->mode], "s", new_handlers_list );
+            xset_set( handler_conf_xset[hnd->mode], XSET_VAR_S, new_handlers_list );
 
             // Clearing up
             g_free(new_handlers_list);
@@ -1846,9 +1846,9 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
         handler_xset->b = handler_enabled ? XSET_B_TRUE : XSET_B_UNSET;
         gboolean was_default = handler_xset->disable;
         handler_xset->disable = FALSE;  // not default - save in session
-        xset_set_set( handler_xset, "label", handler_name );
-        xset_set_set( handler_xset, "s", handler_mime );
-        xset_set_set( handler_xset, "x", handler_extension );
+        xset_set_set( handler_xset, XSET_VAR_LABEL, handler_name );
+        xset_set_set( handler_xset, XSET_VAR_S, handler_mime );
+        xset_set_set( handler_xset, XSET_VAR_X, handler_extension );
         handler_xset->in_terminal = handler_compress_term ?
                                                 XSET_B_TRUE : XSET_B_UNSET;
         handler_xset->keep_terminal = handler_extract_term ?
@@ -1862,7 +1862,7 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
         if ( hnd->mode == HANDLER_MODE_FILE )
         {
             if ( handler_icon )
-                 xset_set_set( handler_xset, "icn", handler_icon );
+                 xset_set_set( handler_xset, XSET_VAR_ICN, handler_icon );
         }
         else
         {
@@ -1951,7 +1951,7 @@ static void on_configure_button_press( GtkButton* widget, HandlerData* hnd )
         }
 
         // Finally updating handlers
-        xset_set( handler_conf_xset[hnd->mode], "s", new_archive_handlers_s );
+        xset_set( handler_conf_xset[hnd->mode], XSET_VAR_S, new_archive_handlers_s );
 
         // Deleting xset
         xset_custom_delete( handler_xset, FALSE );
@@ -2974,8 +2974,8 @@ void ptk_handler_show_config( int mode, DesktopWindow* desktop,
     xset_set_window_icon( GTK_WINDOW( hnd->dlg ) );
 
     // Setting saved dialog size
-    int width = xset_get_int( handler_conf_xset[HANDLER_MODE_ARC], "x" );
-    int height = xset_get_int( handler_conf_xset[HANDLER_MODE_ARC], "y" );
+    int width = xset_get_int( handler_conf_xset[HANDLER_MODE_ARC], XSET_VAR_X );
+    int height = xset_get_int( handler_conf_xset[HANDLER_MODE_ARC], XSET_VAR_Y );
     if ( width && height )
         gtk_window_set_default_size( GTK_WINDOW( hnd->dlg ), width, height );
 
@@ -3582,10 +3582,10 @@ void ptk_handler_show_config( int mode, DesktopWindow* desktop,
     {
         // They are - saving
         char* str = g_strdup_printf( "%d", width );
-        xset_set( handler_conf_xset[HANDLER_MODE_ARC], "x", str );
+        xset_set( handler_conf_xset[HANDLER_MODE_ARC], XSET_VAR_X, str );
         g_free( str );
         str = g_strdup_printf( "%d", height );
-        xset_set( handler_conf_xset[HANDLER_MODE_ARC], "y", str );
+        xset_set( handler_conf_xset[HANDLER_MODE_ARC], XSET_VAR_Y, str );
         g_free( str );
     }
 
@@ -0,0 +1,249 @@
+/*
+*  C Implementation: ptk-item-grid
+*
+* Description: Spatial index for hit testing the items of icon views
+*
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#include "ptk-item-grid.h"
+
+typedef struct
+{
+    GdkRectangle rect;
+    gpointer data;
+    guint stamp;    /* last query which returned the item */
+} GridItem;
+
+struct _PtkItemGrid
+{
+    GArray* items;  /* GridItem, in the order added */
+
+    /* cell i holds the items cells[starts[i]] to cells[starts[i+1]-1] */
+    guint* starts;
+    guint* cells;
+
+    int x, y;   /* top left of the first cell */
+    int cell_w, cell_h;
+    int cols, rows;
+
+    guint stamp;
+    gboolean built;
+};
+
+PtkItemGrid* ptk_item_grid_new()
+{
+    PtkItemGrid* grid = g_slice_new0( PtkItemGrid );
+    grid->items = g_array_new( FALSE, FALSE, sizeof( GridItem ) );
+    return grid;
+}
+
+void ptk_item_grid_free( PtkItemGrid* grid )
+{
+    g_free( grid->starts );
+    g_free( grid->cells );
+    g_array_free( grid->items, TRUE );
+    g_slice_free( PtkItemGrid, grid );
+}
+
+void ptk_item_grid_clear( PtkItemGrid* grid )
+{
+    g_array_set_size( grid->items, 0 );
+    grid->built = FALSE;
+}
+
+void ptk_item_grid_add( PtkItemGrid* grid, const GdkRectangle* rect,
+                        gpointer data )
+{
+    GridItem item;
+
+    item.rect = *rect;
+    if ( item.rect.width < 0 )
+        item.rect.width = 0;
+    if ( item.rect.height < 0 )
+        item.rect.height = 0;
+    item.data = data;
+    item.stamp = 0;
+    g_array_append_val( grid->items, item );
+    grid->built = FALSE;
+}
+
+static inline int cell_col( PtkItemGrid* grid, int x )
+{
+    x = ( x - grid->x ) / grid->cell_w;
+    return CLAMP( x, 0, grid->cols - 1 );
+}
+
+static inline int cell_row( PtkItemGrid* grid, int y )
+{
+    y = ( y - grid->y ) / grid->cell_h;
+    return CLAMP( y, 0, grid->rows - 1 );
+}
+
+static void build_grid( PtkItemGrid* grid )
+{
+    GridItem* item;
+    guint i, n = grid->items->len;
+    guint n_cells, total;
+    int x2, y2, col, row, col1, col2, row1, row2;
+    gint64 sum_w = 0, sum_h = 0;
+
+    g_free( grid->starts );
+    g_free( grid->cells );
+    grid->starts = NULL;
+    grid->cells = NULL;
+    grid->cols = grid->rows = 0;
+    grid->built = TRUE;
+    if ( n == 0 )
+        return;
+
+    // bounds and average item size
+    item = &g_array_index( grid->items, GridItem, 0 );
+    grid->x = item->rect.x;
+    grid->y = item->rect.y;
+    x2 = item->rect.x + item->rect.width;
+    y2 = item->rect.y + item->rect.height;
+    for ( i = 0; i < n; i++ )
+    {
+        item = &g_array_index( grid->items, GridItem, i );
+        grid->x = MIN( grid->x, item->rect.x );
+        grid->y = MIN( grid->y, item->rect.y );
+        x2 = MAX( x2, item->rect.x + item->rect.width );
+        y2 = MAX( y2, item->rect.y + item->rect.height );
+        sum_w += item->rect.width;
+        sum_h += item->rect.height;
+    }
+
+    // cells of about an item each, but not many more cells than items
+    grid->cell_w = MAX( sum_w / n, 1 );
+    grid->cell_h = MAX( sum_h / n, 1 );
+    while ( TRUE )
+    {
+        grid->cols = ( x2 - grid->x ) / grid->cell_w + 1;
+        grid->rows = ( y2 - grid->y ) / grid->cell_h + 1;
+        if ( (gint64)grid->cols * grid->rows <= (gint64)n * 4 + 64 )
+            break;
+        grid->cell_w *= 2;
+        grid->cell_h *= 2;
+    }
+    n_cells = grid->cols * grid->rows;
+
+    // count the items of each cell, then make starts[i] the end of cell i
+    grid->starts = g_new0( guint, n_cells + 1 );
+    for ( i = 0; i < n; i++ )
+    {
+        item = &g_array_index( grid->items, GridItem, i );
+        col1 = cell_col( grid, item->rect.x );
+        col2 = cell_col( grid, item->rect.x + item->rect.width );
+        row1 = cell_row( grid, item->rect.y );
+        row2 = cell_row( grid, item->rect.y + item->rect.height );
+        for ( row = row1; row <= row2; row++ )
+            for ( col = col1; col <= col2; col++ )
+                grid->starts[row * grid->cols + col]++;
+    }
+    for ( i = 1, total = grid->starts[0]; i < n_cells; i++ )
+        total = grid->starts[i] += grid->starts[i - 1];
+    grid->starts[n_cells] = total;
+
+    // fill the cells back to front, keeping the items in order
+    grid->cells = g_new( guint, MAX( total, 1 ) );
+    for ( i = n; i-- > 0; )
+    {
+        item = &g_array_index( grid->items, GridItem, i );
+        col1 = cell_col( grid, item->rect.x );
+        col2 = cell_col( grid, item->rect.x + item->rect.width );
+        row1 = cell_row( grid, item->rect.y );
+        row2 = cell_row( grid, item->rect.y + item->rect.height );
+        for ( row = row1; row <= row2; row++ )
+            for ( col = col1; col <= col2; col++ )
+                grid->cells[--grid->starts[row * grid->cols + col]] = i;
+    }
+}
+
+gpointer ptk_item_grid_find( PtkItemGrid* grid, int x, int y,
+                             PtkItemGridFunc func, gpointer user_data )
+{
+    GridItem* item;
+    guint i, cell;
+
+    if ( !grid->built )
+        build_grid( grid );
+    if ( grid->cols == 0 || x < grid->x || y < grid->y )
+        return NULL;
+    if ( ( x - grid->x ) / grid->cell_w >= grid->cols ||
+                            ( y - grid->y ) / grid->cell_h >= grid->rows )
+        return NULL;
+
+    cell = cell_row( grid, y ) * grid->cols + cell_col( grid, x );
+    for ( i = grid->starts[cell]; i < grid->starts[cell + 1]; i++ )
+    {
+        item = &g_array_index( grid->items, GridItem, grid->cells[i] );
+        if ( x >= item->rect.x && x <= item->rect.x + item->rect.width &&
+                        y >= item->rect.y && y <= item->rect.y + item->rect.height &&
+                        ( !func || func( item->data, x, y, user_data ) ) )
+            return item->data;
+    }
+    return NULL;
+}
+
+static gint compare_index( gconstpointer a, gconstpointer b )
+{
+    guint i = *(const guint*)a, j = *(const guint*)b;
+    return i < j ? -1 : i > j;
+}
+
+GList* ptk_item_grid_get_in_rect( PtkItemGrid* grid, const GdkRectangle* rect )
+{
+    GridItem* item;
+    GArray* found;
+    GList* list = NULL;
+    guint i, j;
+    int col, row, col1, col2, row2;
+
+    if ( !grid->built )
+        build_grid( grid );
+    if ( grid->cols == 0 )
+        return NULL;
+
+    if ( ++grid->stamp == 0 )
+    {
+        // wrapped around - forget all old queries
+        for ( i = 0; i < grid->items->len; i++ )
+            g_array_index( grid->items, GridItem, i ).stamp = 0;
+        grid->stamp = 1;
+    }
+
+    // an item spanning several cells is seen once
+    found = g_array_new( FALSE, FALSE, sizeof( guint ) );
+    col1 = cell_col( grid, rect->x );
+    col2 = cell_col( grid, rect->x + rect->width );
+    row2 = cell_row( grid, rect->y + rect->height );
+    for ( row = cell_row( grid, rect->y ); row <= row2; row++ )
+    {
+        for ( col = col1; col <= col2; col++ )
+        {
+            j = row * grid->cols + col;
+            for ( i = grid->starts[j]; i < grid->starts[j + 1]; i++ )
+            {
+                item = &g_array_index( grid->items, GridItem, grid->cells[i] );
+                if ( item->stamp == grid->stamp )
+                    continue;
+                item->stamp = grid->stamp;
+                if ( item->rect.x <= rect->x + rect->width &&
+                                rect->x <= item->rect.x + item->rect.width &&
+                                item->rect.y <= rect->y + rect->height &&
+                                rect->y <= item->rect.y + item->rect.height )
+                    g_array_append_val( found, grid->cells[i] );
+            }
+        }
+    }
+
+    g_array_sort( found, compare_index );
+    for ( i = found->len; i-- > 0; )
+        list = g_list_prepend( list, g_array_index( grid->items, GridItem,
+                                g_array_index( found, guint, i ) ).data );
+    g_array_free( found, TRUE );
+    return list;
+}
@@ -0,0 +1,54 @@
+/*
+*  C Interface: ptk-item-grid
+*
+* Description: Spatial index for hit testing the items of icon views
+*
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#ifndef _PTK_ITEM_GRID_H_
+#define _PTK_ITEM_GRID_H_
+
+#include <glib.h>
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Buckets the bounding rects of a set of items into a grid of cells, so
+ * that the items at a point or in a rect are found without checking every
+ * item.  Items are added in the order of the view; a point lookup returns
+ * the first matching item in that order, like a walk over the item list
+ * would.  The grid is built on the first lookup after items were added,
+ * and must be cleared and refilled whenever the items move or are freed.
+ */
+typedef struct _PtkItemGrid PtkItemGrid;
+
+/* Exact test of an item whose bounding rect contains x, y */
+typedef gboolean ( *PtkItemGridFunc ) ( gpointer data, int x, int y,
+                                        gpointer user_data );
+
+PtkItemGrid* ptk_item_grid_new();
+void ptk_item_grid_free( PtkItemGrid* grid );
+
+/* Remove all items */
+void ptk_item_grid_clear( PtkItemGrid* grid );
+
+/* The edges of rect belong to it, an empty rect covers a single point */
+void ptk_item_grid_add( PtkItemGrid* grid, const GdkRectangle* rect,
+                        gpointer data );
+
+/* The first item whose rect contains x, y and for which func, if not NULL,
+ * returns TRUE.  NULL if there is none. */
+gpointer ptk_item_grid_find( PtkItemGrid* grid, int x, int y,
+                             PtkItemGridFunc func, gpointer user_data );
+
+/* The items whose rects intersect rect, in the order they were added.
+ * The returned list should be freed with g_list_free(). */
+GList* ptk_item_grid_get_in_rect( PtkItemGrid* grid, const GdkRectangle* rect );
+
+G_END_DECLS
+
+#endif
@@ -1682,9 +1682,9 @@ static void on_change_label( GtkMenuItem* item, VFSVolume* vol, GtkWidget* view2
                                         || strcmp( label_cmd, new_label_cmd ) );
 
         if ( new_label[0] == '\0' )
-            xset_set_set( set, "y", new_label_cmd );
+            xset_set_set( set, XSET_VAR_Y, new_label_cmd );
         else
-            xset_set_set( set, "x", new_label_cmd );
+            xset_set_set( set, XSET_VAR_X, new_label_cmd );
             
         // task
         PtkFileBrowser* file_browser = (PtkFileBrowser*)g_object_get_data( G_OBJECT(view),
@@ -3693,7 +3693,7 @@ static void show_devices_menu( GtkTreeView* view, VFSVolume* vol,
     set = xset_get( "dev_menu_settings" );
     menu_elements = g_strdup_printf( "dev_show sep_dm4 dev_menu_auto dev_exec dev_fs_cnf dev_net_cnf dev_mount_options dev_change sep_dm5 dev_single dev_newtab dev_icon panel%d_font_dev",
                                                     file_browser->mypanel );
-    xset_set_set( set, "desc", menu_elements );
+    xset_set_set( set, XSET_VAR_DESC, menu_elements );
     g_free( menu_elements );
 
     menu_elements = g_strdup_printf( "sep_dm2 dev_menu_root sep_dm3 dev_prop dev_menu_settings" );
@@ -4158,7 +4158,7 @@ void ptk_location_view_dev_menu( GtkWidget* parent, PtkFileBrowser* file_browser
 
     set = xset_get( "dev_menu_settings" );
     char* desc = g_strdup_printf( "dev_show sep_dm4 dev_menu_auto dev_exec dev_fs_cnf dev_net_cnf dev_mount_options dev_change%s", file_browser ? " dev_newtab" : "" );
-    xset_set_set( set, "desc", desc );
+    xset_set_set( set, XSET_VAR_DESC, desc );
     g_free( desc );
 #endif
 }
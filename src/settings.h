@@ -128,6 +128,41 @@ enum {
     XSET_B_FALSE
 };
 
+typedef enum {  // xset variables - see xset_var_names in settings.c
+    XSET_VAR_S,
+    XSET_VAR_B,
+    XSET_VAR_X,
+    XSET_VAR_Y,
+    XSET_VAR_Z,
+    XSET_VAR_KEY,
+    XSET_VAR_KEYMOD,
+    XSET_VAR_STYLE,
+    XSET_VAR_DESC,
+    XSET_VAR_TITLE,
+    XSET_VAR_LBL,
+    XSET_VAR_ICN,
+    XSET_VAR_LABEL,
+    XSET_VAR_ICON,
+    XSET_VAR_SHARED_KEY,
+    XSET_VAR_NEXT,
+    XSET_VAR_PREV,
+    XSET_VAR_PARENT,
+    XSET_VAR_CHILD,
+    XSET_VAR_CXT,
+    XSET_VAR_LINE,
+    XSET_VAR_TOOL,
+    XSET_VAR_TASK,
+    XSET_VAR_TASK_POP,
+    XSET_VAR_TASK_ERR,
+    XSET_VAR_TASK_OUT,
+    XSET_VAR_TERM,
+    XSET_VAR_KEEP,
+    XSET_VAR_SCROLL,
+    XSET_VAR_DISABLE,
+    XSET_VAR_OP,
+    XSET_VAR_UNKNOWN    // not a variable
+} XSetVar;
+
 enum {
     XSET_CMD_LINE,
     XSET_CMD_SCRIPT,
@@ -404,23 +439,23 @@ gboolean xset_copy_file( char* src, char* dest );
 gboolean dir_has_files( const char* path );
 XSet* xset_get( const char* name );
 char* xset_get_s( const char* name );
-gboolean xset_get_bool( const char* name, const char* var );
+gboolean xset_get_bool( const char* name, XSetVar var );
 gboolean xset_get_b( const char* name );
 XSet* xset_get_panel( int panel, const char* name );
 char* xset_get_s_panel( int panel, const char* name );
 gboolean xset_get_b_panel( int panel, const char* name );
-gboolean xset_get_bool_panel( int panel, const char* name, const char* var );
+gboolean xset_get_bool_panel( int panel, const char* name, XSetVar var );
 XSet* xset_set_b( const char* name, gboolean bval );
 XSet* xset_set_b_panel( int panel, const char* name, gboolean bval );
-int xset_get_int( const char* name, const char* var );
-int xset_get_int_panel( int panel, const char* name, const char* var );
-XSet* xset_set_panel( int panel, const char* name, const char* var, const char* value );
+int xset_get_int( const char* name, XSetVar var );
+int xset_get_int_panel( int panel, const char* name, XSetVar var );
+XSet* xset_set_panel( int panel, const char* name, XSetVar var, const char* value );
 XSet* xset_set_cb_panel( int panel, const char* name, void (*cb_func) (), gpointer cb_data );
 gboolean xset_get_b_set( XSet* set );
 XSet* xset_get_panel_mode( int panel, const char* name, char mode );
 gboolean xset_get_b_panel_mode( int panel, const char* name, char mode );
 XSet* xset_set_panel_mode( int panel, const char* name, char mode,
-                                      const char* var, const char* value );
+                                      XSetVar var, const char* value );
 XSet* xset_set_b_panel_mode( int panel, const char* name, char mode,
                                                             gboolean bval );
 
@@ -433,8 +468,9 @@ gboolean have_x_access( const char* path );
 char* xset_get_keyname( XSet* set, int key_val, int key_mod );
 void xset_set_key( GtkWidget* parent, XSet* set );
 
-XSet* xset_set( const char* name, const char* var, const char* value );
-XSet* xset_set_set( XSet* set, const char* var, const char* value );
+XSet* xset_set( const char* name, XSetVar var, const char* value );
+XSet* xset_set_set( XSet* set, XSetVar var, const char* value );
+XSetVar xset_var_from_name( const char* var );
 void xset_custom_delete( XSet* set, gboolean delete_next );
 void xset_custom_activate( GtkWidget* item, XSet* set );
 XSet* xset_custom_remove( XSet* set );
@@ -0,0 +1,434 @@
+/*
+*  C Implementation: vfs-dir-size
+*
+* Description: Parallel recursive size scan of directory trees
+*
+* Each dir is a job for a shared pool of workers.  A worker opens the dir
+* once and stats its entries relative to the dir fd, so the kernel doesn't
+* walk the whole path for every file.  Found sub-dirs become new jobs, so
+* wide and deep trees are spread over all workers.
+*
+* The sizes of the files directly in a dir are kept in a cache keyed by the
+* dir's device, inode and mtime, together with the names of its sub-dirs.
+* A rescan of the same tree then only needs to stat the dirs.  Note that a
+* file growing in place doesn't change its dir's mtime, so cache entries
+* expire after a while.
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // fdopendir, fstatat64
+#endif
+
+#include "vfs-dir-size.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <time.h>
+
+#define DIR_SIZE_WORKERS 8
+#define DIR_SIZE_CACHE_MAX 100000   /* dirs */
+#define DIR_SIZE_CACHE_AGE 600      /* seconds */
+
+struct _VFSDirSize
+{
+    GMutex* mutex;
+    GCond* cond;                /* signalled when pending drops to 0 */
+    VFSDirSizeTotals totals;
+    guint pending;              /* dir jobs queued or running */
+    GSList* devs;               /* all devices seen */
+    GSList* new_devs;           /* not yet stolen */
+    VFSDirSizeDoneCallback done_cb;
+    gpointer done_data;
+    volatile gboolean cancel;
+};
+
+typedef struct
+{
+    VFSDirSize* ds;
+    char* path;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    gboolean follow;    /* a dir passed in, which may be reached by a link */
+} DirSizeJob;
+
+typedef struct
+{
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    time_t added;
+    off64_t size;               /* of the files directly in the dir */
+    off64_t size_on_disk;
+    guint n_files;
+    char* subdirs;              /* NUL separated names */
+    gsize subdirs_len;
+} DirSizeCache;
+
+static GThreadPool* dir_size_pool = NULL;
+static GHashTable* dir_size_cache = NULL;
+G_LOCK_DEFINE_STATIC( dir_size_pool );
+G_LOCK_DEFINE_STATIC( dir_size_cache );
+
+static void scan_dir( DirSizeJob* job, gpointer user_data );
+
+static guint cache_hash( gconstpointer key )
+{
+    const DirSizeCache* c = (const DirSizeCache*)key;
+    return (guint)c->ino ^ ( (guint)c->dev << 16 );
+}
+
+static gboolean cache_equal( gconstpointer a, gconstpointer b )
+{
+    const DirSizeCache* ca = (const DirSizeCache*)a;
+    const DirSizeCache* cb = (const DirSizeCache*)b;
+    return ca->ino == cb->ino && ca->dev == cb->dev;
+}
+
+static void cache_free( DirSizeCache* c )
+{
+    g_free( c->subdirs );
+    g_slice_free( DirSizeCache, c );
+}
+
+static DirSizeCache* cache_dup( DirSizeCache* c )
+{
+    DirSizeCache* dup = g_slice_dup( DirSizeCache, c );
+    dup->subdirs = g_memdup( c->subdirs, c->subdirs_len );
+    return dup;
+}
+
+/* Returns a copy of the valid cache entry for job's dir, or NULL */
+static DirSizeCache* cache_lookup( DirSizeJob* job, time_t now )
+{
+    DirSizeCache key;
+    DirSizeCache* c;
+    DirSizeCache* ret = NULL;
+
+    key.dev = job->dev;
+    key.ino = job->ino;
+    G_LOCK( dir_size_cache );
+    if ( dir_size_cache &&
+            ( c = (DirSizeCache*)g_hash_table_lookup( dir_size_cache, &key ) ) )
+    {
+        if ( c->mtime == job->mtime && now - c->added < DIR_SIZE_CACHE_AGE )
+        {
+            ret = cache_dup( c );
+        }
+        else
+            g_hash_table_remove( dir_size_cache, c );
+    }
+    G_UNLOCK( dir_size_cache );
+    return ret;
+}
+
+static void cache_insert( DirSizeCache* c )
+{
+    G_LOCK( dir_size_cache );
+    if ( !dir_size_cache )
+        dir_size_cache = g_hash_table_new_full( cache_hash, cache_equal,
+                                            (GDestroyNotify)cache_free, NULL );
+    else if ( g_hash_table_size( dir_size_cache ) >= DIR_SIZE_CACHE_MAX )
+        g_hash_table_remove_all( dir_size_cache );
+    g_hash_table_replace( dir_size_cache, c, c );
+    G_UNLOCK( dir_size_cache );
+}
+
+/* Call with ds->mutex locked */
+static void add_dev( VFSDirSize* ds, dev_t dev )
+{
+    gpointer d = GUINT_TO_POINTER( dev );
+    if ( !g_slist_find( ds->devs, d ) )
+    {
+        ds->devs = g_slist_prepend( ds->devs, d );
+        ds->new_devs = g_slist_append( ds->new_devs, d );
+    }
+}
+
+static DirSizeJob* new_job( VFSDirSize* ds, char* path, struct stat64* st )
+{
+    DirSizeJob* job = g_slice_new( DirSizeJob );
+    job->ds = ds;
+    job->path = path;
+    job->dev = st->st_dev;
+    job->ino = st->st_ino;
+    job->mtime = st->st_mtime;
+    job->follow = FALSE;
+    return job;
+}
+
+static void free_job( DirSizeJob* job )
+{
+    g_free( job->path );
+    g_slice_free( DirSizeJob, job );
+}
+
+static void push_jobs( GSList* jobs )
+{
+    GSList* l;
+
+    G_LOCK( dir_size_pool );
+    if ( !dir_size_pool )
+        dir_size_pool = g_thread_pool_new( (GFunc)scan_dir, NULL,
+                                           DIR_SIZE_WORKERS, FALSE, NULL );
+    for ( l = jobs; l; l = l->next )
+        g_thread_pool_push( dir_size_pool, l->data, NULL );
+    G_UNLOCK( dir_size_pool );
+    g_slist_free( jobs );
+}
+
+static void add_stat( VFSDirSizeTotals* totals, struct stat64* st )
+{
+    totals->size += st->st_size;
+    totals->size_on_disk += st->st_blocks << 9;     /* block x 512 */
+    if ( S_ISDIR( st->st_mode ) )
+        totals->n_dirs++;
+    else
+        totals->n_files++;
+}
+
+/* Read the dir, adding its files to totals and appending its sub-dir names
+ * to subdirs.  Returns the dir's cache entry, or NULL if it can't be read */
+static DirSizeCache* read_dir( DirSizeJob* job, GString* subdirs,
+                                    VFSDirSizeTotals* totals )
+{
+    DirSizeCache* c;
+    DIR* dir;
+    struct dirent* ent;
+    struct stat64 st;
+    int fd;
+
+    fd = open( job->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC |
+                                    ( job->follow ? 0 : O_NOFOLLOW ) );
+    if ( fd == -1 )
+        return NULL;
+    if ( !( dir = fdopendir( fd ) ) )
+    {
+        close( fd );
+        return NULL;
+    }
+
+    c = g_slice_new0( DirSizeCache );
+    while ( !job->ds->cancel && ( ent = readdir( dir ) ) )
+    {
+        if ( ent->d_name[0] == '.' && ( ent->d_name[1] == '\0' ||
+                ( ent->d_name[1] == '.' && ent->d_name[2] == '\0' ) ) )
+            continue;
+        if ( fstatat64( fd, ent->d_name, &st, AT_SYMLINK_NOFOLLOW ) == -1 )
+            continue;
+        if ( S_ISDIR( st.st_mode ) )
+            g_string_append_len( subdirs, ent->d_name,
+                                          strlen( ent->d_name ) + 1 );
+        else
+        {
+            c->size += st.st_size;
+            c->size_on_disk += st.st_blocks << 9;
+            c->n_files++;
+        }
+    }
+    closedir( dir );
+
+    totals->size += c->size;
+    totals->size_on_disk += c->size_on_disk;
+    totals->n_files += c->n_files;
+    return c;
+}
+
+/* GThreadPool func */
+static void scan_dir( DirSizeJob* job, gpointer user_data )
+{
+    VFSDirSize* ds = job->ds;
+    VFSDirSizeTotals totals = { 0 };
+    DirSizeCache* c = NULL;
+    GString* subdirs = NULL;
+    GSList* jobs = NULL;
+    GSList* l;
+    guint n_jobs = 0;
+    struct stat64 st;
+    const char* name;
+    const char* end;
+    char* path;
+    time_t now = time( NULL );
+
+    if ( !ds->cancel && !( c = cache_lookup( job, now ) ) )
+    {
+        subdirs = g_string_new( NULL );
+        if ( ( c = read_dir( job, subdirs, &totals ) ) )
+        {
+            c->subdirs_len = subdirs->len;
+            c->subdirs = g_string_free( subdirs, FALSE );
+            // a dir changed within the mtime's resolution may change again
+            // without a new mtime, so only cache settled dirs
+            if ( !ds->cancel && job->mtime < now - 1 )
+            {
+                c->dev = job->dev;
+                c->ino = job->ino;
+                c->mtime = job->mtime;
+                c->added = now;
+                // the cache owns what's inserted - keep using the original
+                cache_insert( cache_dup( c ) );
+            }
+        }
+        else
+            g_string_free( subdirs, TRUE );
+    }
+    else if ( c )
+    {
+        totals.size += c->size;
+        totals.size_on_disk += c->size_on_disk;
+        totals.n_files += c->n_files;
+    }
+
+    // stat the sub-dirs - also done for cached dirs to check their mtimes
+    if ( c )
+    {
+        end = c->subdirs + c->subdirs_len;
+        for ( name = c->subdirs; name < end && !ds->cancel;
+                                                name += strlen( name ) + 1 )
+        {
+            path = g_build_filename( job->path, name, NULL );
+            if ( lstat64( path, &st ) == 0 && S_ISDIR( st.st_mode ) )
+            {
+                add_stat( &totals, &st );
+                jobs = g_slist_prepend( jobs, new_job( ds, path, &st ) );
+                n_jobs++;
+            }
+            else
+                g_free( path );
+        }
+        cache_free( c );
+    }
+
+    g_mutex_lock( ds->mutex );
+    ds->totals.size += totals.size;
+    ds->totals.size_on_disk += totals.size_on_disk;
+    ds->totals.n_files += totals.n_files;
+    ds->totals.n_dirs += totals.n_dirs;
+    for ( l = jobs; l; l = l->next )
+    {
+        if ( ( (DirSizeJob*)l->data )->dev != job->dev )
+            add_dev( ds, ( (DirSizeJob*)l->data )->dev );   // a mount point
+    }
+    // sub-dirs are pending before this job finishes
+    ds->pending += n_jobs;
+    g_mutex_unlock( ds->mutex );
+    if ( jobs )
+        push_jobs( jobs );
+
+    // finish the job, which may finish the scan
+    g_mutex_lock( ds->mutex );
+    if ( ds->pending == 1 && ds->done_cb )
+    {
+        // ds stays alive until pending drops
+        g_mutex_unlock( ds->mutex );
+        ds->done_cb( ds, ds->done_data );
+        g_mutex_lock( ds->mutex );
+    }
+    if ( --ds->pending == 0 )
+        g_cond_broadcast( ds->cond );
+    g_mutex_unlock( ds->mutex );
+
+    free_job( job );
+}
+
+VFSDirSize* vfs_dir_size_new()
+{
+    VFSDirSize* ds = g_slice_new0( VFSDirSize );
+    ds->mutex = g_mutex_new();
+    ds->cond = g_cond_new();
+    return ds;
+}
+
+void vfs_dir_size_add( VFSDirSize* ds, const char* path,
+                                       struct stat64* have_stat )
+{
+    struct stat64 st;
+    DirSizeJob* job = NULL;
+
+    if ( have_stat )
+        st = *have_stat;
+    else if ( lstat64( path, &st ) == -1 )
+        return;
+
+    g_mutex_lock( ds->mutex );
+    add_stat( &ds->totals, &st );
+    add_dev( ds, st.st_dev );
+    if ( S_ISDIR( st.st_mode ) && !ds->cancel )
+    {
+        job = new_job( ds, g_strdup( path ), &st );
+        job->follow = TRUE;
+        ds->pending++;
+    }
+    g_mutex_unlock( ds->mutex );
+    if ( job )
+        push_jobs( g_slist_prepend( NULL, job ) );
+}
+
+gboolean vfs_dir_size_wait( VFSDirSize* ds, int timeout_ms )
+{
+    GTimeVal end;
+    gboolean done;
+
+    g_get_current_time( &end );
+    g_time_val_add( &end, (glong)timeout_ms * 1000 );
+    g_mutex_lock( ds->mutex );
+    while ( ds->pending )
+    {
+        if ( timeout_ms < 0 )
+            g_cond_wait( ds->cond, ds->mutex );
+        else if ( !g_cond_timed_wait( ds->cond, ds->mutex, &end ) )
+            break;
+    }
+    done = ds->pending == 0;
+    g_mutex_unlock( ds->mutex );
+    return done;
+}
+
+void vfs_dir_size_get_totals( VFSDirSize* ds, VFSDirSizeTotals* totals )
+{
+    g_mutex_lock( ds->mutex );
+    *totals = ds->totals;
+    g_mutex_unlock( ds->mutex );
+}
+
+GSList* vfs_dir_size_steal_devs( VFSDirSize* ds )
+{
+    GSList* devs;
+
+    g_mutex_lock( ds->mutex );
+    devs = ds->new_devs;
+    ds->new_devs = NULL;
+    g_mutex_unlock( ds->mutex );
+    return devs;
+}
+
+void vfs_dir_size_set_done_callback( VFSDirSize* ds,
+                                     VFSDirSizeDoneCallback cb,
+                                     gpointer user_data )
+{
+    g_mutex_lock( ds->mutex );
+    ds->done_cb = cb;
+    ds->done_data = user_data;
+    g_mutex_unlock( ds->mutex );
+}
+
+void vfs_dir_size_cancel( VFSDirSize* ds )
+{
+    ds->cancel = TRUE;
+}
+
+void vfs_dir_size_free( VFSDirSize* ds )
+{
+    vfs_dir_size_cancel( ds );
+    vfs_dir_size_wait( ds, -1 );
+    g_mutex_free( ds->mutex );
+    g_cond_free( ds->cond );
+    g_slist_free( ds->devs );
+    g_slist_free( ds->new_devs );
+    g_slice_free( VFSDirSize, ds );
+}
@@ -0,0 +1,63 @@
+/*
+*  C Interface: vfs-dir-size
+*
+* Description: Parallel recursive size scan of directory trees
+*
+*
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#ifndef _VFS_DIR_SIZE_H_
+#define _VFS_DIR_SIZE_H_
+
+#include <glib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+G_BEGIN_DECLS
+
+typedef struct _VFSDirSize VFSDirSize;
+
+typedef struct
+{
+    off64_t size;           /* of all files and dirs, not following symlinks */
+    off64_t size_on_disk;
+    guint n_files;          /* everything but dirs */
+    guint n_dirs;
+} VFSDirSizeTotals;
+
+/* Called in a worker thread when the last queued dir has been scanned */
+typedef void ( *VFSDirSizeDoneCallback ) ( VFSDirSize* ds, gpointer user_data );
+
+VFSDirSize* vfs_dir_size_new();
+
+/* Start counting path, which may be a file.  have_stat is its lstat, or NULL.
+ * To count what a link to a dir points to, pass the stat of the dir */
+void vfs_dir_size_add( VFSDirSize* ds, const char* path,
+                                       struct stat64* have_stat );
+
+/* Wait for the scan to finish for up to timeout_ms (-1 waits as long as it
+ * takes).  Returns TRUE if the scan is done */
+gboolean vfs_dir_size_wait( VFSDirSize* ds, int timeout_ms );
+
+/* The totals so far - these grow while the scan runs */
+void vfs_dir_size_get_totals( VFSDirSize* ds, VFSDirSizeTotals* totals );
+
+/* Devices seen since the last call, as dev_t in GUINT_TO_POINTER.
+ * The caller frees the list */
+GSList* vfs_dir_size_steal_devs( VFSDirSize* ds );
+
+void vfs_dir_size_set_done_callback( VFSDirSize* ds,
+                                     VFSDirSizeDoneCallback cb,
+                                     gpointer user_data );
+
+void vfs_dir_size_cancel( VFSDirSize* ds );
+
+/* Cancels the scan and waits for the workers to let go of ds */
+void vfs_dir_size_free( VFSDirSize* ds );
+
+G_END_DECLS
+
+#endif
@@ -10,7 +10,7 @@
 */
 
 #ifndef _GNU_SOURCE
-#define _GNU_SOURCE  // euidaccess
+#define _GNU_SOURCE  // euidaccess, fstatat64
 #endif
 
 #include "vfs-dir.h"
@@ -21,6 +21,8 @@
 #include <string.h>
 
 #include <fcntl.h>  /* for open() */
+#include <sys/stat.h>  /* for lstat64 */
+#include <dirent.h>
 
 #if defined (__GLIBC__)
 #include <malloc.h> /* for malloc_trim */
@@ -63,7 +65,7 @@ static gpointer load_thumbnail_thread( gpointer user_data );
 static void on_mime_type_reload( gpointer user_data );
 
 
-static void update_changed_files( gpointer key, gpointer data,
+static void update_pending_files( gpointer key, gpointer data,
                                   gpointer user_data );
 static gboolean notify_file_change( gpointer user_data );
 static gboolean update_file_info( VFSDir* dir, VFSFileInfo* file );
@@ -73,6 +75,7 @@ static gboolean is_dir_desktop( const char* path );
 #endif
 
 static void on_list_task_finished( VFSAsyncTask* task, gboolean is_cancelled, VFSDir* dir );
+static void info_loader_free( struct _VFSDirInfoLoader* loader );
 
 enum {
     FILE_CREATED_SIGNAL = 0,
@@ -80,6 +83,7 @@ enum {
     FILE_CHANGED_SIGNAL,
     THUMBNAIL_LOADED_SIGNAL,
     FILE_LISTED_SIGNAL,
+    FILES_CREATED_SIGNAL,
     N_SIGNALS
 };
 
@@ -89,6 +93,24 @@ static GObjectClass *parent_class = NULL;
 static GHashTable* dir_hash = NULL;
 static GList* mime_cb = NULL;
 static guint change_notify_timeout = 0;
+
+/* Monitor events are queued per file name in dir->pending_events and
+ * flushed together by notify_file_change().  The delay adapts to the
+ * event rate: short for single edits, growing while events storm in. */
+#define NOTIFY_DELAY_MIN     100   /* ms */
+#define NOTIFY_DELAY_MAX     1600  /* ms */
+#define NOTIFY_STORM_EVENTS  64    /* events in one flush that count as a storm */
+
+enum
+{
+    PENDING_CREATED = 1 << 0,
+    PENDING_CHANGED = 1 << 1,
+    PENDING_DELETED = 1 << 2
+};
+
+static guint notify_delay = NOTIFY_DELAY_MIN;
+static guint notify_window_events = 0;  /* events since the last flush */
+static VFSDirEventStats event_stats = { 0 };
 static guint theme_change_notify = 0;
 
 static char* desktop_dir = NULL;
@@ -193,6 +215,20 @@ void vfs_dir_class_init( VFSDirClass* klass )
                        g_cclosure_marshal_VOID__BOOLEAN,
                        G_TYPE_NONE, 1, G_TYPE_BOOLEAN );
 
+    /*
+    * files-created is emitted once per change notification after the
+    * individual file-created signals, with a GList of all VFSFileInfo
+    * added to the dir, so models can insert them in a single pass.
+    */
+    signals[ FILES_CREATED_SIGNAL ] =
+        g_signal_new ( "files-created",
+                       G_TYPE_FROM_CLASS ( klass ),
+                       G_SIGNAL_RUN_FIRST,
+                       G_STRUCT_OFFSET ( VFSDirClass, files_created ),
+                       NULL, NULL,
+                       g_cclosure_marshal_VOID__POINTER,
+                       G_TYPE_NONE, 1, G_TYPE_POINTER );
+
     /* FIXME: Is there better way to do this? */
     if( G_UNLIKELY( ! is_desktop_set ) )
         vfs_get_desktop_dir();
@@ -205,6 +241,10 @@ void vfs_dir_class_init( VFSDirClass* klass )
 void vfs_dir_init( VFSDir* dir )
 {
     dir->mutex = g_mutex_new();
+    dir->file_hash = g_hash_table_new_full( g_str_hash, g_str_equal,
+                                            g_free, NULL );
+    dir->pending_events = g_hash_table_new_full( g_str_hash, g_str_equal,
+                                                 g_free, NULL );
 }
 
 /* destructor */
@@ -268,6 +308,11 @@ void vfs_dir_finalize( GObject *obj )
         vfs_thumbnail_loader_free( dir->thumbnail_loader );
         dir->thumbnail_loader = NULL;
     }
+    if( G_UNLIKELY( dir->info_loader ) )
+    {
+        info_loader_free( dir->info_loader );
+        dir->info_loader = NULL;
+    }
 
     if ( dir->file_list )
     {
@@ -276,20 +321,11 @@ void vfs_dir_finalize( GObject *obj )
         dir->file_list = NULL;
         dir->n_files = 0;
     }
+    g_hash_table_destroy( dir->file_hash );
+    dir->file_hash = NULL;
 
-    if( dir->changed_files )
-    {
-        g_slist_foreach( dir->changed_files, (GFunc)vfs_file_info_unref, NULL );
-        g_slist_free( dir->changed_files );
-        dir->changed_files = NULL;
-    }
-
-    if( dir->created_files )
-    {
-        g_slist_foreach( dir->created_files, (GFunc)g_free, NULL );
-        g_slist_free( dir->created_files );
-        dir->created_files = NULL;
-    }
+    g_hash_table_destroy( dir->pending_events );
+    dir->pending_events = NULL;
 
     g_mutex_free( dir->mutex );
     G_OBJECT_CLASS( parent_class ) ->finalize( obj );
@@ -307,27 +343,84 @@ void vfs_dir_set_property ( GObject *obj,
                             GParamSpec *pspec )
 {}
 
+/* file_list and file_hash must only be changed with these helpers so the
+ * name index stays in sync.  Caller must hold dir->mutex. */
+static void vfs_dir_add_file( VFSDir* dir, VFSFileInfo* file )
+{
+    dir->file_list = g_list_prepend( dir->file_list, file );
+    g_hash_table_replace( dir->file_hash, g_strdup( file->name ),
+                                                        dir->file_list );
+    ++dir->n_files;
+}
+
+static void vfs_dir_remove_file( VFSDir* dir, GList* l, const char* file_name )
+{
+    g_hash_table_remove( dir->file_hash, file_name );
+    dir->file_list = g_list_delete_link( dir->file_list, l );
+    --dir->n_files;
+}
+
 static GList* vfs_dir_find_file( VFSDir* dir, const char* file_name, VFSFileInfo* file )
 {
-    GList * l;
-    VFSFileInfo* file2;
-    for ( l = dir->file_list; l; l = l->next )
+    GList* l = NULL;
+
+    if ( G_LIKELY( file_name ) )
+        l = (GList*)g_hash_table_lookup( dir->file_hash, file_name );
+    if ( G_UNLIKELY( !l && file && file->name && file->name != file_name ) )
+        l = (GList*)g_hash_table_lookup( dir->file_hash, file->name );
+    return l;
+}
+
+static void count_event()
+{
+    ++event_stats.received;
+    ++notify_window_events;
+}
+
+static void schedule_notify( guint min_delay )
+{
+    if ( 0 == change_notify_timeout )
     {
-        file2 = ( VFSFileInfo* ) l->data;
-        if( G_UNLIKELY( file == file2 ) )
-            return l;
-        if ( file2->name && 0 == strcmp( file2->name, file_name ) )
-        {
-            return l;
-        }
+        change_notify_timeout = g_timeout_add_full( G_PRIORITY_LOW,
+                                                    MAX( notify_delay, min_delay ),
+                                                    notify_file_change,
+                                                    NULL, NULL );
     }
-    return NULL;
+}
+
+/* Merge an event into the queue for file_name.  Returns FALSE if an event
+ * was already queued for it.  Caller must hold dir->mutex. */
+static gboolean queue_event( VFSDir* dir, const char* file_name, int event )
+{
+    gpointer key, value;
+
+    if ( !g_hash_table_lookup_extended( dir->pending_events, file_name,
+                                                            &key, &value ) )
+    {
+        g_hash_table_insert( dir->pending_events, g_strdup( file_name ),
+                                                    GINT_TO_POINTER( event ) );
+        return TRUE;
+    }
+    ++event_stats.coalesced;
+    if ( event == PENDING_DELETED
+                && ( GPOINTER_TO_INT( value ) & PENDING_CREATED )
+                && !vfs_dir_find_file( dir, file_name, NULL ) )
+    {
+        // created and deleted again before it was listed - nothing to do
+        g_hash_table_remove( dir->pending_events, file_name );
+        return FALSE;
+    }
+    // steal so the stored key isn't freed when the value is replaced
+    g_hash_table_steal( dir->pending_events, key );
+    g_hash_table_insert( dir->pending_events, key,
+                         GINT_TO_POINTER( GPOINTER_TO_INT( value ) | event ) );
+    return FALSE;
 }
 
 /* signal handlers */
 void vfs_dir_emit_file_created( VFSDir* dir, const char* file_name, gboolean force )
 {
-    GList* l;
+    count_event();
 
     // Ignore avoid_changes for creation of files
     //if ( !force && dir->avoid_changes )
@@ -339,20 +432,17 @@ void vfs_dir_emit_file_created( VFSDir* dir, const char* file_name, gboolean for
         return;
     }
 
-    dir->created_files = g_slist_append( dir->created_files, g_strdup( file_name ) );
-    if ( 0 == change_notify_timeout )
-    {
-        change_notify_timeout = g_timeout_add_full( G_PRIORITY_LOW,
-                                                    200,
-                                                    notify_file_change,
-                                                    NULL, NULL );
-    }
+    g_mutex_lock( dir->mutex );
+    queue_event( dir, file_name, PENDING_CREATED );
+    g_mutex_unlock( dir->mutex );
+    schedule_notify( 0 );
 }
 
 void vfs_dir_emit_file_deleted( VFSDir* dir, const char* file_name, VFSFileInfo* file )
 {
     GList* l;
-    VFSFileInfo* file_found;
+
+    count_event();
 
     if( G_UNLIKELY( 0 == strcmp(file_name, dir->path) ) )
     {
@@ -363,30 +453,27 @@ void vfs_dir_emit_file_deleted( VFSDir* dir, const char* file_name, VFSFileInfo*
         g_list_foreach( dir->file_list, (GFunc)vfs_file_info_unref, NULL );
         g_list_free( dir->file_list );
         dir->file_list = NULL;
+        g_hash_table_remove_all( dir->file_hash );
+        g_hash_table_remove_all( dir->pending_events );
+        dir->n_files = 0;
         g_mutex_unlock( dir->mutex );
 
         g_signal_emit( dir, signals[ FILE_DELETED_SIGNAL ], 0, file );
         return;
     }
 
+    g_mutex_lock( dir->mutex );
     l = vfs_dir_find_file( dir, file_name, file );
     if ( G_LIKELY( l ) )
     {
-        file_found = vfs_file_info_ref( ( VFSFileInfo* ) l->data );
-        if( !g_slist_find( dir->changed_files, file_found ) )
-        {
-            dir->changed_files = g_slist_prepend( dir->changed_files, file_found );
-            if ( 0 == change_notify_timeout )
-            {
-                change_notify_timeout = g_timeout_add_full( G_PRIORITY_LOW,
-                                                            200,
-                                                            notify_file_change,
-                                                            NULL, NULL );
-            }
-        }
-        else
-            vfs_file_info_unref( file_found );
+        queue_event( dir, ( ( VFSFileInfo* ) l->data )->name, PENDING_DELETED );
+        schedule_notify( 0 );
     }
+    else if ( g_hash_table_lookup( dir->pending_events, file_name ) )
+        queue_event( dir, file_name, PENDING_DELETED );
+    else
+        ++event_stats.dropped;
+    g_mutex_unlock( dir->mutex );
 }
 
 void vfs_dir_emit_file_changed( VFSDir* dir, const char* file_name,
@@ -395,8 +482,13 @@ void vfs_dir_emit_file_changed( VFSDir* dir, const char* file_name,
     GList* l;
 //printf("vfs_dir_emit_file_changed dir=%s file_name=%s avoid=%s\n", dir->path, file_name, dir->avoid_changes ? "TRUE" : "FALSE" );
 
+    count_event();
+
     if ( !force && dir->avoid_changes )
+    {
+        ++event_stats.dropped;
         return;
+    }
 
     if ( G_UNLIKELY( 0 == strcmp(file_name, dir->path) ) )
     {
@@ -411,35 +503,25 @@ void vfs_dir_emit_file_changed( VFSDir* dir, const char* file_name,
     if ( G_LIKELY( l ) )
     {
         file = vfs_file_info_ref( ( VFSFileInfo* ) l->data );
-        if( !g_slist_find( dir->changed_files, file ) )
+        if ( g_hash_table_lookup( dir->pending_events, file->name ) )
+            // already queued - the flush will pick up this change too
+            queue_event( dir, file->name, PENDING_CHANGED );
+        else if ( force )
         {
-            if ( force )
-            {
-                dir->changed_files = g_slist_prepend( dir->changed_files, file );
-                if ( 0 == change_notify_timeout )
-                {
-                    change_notify_timeout = g_timeout_add_full( G_PRIORITY_LOW,
-                                                                100,
-                                                                notify_file_change,
-                                                                NULL, NULL );
-                }
-            }
-            else if( G_LIKELY( update_file_info( dir, file ) ) ) // update file info the first time
-            {
-                dir->changed_files = g_slist_prepend( dir->changed_files, file );
-                if ( 0 == change_notify_timeout )
-                {
-                    change_notify_timeout = g_timeout_add_full( G_PRIORITY_LOW,
-                                                                500,
-                                                                notify_file_change,
-                                                                NULL, NULL );
-                }
-                g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, file );
-            }
+            queue_event( dir, file->name, PENDING_CHANGED );
+            schedule_notify( 0 );
         }
-        else
-            vfs_file_info_unref( file );
+        else if( G_LIKELY( update_file_info( dir, file ) ) ) // update file info the first time
+        {
+            // queue it to catch further writes, which often follow
+            queue_event( dir, file->name, PENDING_CHANGED );
+            schedule_notify( 500 );
+            g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, file );
+        }
+        vfs_file_info_unref( file );
     }
+    else
+        ++event_stats.dropped;
 
     g_mutex_unlock( dir->mutex );
 }
@@ -652,6 +734,339 @@ void vfs_dir_load( VFSDir* dir )
     }
 }
 
+/*
+* Two phase loading: vfs_dir_load_thread() lists large and remote dirs by
+* name only, then the info loader fills in stat, mime type and desktop
+* entry info for those files on a shared pool of workers.  Rows the views
+* ask for are loaded first (see vfs_dir_request_file_info).  The results
+* are moved into the listed VFSFileInfo in the main thread, in batches,
+* each file followed by a file-changed signal.
+*/
+#define DIR_LOAD_FULL_MAX     256  /* entries fully loaded while listing a local dir */
+#define INFO_LOADER_WORKERS   8
+#define INFO_UPDATE_INTERVAL  150  /* ms between batches of file-changed */
+
+typedef enum
+{
+    INFO_JOB_QUEUED,
+    INFO_JOB_RUNNING,
+    INFO_JOB_DONE
+} InfoJobState;
+
+typedef struct
+{
+    VFSFileInfo* file;     /* checked against the dir list before use */
+    char* name;
+    VFSFileInfo* result;
+    InfoJobState state;
+    gboolean urgent : 1;
+    int n_ref;             /* the jobs table and each queue it is in */
+} InfoJob;
+
+typedef struct _VFSDirInfoLoader
+{
+    VFSDir* dir;
+    char* path;            /* copy of dir->path for the workers */
+    GMutex* mutex;
+    GHashTable* jobs;      /* VFSFileInfo* -> InfoJob* not yet applied */
+    GQueue* queue;         /* InfoJob* in listing order */
+    GQueue* urgent;        /* InfoJob* for rows being shown, newest first */
+    GQueue* done;          /* InfoJob* waiting for the main thread */
+    int n_running;         /* workers in the pool for this loader - once
+                              cancelled, the last one frees the loader */
+    guint update_timeout;
+    gboolean cancel;
+} VFSDirInfoLoader;
+
+static GThreadPool* info_pool = NULL;
+G_LOCK_DEFINE_STATIC( info_pool );
+
+static void info_job_unref( InfoJob* job )
+{
+    if ( --job->n_ref == 0 )
+    {
+        g_free( job->name );
+        vfs_file_info_unref( job->file );
+        if ( job->result )
+            vfs_file_info_unref( job->result );
+        g_slice_free( InfoJob, job );
+    }
+}
+
+/* Caller must hold loader->mutex */
+static InfoJob* info_loader_pop( VFSDirInfoLoader* loader )
+{
+    InfoJob* job;
+
+    while ( !loader->cancel )
+    {
+        if ( !( job = (InfoJob*)g_queue_pop_head( loader->urgent ) )
+                && !( job = (InfoJob*)g_queue_pop_head( loader->queue ) ) )
+            break;
+        if ( job->state == INFO_JOB_QUEUED )
+        {
+            --job->n_ref;   // the table still holds it
+            return job;
+        }
+        info_job_unref( job );
+    }
+    return NULL;
+}
+
+static gboolean on_info_update( VFSDirInfoLoader* loader );
+static void info_loader_destroy( VFSDirInfoLoader* loader );
+
+static void info_loader_thread( VFSDirInfoLoader* loader, gpointer unused )
+{
+    InfoJob* job;
+    char* full_path;
+    gboolean destroy;
+
+    g_mutex_lock( loader->mutex );
+    while ( ( job = info_loader_pop( loader ) ) )
+    {
+        job->state = INFO_JOB_RUNNING;
+        g_mutex_unlock( loader->mutex );
+
+        job->result = vfs_file_info_new();
+        full_path = g_build_filename( loader->path, job->name, NULL );
+        if ( vfs_file_info_get( job->result, full_path, job->name ) )
+            vfs_file_info_load_special_info( job->result, full_path );
+        else
+        {
+            vfs_file_info_unref( job->result );
+            job->result = NULL;
+        }
+        g_free( full_path );
+
+        g_mutex_lock( loader->mutex );
+        job->state = INFO_JOB_DONE;
+        g_queue_push_tail( loader->done, job );
+        if ( !loader->update_timeout && !loader->cancel )
+            loader->update_timeout = g_timeout_add_full( G_PRIORITY_LOW,
+                                            INFO_UPDATE_INTERVAL,
+                                            (GSourceFunc)on_info_update,
+                                            loader, NULL );
+    }
+    --loader->n_running;
+    // let the main thread free the loader if this worker found only
+    // entries already loaded by another
+    if ( loader->n_running == 0 && !loader->update_timeout && !loader->cancel
+                                && g_hash_table_size( loader->jobs ) == 0 )
+        loader->update_timeout = g_timeout_add_full( G_PRIORITY_LOW,
+                                            INFO_UPDATE_INTERVAL,
+                                            (GSourceFunc)on_info_update,
+                                            loader, NULL );
+    destroy = loader->cancel && loader->n_running == 0;
+    g_mutex_unlock( loader->mutex );
+    if ( destroy )
+        info_loader_destroy( loader );
+}
+
+/* Caller must hold loader->mutex */
+static void info_loader_wake( VFSDirInfoLoader* loader )
+{
+    G_LOCK( info_pool );
+    if ( !info_pool )
+        info_pool = g_thread_pool_new( (GFunc)info_loader_thread, NULL,
+                                       INFO_LOADER_WORKERS, FALSE, NULL );
+    G_UNLOCK( info_pool );
+
+    while ( loader->n_running < INFO_LOADER_WORKERS
+                && loader->n_running < g_queue_get_length( loader->queue )
+                                        + g_queue_get_length( loader->urgent ) )
+    {
+        ++loader->n_running;
+        g_thread_pool_push( info_pool, loader, NULL );
+    }
+}
+
+static VFSDirInfoLoader* info_loader_new( VFSDir* dir )
+{
+    VFSDirInfoLoader* loader = g_slice_new0( VFSDirInfoLoader );
+    loader->dir = dir;
+    loader->path = g_strdup( dir->path );
+    loader->mutex = g_mutex_new();
+    loader->jobs = g_hash_table_new( g_direct_hash, g_direct_equal );
+    loader->queue = g_queue_new();
+    loader->urgent = g_queue_new();
+    loader->done = g_queue_new();
+    return loader;
+}
+
+static void info_loader_destroy( VFSDirInfoLoader* loader )
+{
+    InfoJob* job;
+    GHashTableIter it;
+
+    g_queue_foreach( loader->queue, (GFunc)info_job_unref, NULL );
+    g_queue_free( loader->queue );
+    g_queue_foreach( loader->urgent, (GFunc)info_job_unref, NULL );
+    g_queue_free( loader->urgent );
+    g_queue_free( loader->done );   // jobs in it are still in the table
+    g_hash_table_iter_init( &it, loader->jobs );
+    while ( g_hash_table_iter_next( &it, NULL, (gpointer*)&job ) )
+        info_job_unref( job );
+    g_hash_table_destroy( loader->jobs );
+    g_free( loader->path );
+    g_mutex_free( loader->mutex );
+    g_slice_free( VFSDirInfoLoader, loader );
+}
+
+/* Stop loading.  Workers may still be queued in the shared pool behind
+ * other dirs, so rather than waiting for them here, the last one to run
+ * frees the loader.  The loader must not be used after this */
+static void info_loader_free( VFSDirInfoLoader* loader )
+{
+    gboolean destroy;
+
+    g_mutex_lock( loader->mutex );
+    loader->cancel = TRUE;
+    if ( loader->update_timeout )
+    {
+        g_source_remove( loader->update_timeout );
+        loader->update_timeout = 0;
+    }
+    destroy = loader->n_running == 0;
+    g_mutex_unlock( loader->mutex );
+    if ( destroy )
+        info_loader_destroy( loader );
+}
+
+/* Queue the listed files for loading, in list order.  Called from
+ * vfs_dir_load_thread() */
+static void info_loader_add( VFSDir* dir, GSList* files )
+{
+    VFSDirInfoLoader* loader;
+    InfoJob* job;
+    GSList* l;
+
+    g_mutex_lock( dir->mutex );
+    if ( !dir->info_loader )
+        dir->info_loader = info_loader_new( dir );
+    loader = dir->info_loader;
+
+    g_mutex_lock( loader->mutex );
+    for ( l = files; l; l = l->next )
+    {
+        // skip files already removed or reloaded by a change event
+        if ( !( ( (VFSFileInfo*)l->data )->flags & VFS_FILE_INFO_PENDING ) )
+            continue;
+        job = g_slice_new0( InfoJob );
+        // a ref keeps the key from being freed and reused by a new file
+        job->file = vfs_file_info_ref( (VFSFileInfo*)l->data );
+        job->name = g_strdup( job->file->name );
+        job->state = INFO_JOB_QUEUED;
+        job->n_ref = 2;
+        g_hash_table_insert( loader->jobs, job->file, job );
+        g_queue_push_tail( loader->queue, job );
+    }
+    info_loader_wake( loader );
+    g_mutex_unlock( loader->mutex );
+    g_mutex_unlock( dir->mutex );
+}
+
+/* Load the info of file, listed by name only, before other such files */
+void vfs_dir_request_file_info( VFSDir* dir, VFSFileInfo* file )
+{
+    VFSDirInfoLoader* loader = dir->info_loader;
+    InfoJob* job;
+
+    if ( !loader || !( file->flags & VFS_FILE_INFO_PENDING ) )
+        return;
+    g_mutex_lock( loader->mutex );
+    job = (InfoJob*)g_hash_table_lookup( loader->jobs, file );
+    if ( job && !job->urgent && job->state == INFO_JOB_QUEUED )
+    {
+        job->urgent = TRUE;
+        ++job->n_ref;
+        g_queue_push_head( loader->urgent, job );
+        info_loader_wake( loader );
+    }
+    g_mutex_unlock( loader->mutex );
+}
+
+static gboolean on_info_update( VFSDirInfoLoader* loader )
+{
+    VFSDir* dir = loader->dir;
+    GQueue* done;
+    InfoJob* job;
+    GList* l;
+    GList* changed = NULL;
+    GList* deleted = NULL;
+    gboolean finished;
+
+    GDK_THREADS_ENTER();
+
+    g_mutex_lock( loader->mutex );
+    done = loader->done;
+    loader->done = g_queue_new();
+    loader->update_timeout = 0;
+    g_mutex_unlock( loader->mutex );
+
+    g_mutex_lock( dir->mutex );
+    for ( l = done->head; l; l = l->next )
+    {
+        job = (InfoJob*)l->data;
+        GList* found = vfs_dir_find_file( dir, job->name, NULL );
+        // skip files removed from the list, or reloaded by a change event
+        if ( !( found && found->data == job->file
+                        && ( job->file->flags & VFS_FILE_INFO_PENDING ) ) )
+            continue;
+        if ( job->result )
+        {
+            vfs_file_info_take( job->file, job->result );
+            changed = g_list_prepend( changed, vfs_file_info_ref( job->file ) );
+        }
+        else
+        {
+            // gone since it was listed - keeps the list's ref
+            vfs_dir_remove_file( dir, found, job->name );
+            deleted = g_list_prepend( deleted, job->file );
+        }
+    }
+    g_mutex_unlock( dir->mutex );
+
+    g_mutex_lock( loader->mutex );
+    for ( l = done->head; l; l = l->next )
+    {
+        job = (InfoJob*)l->data;
+        g_hash_table_remove( loader->jobs, job->file );
+        info_job_unref( job );
+    }
+    finished = loader->n_running == 0 && g_hash_table_size( loader->jobs ) == 0;
+    g_mutex_unlock( loader->mutex );
+    g_queue_free( done );
+
+    changed = g_list_reverse( changed );
+    for ( l = changed; l; l = l->next )
+    {
+        g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, l->data );
+        vfs_file_info_unref( (VFSFileInfo*)l->data );
+    }
+    g_list_free( changed );
+    for ( l = deleted; l; l = l->next )
+    {
+        g_signal_emit( dir, signals[ FILE_DELETED_SIGNAL ], 0, l->data );
+        vfs_file_info_unref( (VFSFileInfo*)l->data );
+    }
+    g_list_free( deleted );
+
+    if ( finished && dir->info_loader == loader )
+    {
+        dir->info_loader = NULL;
+        info_loader_free( loader );
+    }
+
+    GDK_THREADS_LEAVE();
+    return FALSE;
+}
+
+gboolean vfs_dir_is_loading_info( VFSDir* dir )
+{
+    return dir->info_loader ? TRUE : FALSE;
+}
+
 #if 0
 gboolean is_dir_desktop( const char* path )
 {
@@ -663,9 +1078,14 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
 {
     const gchar * file_name;
     char* full_path;
-    GDir* dir_content;
+    DIR* dir_content;
+    struct dirent* ent;
     VFSFileInfo* file;
     char* hidden = NULL;  //MOD added
+    int n_full = 0;
+    GSList* name_only = NULL;
+    unsigned char d_type;
+    struct stat64 type_stat;
 
     dir->file_listed = 0;
     dir->load_complete = 0;
@@ -677,7 +1097,7 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
                                              vfs_dir_monitor_callback,
                                              dir );
 
-        dir_content = g_dir_open( dir->path, 0, NULL );
+        dir_content = opendir( dir->path );
 
         if ( dir_content )
         {
@@ -690,10 +1110,11 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
             hidden = gethidden( dir->path );
 
             while ( ! vfs_async_task_is_cancelled( dir->task )
-                        && ( file_name = g_dir_read_name( dir_content ) ) )
+                        && ( ent = readdir( dir_content ) ) )
             {
-                full_path = g_build_filename( dir->path, file_name, NULL );
-                if ( !full_path )
+                file_name = ent->d_name;
+                if ( file_name[0] == '.' && ( file_name[1] == '\0' ||
+                        ( file_name[1] == '.' && file_name[2] == '\0' ) ) )
                     continue;
 
                 //MOD ignore if in .hidden
@@ -705,6 +1126,27 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
                 /* FIXME: Is locking GDK needed here? */
                 /* GDK_THREADS_ENTER(); */
                 file = vfs_file_info_new();
+                if ( G_LIKELY( !dir->is_trash && ( dir->is_remote || dir->avoid_changes ||
+                                            n_full >= DIR_LOAD_FULL_MAX ) ) )
+                {
+                    // list by name now, the info loader does the rest.
+                    // Some xfs, nfs and fuse mounts don't give the type, and
+                    // dirs must not pass for files until the info is in
+                    d_type = ent->d_type;
+                    if ( d_type == DT_UNKNOWN &&
+                            fstatat64( dirfd( dir_content ), file_name,
+                                       &type_stat, AT_SYMLINK_NOFOLLOW ) == 0 )
+                        d_type = IFTODT( type_stat.st_mode );
+                    vfs_file_info_get_from_dirent( file, file_name, d_type );
+                    g_mutex_lock( dir->mutex );
+                    vfs_dir_add_file( dir, file );
+                    g_mutex_unlock( dir->mutex );
+                    name_only = g_slist_prepend( name_only,
+                                                 vfs_file_info_ref( file ) );
+                    continue;
+                }
+                ++n_full;
+                full_path = g_build_filename( dir->path, file_name, NULL );
                 if ( G_LIKELY( vfs_file_info_get( file, full_path, file_name ) ) )
                 {
                     g_mutex_lock( dir->mutex );
@@ -740,9 +1182,8 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
                         }
                     }
 
-                    dir->file_list = g_list_prepend( dir->file_list, file );
+                    vfs_dir_add_file( dir, file );
                     g_mutex_unlock( dir->mutex );
-                    ++dir->n_files;
                 }
                 else
                 {
@@ -751,10 +1192,18 @@ gpointer vfs_dir_load_thread(  VFSAsyncTask* task, VFSDir* dir )
                 /* GDK_THREADS_LEAVE(); */
                 g_free( full_path );
             }
-            g_dir_close( dir_content );
+            closedir( dir_content );
             if ( hidden )
                 g_free( hidden );
 
+            if ( name_only )
+            {
+                name_only = g_slist_reverse( name_only );
+                info_loader_add( dir, name_only );
+                g_slist_foreach( name_only, (GFunc)vfs_file_info_unref, NULL );
+                g_slist_free( name_only );
+            }
+
             if( G_UNLIKELY(dir->is_trash) )
                 g_key_file_free( kf );
         }
@@ -809,11 +1258,10 @@ gboolean update_file_info( VFSDir* dir, VFSFileInfo* file )
         else /* The file doesn't exist */
         {
             GList* l;
-            l = g_list_find( dir->file_list, file );
-            if( G_UNLIKELY(l) )
+            l = (GList*)g_hash_table_lookup( dir->file_hash, file_name );
+            if( G_UNLIKELY( l && l->data == file ) )
             {
-                dir->file_list = g_list_delete_link( dir->file_list, l );
-                --dir->n_files;
+                vfs_dir_remove_file( dir, l, file_name );
                 if ( file )
                 {
                     g_signal_emit( dir, signals[ FILE_DELETED_SIGNAL ], 0, file );
@@ -829,86 +1277,153 @@ gboolean update_file_info( VFSDir* dir, VFSFileInfo* file )
 }
 
 
-void update_changed_files( gpointer key, gpointer data, gpointer user_data )
+/* Some events for dir were lost, so compare the names on disk with
+ * file_list and queue events for whatever differs.  Caller must hold
+ * dir->mutex. */
+static void rescan_dir( VFSDir* dir )
 {
-    VFSDir* dir = (VFSDir*)data;
-    GSList* l;
+    GDir* dir_content;
+    const char* file_name;
+    char* full_path;
+    char* hidden;
+    GHashTable* seen;
+    GList* l;
     VFSFileInfo* file;
+    struct stat64 file_stat;
 
-    if ( dir->changed_files )
+    dir->rescan_pending = FALSE;
+    if ( !( dir_content = g_dir_open( dir->path, 0, NULL ) ) )
+        return;
+    hidden = gethidden( dir->path );
+    seen = g_hash_table_new( g_direct_hash, g_direct_equal );
+    while ( ( file_name = g_dir_read_name( dir_content ) ) )
     {
-        g_mutex_lock( dir->mutex );
-        for ( l = dir->changed_files; l; l = l->next )
+        if ( hidden && ishidden( hidden, file_name ) )
+            continue;
+        l = (GList*)g_hash_table_lookup( dir->file_hash, file_name );
+        if ( !l )
         {
-            file = vfs_file_info_ref( ( VFSFileInfo* ) l->data );  ///
-            if ( update_file_info( dir, file ) )
-            {
-                g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, file );
-                vfs_file_info_unref( file );
-            }
-            // else was deleted, signaled, and unrefed in update_file_info
+            queue_event( dir, file_name, PENDING_CREATED );
+            continue;
         }
-        g_slist_free( dir->changed_files );
-        dir->changed_files = NULL;
-        g_mutex_unlock( dir->mutex );
+        file = (VFSFileInfo*)l->data;
+        g_hash_table_insert( seen, file, file );
+        // the info loader stats files listed by name only - they have no
+        // stat info to compare yet
+        if ( file->flags & VFS_FILE_INFO_PENDING )
+            continue;
+        full_path = g_build_filename( dir->path, file_name, NULL );
+        if ( lstat64( full_path, &file_stat ) != 0
+                || file_stat.st_mode != file->mode
+                || file_stat.st_size != file->size
+                || file_stat.st_mtime != file->mtime
+                || file_stat.st_uid != file->uid
+                || file_stat.st_gid != file->gid )
+            queue_event( dir, file_name, PENDING_CHANGED );
+        g_free( full_path );
+    }
+    g_dir_close( dir_content );
+    g_free( hidden );
+
+    for ( l = dir->file_list; l; l = l->next )
+    {
+        file = (VFSFileInfo*)l->data;
+        if ( !g_hash_table_lookup( seen, file ) )
+            queue_event( dir, file->name, PENDING_DELETED );
     }
+    g_hash_table_destroy( seen );
 }
 
-void update_created_files( gpointer key, gpointer data, gpointer user_data )
+void update_pending_files( gpointer key, gpointer data, gpointer user_data )
 {
     VFSDir* dir = (VFSDir*)data;
-    GSList* l;
+    GHashTableIter it;
+    gpointer name, value;
     char* full_path;
     VFSFileInfo* file;
     GList* ll;
+    GList* created = NULL;
+
+    if ( !dir->rescan_pending && 0 == g_hash_table_size( dir->pending_events ) )
+        return;
 
-    if ( dir->created_files )
+    g_mutex_lock( dir->mutex );
+    if ( dir->rescan_pending )
     {
-        g_mutex_lock( dir->mutex );
-        for ( l = dir->created_files; l; l = l->next )
+        if ( dir->task )
+            dir->rescan_pending = FALSE;  // still loading, so nothing was missed
+        else
+            rescan_dir( dir );
+    }
+
+    g_hash_table_iter_init( &it, dir->pending_events );
+    while ( g_hash_table_iter_next( &it, &name, &value ) )
+    {
+        if ( ( ll = vfs_dir_find_file( dir, (char*)name, NULL ) ) )
         {
-            if ( !( ll = vfs_dir_find_file( dir, (char*)l->data, NULL ) ) )
-            {
-                // file is not in dir file_list
-                full_path = g_build_filename( dir->path, (char*)l->data, NULL );
-                file = vfs_file_info_new();
-                if ( vfs_file_info_get( file, full_path, NULL ) )
-                {
-                    // add new file to dir file_list
-                    vfs_file_info_load_special_info( file, full_path );
-                    dir->file_list = g_list_prepend( dir->file_list,
-                                                    vfs_file_info_ref( file ) );
-                    ++dir->n_files;
-                    g_signal_emit( dir, signals[ FILE_CREATED_SIGNAL ], 0, file );
-                }
-                // else file doesn't exist in filesystem
-                vfs_file_info_unref( file );
-                g_free( full_path );
-            }
-            else
+            // changed, deleted, or deleted and created again
+            file = vfs_file_info_ref( (VFSFileInfo*)ll->data );
+            if ( update_file_info( dir, file ) )
+                g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, file );
+            // else was deleted, signaled, and removed in update_file_info
+            vfs_file_info_unref( file );
+        }
+        else if ( GPOINTER_TO_INT( value ) & PENDING_CREATED )
+        {
+            // file is not in dir file_list
+            full_path = g_build_filename( dir->path, (char*)name, NULL );
+            file = vfs_file_info_new();
+            if ( vfs_file_info_get( file, full_path, NULL ) )
             {
-                // file already exists in dir file_list
-                file = vfs_file_info_ref( (VFSFileInfo*)ll->data );
-                if ( update_file_info( dir, file ) )
-                {
-                    g_signal_emit( dir, signals[ FILE_CHANGED_SIGNAL ], 0, file );
-                    vfs_file_info_unref( file );
-                }
-                // else was deleted, signaled, and unrefed in update_file_info
+                // add new file to dir file_list
+                vfs_file_info_load_special_info( file, full_path );
+                vfs_dir_add_file( dir, vfs_file_info_ref( file ) );
+                g_signal_emit( dir, signals[ FILE_CREATED_SIGNAL ], 0, file );
+                created = g_list_prepend( created, vfs_file_info_ref( file ) );
             }
-            g_free( (char*)l->data );  // free file_name string
+            // else file doesn't exist in filesystem
+            vfs_file_info_unref( file );
+            g_free( full_path );
         }
-        g_slist_free( dir->created_files );
-        dir->created_files = NULL;
-        g_mutex_unlock( dir->mutex );
     }
+    g_hash_table_remove_all( dir->pending_events );
+
+    if ( created )
+    {
+        // drop files deleted again by a signal handler in this same flush
+        GList* added = NULL;
+        for ( ll = created; ll; ll = ll->next )
+        {
+            file = (VFSFileInfo*)ll->data;
+            GList* found = vfs_dir_find_file( dir, file->name, NULL );
+            if ( found && found->data == file )
+                added = g_list_prepend( added, file );
+        }
+        if ( added )
+            g_signal_emit( dir, signals[ FILES_CREATED_SIGNAL ], 0, added );
+        g_list_free( added );
+        g_list_foreach( created, (GFunc)vfs_file_info_unref, NULL );
+        g_list_free( created );
+    }
+    g_mutex_unlock( dir->mutex );
+}
+
+static void flush_pending_files()
+{
+    g_hash_table_foreach( dir_hash, update_pending_files, NULL );
+
+    // wait longer between flushes while events keep pouring in
+    if ( notify_window_events >= NOTIFY_STORM_EVENTS )
+        notify_delay = MIN( notify_delay * 2, NOTIFY_DELAY_MAX );
+    else if ( notify_window_events < NOTIFY_STORM_EVENTS / 8 )
+        notify_delay = NOTIFY_DELAY_MIN;
+    notify_window_events = 0;
 }
 
 gboolean notify_file_change( gpointer user_data )
 {
     //GDK_THREADS_ENTER();  //sfm not needed because in main thread?
-    g_hash_table_foreach( dir_hash, update_changed_files, NULL );
-    g_hash_table_foreach( dir_hash, update_created_files, NULL );
+    flush_pending_files();
     /* remove the timeout */
     change_notify_timeout = 0;
     //GDK_THREADS_LEAVE();
@@ -920,8 +1435,12 @@ void vfs_dir_flush_notify_cache()
     if ( change_notify_timeout )
         g_source_remove( change_notify_timeout );
     change_notify_timeout = 0;
-    g_hash_table_foreach( dir_hash, update_changed_files, NULL );
-    g_hash_table_foreach( dir_hash, update_created_files, NULL );
+    flush_pending_files();
+}
+
+void vfs_dir_get_event_stats( VFSDirEventStats* stats )
+{
+    *stats = event_stats;
 }
 
 /* Callback function which will be called when monitored events happen */
@@ -944,6 +1463,11 @@ void vfs_dir_monitor_callback( VFSFileMonitor* fm,
     case VFS_FILE_MONITOR_CHANGE:
         vfs_dir_emit_file_changed( dir, file_name, NULL, FALSE );
         break;
+    case VFS_FILE_MONITOR_OVERFLOW:
+        ++event_stats.overflows;
+        dir->rescan_pending = TRUE;
+        schedule_notify( 0 );
+        break;
     default:
         g_warning("Error: unrecognized file monitor signal!");
     }
@@ -56,17 +56,19 @@ struct _VFSDir
     /*<private>*/
     VFSFileMonitor* monitor;
     GMutex* mutex;  /* Used to guard file_list */
+    GHashTable* file_hash;  /* file name -> link in file_list, guarded by mutex */
     VFSAsyncTask* task;
     gboolean file_listed : 1;
     gboolean load_complete : 1;
     gboolean cancel: 1;
     gboolean show_hidden : 1;
     gboolean avoid_changes : 1;  //sfm
+    gboolean rescan_pending : 1;  /* events were lost - compare with disk */
 
     struct _VFSThumbnailLoader* thumbnail_loader;
+    struct _VFSDirInfoLoader* info_loader;  /* for files listed by name only */
 
-    GSList* changed_files;
-    GSList* created_files;  //MOD
+    GHashTable* pending_events;  /* file name -> coalesced event flags, guarded by mutex */
     glong xhidden_count;  //MOD
 };
 
@@ -78,6 +80,7 @@ struct _VFSDirClass
     void ( *file_deleted ) ( VFSDir* dir, VFSFileInfo* file );
     void ( *file_changed ) ( VFSDir* dir, VFSFileInfo* file );
     void ( *thumbnail_loaded ) ( VFSDir* dir, VFSFileInfo* file );
+    void ( *files_created ) ( VFSDir* dir, GList* files );
     void ( *file_listed ) ( VFSDir* dir );
     void ( *load_complete ) ( VFSDir* dir );
     /*  void (*need_reload) ( VFSDir* dir ); */
@@ -86,6 +89,15 @@ struct _VFSDirClass
 
 typedef void ( *VFSDirStateCallback ) ( VFSDir* dir, int state, gpointer user_data );
 
+/* Counters of file monitor events passed through the change notify queue */
+typedef struct
+{
+    guint64 received;   /* events given to vfs_dir_emit_file_* */
+    guint64 coalesced;  /* merged into an event already queued for the file */
+    guint64 dropped;    /* for files not in the dir, or ignored by avoid_changes */
+    guint overflows;    /* inotify queue overflows, each causing a rescan */
+} VFSDirEventStats;
+
 GType vfs_dir_get_type ( void );
 
 VFSDir* vfs_dir_get_by_path( const char* path );
@@ -95,6 +107,12 @@ gboolean vfs_dir_is_loading( VFSDir* dir );
 void vfs_dir_cancel_load( VFSDir* dir );
 gboolean vfs_dir_is_file_listed( VFSDir* dir );
 
+/* Large and remote dirs are listed by name first (VFS_FILE_INFO_PENDING set
+ * on the files), and the rest is loaded in the background, emitting
+ * file-changed as it arrives.  Views should request the files they show. */
+gboolean vfs_dir_is_loading_info( VFSDir* dir );
+void vfs_dir_request_file_info( VFSDir* dir, VFSFileInfo* file );
+
 void vfs_dir_unload_thumbnails( VFSDir* dir, gboolean is_big );
 
 /* emit signals */
@@ -104,6 +122,7 @@ void vfs_dir_emit_file_changed( VFSDir* dir, const char* file_name,
                                         VFSFileInfo* file, gboolean force );
 void vfs_dir_emit_thumbnail_loaded( VFSDir* dir, VFSFileInfo* file );
 void vfs_dir_flush_notify_cache();
+void vfs_dir_get_event_stats( VFSDirEventStats* stats );
 
 /* get the path of desktop dir */
 const char* vfs_get_desktop_dir();
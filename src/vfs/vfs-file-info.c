@@ -17,6 +17,7 @@
 #include <grp.h> /* Query group name */
 #include <pwd.h> /* Query user name */
 #include <string.h>
+#include <dirent.h>  /* for DT_* */
 #include "settings.h"
 
 #include "vfs-app-desktop.h"
@@ -27,6 +28,27 @@ static int big_thumb_size = 48, small_thumb_size = 20;
 static gboolean utf8_file_name = FALSE;
 static const char* desktop_dir = NULL;   //MOD added
 
+/* Display strings are not kept per file.  Size and mtime are formatted on
+ * demand into small direct mapped caches (call with the GDK lock held - a
+ * returned string is only valid until the next call), and owner:group pairs
+ * are interned for the life of the process. */
+#define DISP_CACHE_SIZE 128     /* must be a power of 2 */
+
+typedef struct
+{
+    guint64 key;
+    gboolean used;
+    char str[ 64 ];
+} DispCacheEntry;
+
+static DispCacheEntry size_cache[ DISP_CACHE_SIZE ];
+static DispCacheEntry mtime_cache[ DISP_CACHE_SIZE ];
+static gboolean size_cache_si = FALSE;
+static char* mtime_cache_format = NULL;
+
+static GHashTable* owner_hash = NULL;  /* uid << 32 | gid => "user:group" */
+G_LOCK_DEFINE_STATIC( owner_hash );
+
 void vfs_file_info_set_utf8_filename( gboolean is_utf8 )
 {
     utf8_file_name = is_utf8;
@@ -39,6 +61,15 @@ VFSFileInfo* vfs_file_info_new ()
     return fi;
 }
 
+/* The case folded key may share the storage of collate_key */
+static void free_collate_keys( VFSFileInfo* fi )
+{
+    if ( fi->collate_icase_key != fi->collate_key )
+        g_free( fi->collate_icase_key );
+    g_free( fi->collate_key );
+    fi->collate_key = fi->collate_icase_key = NULL;
+}
+
 static void vfs_file_info_clear( VFSFileInfo* fi )
 {
     if ( fi->disp_name && fi->disp_name != fi->name )
@@ -51,31 +82,8 @@ static void vfs_file_info_clear( VFSFileInfo* fi )
         g_free( fi->name );
         fi->name = NULL;
     }
-    if ( fi->collate_key )  //sfm
-    {
-        g_free( fi->collate_key );
-        fi->collate_key = NULL;
-    }    
-    if ( fi->collate_icase_key )  //sfm
-    {
-        g_free( fi->collate_icase_key );
-        fi->collate_icase_key = NULL;
-    }    
-    if ( fi->disp_size )
-    {
-        g_free( fi->disp_size );
-        fi->disp_size = NULL;
-    }
-    if ( fi->disp_owner )
-    {
-        g_free( fi->disp_owner );
-        fi->disp_owner = NULL;
-    }
-    if ( fi->disp_mtime )
-    {
-        g_free( fi->disp_mtime );
-        fi->disp_mtime = NULL;
-    }
+    free_collate_keys( fi );  //sfm
+    fi->disp_owner = NULL;  /* interned */
     if ( fi->big_thumbnail )
     {
         g_object_unref( fi->big_thumbnail );
@@ -112,6 +120,31 @@ void vfs_file_info_unref( VFSFileInfo* fi )
     }
 }
 
+/* Copy the stat and set the display name of fi, whose name is set */
+static void set_stat( VFSFileInfo* fi, struct stat64* file_stat )
+{
+    /* This is time-consuming but can save much memory */
+    fi->mode = file_stat->st_mode;
+    fi->dev = file_stat->st_dev;
+    fi->uid = file_stat->st_uid;
+    fi->gid = file_stat->st_gid;
+    fi->size = file_stat->st_size;
+//printf("size %s %llu\n", fi->name, fi->size );
+    fi->mtime = file_stat->st_mtime;
+    fi->atime = file_stat->st_atime;
+    fi->blksize = file_stat->st_blksize;
+    fi->blocks = file_stat->st_blocks;
+
+    if ( G_LIKELY( utf8_file_name && g_utf8_validate ( fi->name, -1, NULL ) ) )
+    {
+        fi->disp_name = fi->name;   /* Don't duplicate the name and save memory */
+    }
+    else
+    {
+        fi->disp_name = g_filename_display_name( fi->name );
+    }
+}
+
 gboolean vfs_file_info_get( VFSFileInfo* fi,
                             const char* file_path,
                             const char* base_name )
@@ -126,34 +159,10 @@ gboolean vfs_file_info_get( VFSFileInfo* fi,
 
     if ( lstat64( file_path, &file_stat ) == 0 )
     {
-        /* This is time-consuming but can save much memory */
-        fi->mode = file_stat.st_mode;
-        fi->dev = file_stat.st_dev;
-        fi->uid = file_stat.st_uid;
-        fi->gid = file_stat.st_gid;
-        fi->size = file_stat.st_size;
-//printf("size %s %llu\n", fi->name, fi->size );
-        fi->mtime = file_stat.st_mtime;
-        fi->atime = file_stat.st_atime;
-        fi->blksize = file_stat.st_blksize;
-        fi->blocks = file_stat.st_blocks;
-
-        if ( G_LIKELY( utf8_file_name && g_utf8_validate ( fi->name, -1, NULL ) ) )
-        {
-            fi->disp_name = fi->name;   /* Don't duplicate the name and save memory */
-        }
-        else
-        {
-            fi->disp_name = g_filename_display_name( fi->name );
-        }
+        set_stat( fi, &file_stat );
         fi->mime_type = vfs_mime_type_get_from_file( file_path,
                                                      fi->disp_name,
                                                      &file_stat );
-        //sfm get collate keys
-        fi->collate_key = g_utf8_collate_key_for_filename( fi->disp_name, -1 );
-        char* str = g_utf8_casefold( fi->disp_name, -1 );
-        fi->collate_icase_key = g_utf8_collate_key_for_filename( str, -1 );
-        g_free( str );
         return TRUE;
     }
     else
@@ -161,6 +170,86 @@ gboolean vfs_file_info_get( VFSFileInfo* fi,
     return FALSE;
 }
 
+void vfs_file_info_get_from_dirent( VFSFileInfo* fi,
+                                    const char* base_name,
+                                    unsigned char d_type )
+{
+    vfs_file_info_clear( fi );
+    fi->name = g_strdup( base_name );
+    fi->mode = d_type == DT_UNKNOWN ? S_IFREG : DTTOIF( d_type );
+    fi->flags = VFS_FILE_INFO_PENDING;
+
+    if ( G_LIKELY( utf8_file_name && g_utf8_validate ( fi->name, -1, NULL ) ) )
+        fi->disp_name = fi->name;
+    else
+        fi->disp_name = g_filename_display_name( fi->name );
+    // guess from the name alone until the real type is sniffed
+    if ( S_ISDIR( fi->mode ) )
+        fi->mime_type = vfs_mime_type_get_from_type( XDG_MIME_TYPE_DIRECTORY );
+    else
+        fi->mime_type = vfs_mime_type_get_from_file_name( fi->disp_name );
+}
+
+void vfs_file_info_get_from_stat( VFSFileInfo* fi,
+                                  const char* base_name,
+                                  struct stat64* file_stat )
+{
+    vfs_file_info_clear( fi );
+    fi->name = g_strdup( base_name );
+    set_stat( fi, file_stat );
+    // guess from the name alone until vfs_file_info_reload_mime_type()
+    if ( S_ISDIR( fi->mode ) )
+        fi->mime_type = vfs_mime_type_get_from_type( XDG_MIME_TYPE_DIRECTORY );
+    else
+        fi->mime_type = vfs_mime_type_get_from_file_name( fi->disp_name );
+}
+
+/* Replace the contents of fi with those of src, a file of the same name,
+ * leaving src empty.  fi keeps its name string, which others may be
+ * reading, and its display name and sort keys unless the display name
+ * changed.  Any thumbnails already loaded for fi are kept if src has none. */
+void vfs_file_info_take( VFSFileInfo* fi, VFSFileInfo* src )
+{
+    VFSFileInfo old = *fi;
+
+    *fi = *src;
+    fi->n_ref = old.n_ref;
+    fi->name = old.name;
+    if ( !strcmp( old.disp_name, src->disp_name ) )
+    {
+        fi->disp_name = old.disp_name;
+        fi->collate_key = old.collate_key;
+        fi->collate_icase_key = old.collate_icase_key;
+        if ( src->disp_name != src->name )
+            g_free( src->disp_name );
+        free_collate_keys( src );
+    }
+    else
+    {
+        // a desktop entry showing its Name=
+        if ( src->disp_name == src->name )
+            fi->disp_name = fi->name;
+        if ( old.disp_name != old.name )
+            g_free( old.disp_name );
+        free_collate_keys( &old );
+    }
+    g_free( src->name );
+
+    if ( old.mime_type )
+        vfs_mime_type_unref( old.mime_type );
+    if ( !fi->big_thumbnail )
+        fi->big_thumbnail = old.big_thumbnail;
+    else if ( old.big_thumbnail )
+        g_object_unref( old.big_thumbnail );
+    if ( !fi->small_thumbnail )
+        fi->small_thumbnail = old.small_thumbnail;
+    else if ( old.small_thumbnail )
+        g_object_unref( old.small_thumbnail );
+
+    memset( src, 0, sizeof( VFSFileInfo ) );
+    src->n_ref = 1;
+}
+
 const char* vfs_file_info_get_name( VFSFileInfo* fi )
 {
     return fi->name;
@@ -177,13 +266,52 @@ void vfs_file_info_set_disp_name( VFSFileInfo* fi, const char* name )
     if ( fi->disp_name && fi->disp_name != fi->name )
         g_free( fi->disp_name );
     fi->disp_name = g_strdup( name );
-    //sfm get new collate keys
-    g_free( fi->collate_key );
-    g_free( fi->collate_icase_key );
-    fi->collate_key = g_utf8_collate_key_for_filename( fi->disp_name, -1 );
-    char* str = g_utf8_casefold( fi->disp_name, -1 );
+    //sfm sort keys are rebuilt on demand
+    free_collate_keys( fi );
+}
+
+/* Natural sort key for disp_name, built the first time the list is sorted
+ * in that mode.  Only call from the main thread. */
+const char* vfs_file_info_get_collate_key( VFSFileInfo* fi, gboolean icase )
+{
+    const char* p;
+    gboolean ascii = TRUE;
+    gboolean upper = FALSE;
+    char* str;
+
+    if ( !icase )
+    {
+        if ( G_UNLIKELY( !fi->collate_key ) )
+            fi->collate_key = g_utf8_collate_key_for_filename( fi->disp_name,
+                                                                -1 );
+        return fi->collate_key;
+    }
+    if ( G_LIKELY( fi->collate_icase_key ) )
+        return fi->collate_icase_key;
+
+    for ( p = fi->disp_name; *p; p++ )
+    {
+        if ( (guchar)*p >= 0x80 )
+        {
+            ascii = FALSE;
+            break;
+        }
+        if ( g_ascii_isupper( *p ) )
+            upper = TRUE;
+    }
+    if ( ascii && !upper )
+    {
+        // plain lowercase ASCII folds to itself - share the key
+        fi->collate_icase_key = (char*)vfs_file_info_get_collate_key( fi,
+                                                                      FALSE );
+        return fi->collate_icase_key;
+    }
+    // for ASCII names casefolding is plain lowercasing
+    str = ascii ? g_ascii_strdown( fi->disp_name, -1 ) :
+                  g_utf8_casefold( fi->disp_name, -1 );
     fi->collate_icase_key = g_utf8_collate_key_for_filename( str, -1 );
     g_free( str );
+    return fi->collate_icase_key;
 }
 
 void vfs_file_info_set_name( VFSFileInfo* fi, const char* name )
@@ -197,15 +325,40 @@ off_t vfs_file_info_get_size( VFSFileInfo* fi )
     return fi->size;
 }
 
+static DispCacheEntry* disp_cache_lookup( DispCacheEntry* cache, guint64 key )
+{
+    guint i = (guint)( ( key * G_GUINT64_CONSTANT( 0x9E3779B97F4A7C15 ) ) >> 32 );
+    DispCacheEntry* ent = &cache[ i & ( DISP_CACHE_SIZE - 1 ) ];
+    if ( ent->used && ent->key == key )
+        return ent;
+    ent->used = FALSE;
+    ent->key = key;
+    return ent;
+}
+
+static void disp_cache_clear( DispCacheEntry* cache )
+{
+    int i;
+    for ( i = 0; i < DISP_CACHE_SIZE; ++i )
+        cache[ i ].used = FALSE;
+}
+
 const char* vfs_file_info_get_disp_size( VFSFileInfo* fi )
 {
-    if ( G_UNLIKELY( !fi->disp_size ) )
+    DispCacheEntry* ent;
+
+    if ( G_UNLIKELY( size_cache_si != app_settings.use_si_prefix ) )
+    {
+        disp_cache_clear( size_cache );
+        size_cache_si = app_settings.use_si_prefix;
+    }
+    ent = disp_cache_lookup( size_cache, (guint64)fi->size );
+    if ( G_UNLIKELY( !ent->used ) )
     {
-        char buf[ 64 ];
-        vfs_file_size_to_string( buf, fi->size );
-        fi->disp_size = g_strdup( buf );
+        vfs_file_size_to_string( ent->str, fi->size );
+        ent->used = TRUE;
     }
-    return fi->disp_size;
+    return ent->str;
 }
 
 off_t vfs_file_info_get_blocks( VFSFileInfo* fi )
@@ -330,10 +483,21 @@ const char* vfs_file_info_get_disp_owner( VFSFileInfo* fi )
     char* user_name;
     char gid_str_buf[ 32 ];
     char* group_name;
-
-    /* FIXME: user names should be cached */
-    if ( ! fi->disp_owner )
+    guint64 id;
+    char* owner;
+
+    if ( G_LIKELY( fi->disp_owner ) )
+        return fi->disp_owner;
+
+    id = ( (guint64)fi->uid << 32 ) | fi->gid;
+    G_LOCK( owner_hash );
+    if ( G_UNLIKELY( !owner_hash ) )
+        owner_hash = g_hash_table_new( g_int64_hash, g_int64_equal );
+    owner = (char*)g_hash_table_lookup( owner_hash, &id );
+    if ( ! owner )
     {
+        guint64* key;
+
         puser = getpwuid( fi->uid );
         if ( puser && puser->pw_name && *puser->pw_name )
             user_name = puser->pw_name;
@@ -351,22 +515,37 @@ const char* vfs_file_info_get_disp_owner( VFSFileInfo* fi )
             sprintf( gid_str_buf, "%d", fi->gid );
             group_name = gid_str_buf;
         }
-        fi->disp_owner = g_strdup_printf ( "%s:%s", user_name, group_name );
+        owner = g_strdup_printf ( "%s:%s", user_name, group_name );
+        key = g_slice_new( guint64 );
+        *key = id;
+        g_hash_table_insert( owner_hash, key, owner );
     }
-    return fi->disp_owner;
+    G_UNLOCK( owner_hash );
+    fi->disp_owner = owner;
+    return owner;
 }
 
 const char* vfs_file_info_get_disp_mtime( VFSFileInfo* fi )
 {
-    if ( ! fi->disp_mtime )
+    DispCacheEntry* ent;
+
+    if ( G_UNLIKELY( g_strcmp0( mtime_cache_format,
+                                app_settings.date_format ) ) )
+    {
+        disp_cache_clear( mtime_cache );
+        g_free( mtime_cache_format );
+        mtime_cache_format = g_strdup( app_settings.date_format );
+    }
+    ent = disp_cache_lookup( mtime_cache, (guint64)fi->mtime );
+    if ( G_UNLIKELY( !ent->used ) )
     {
-        char buf[ 64 ];
-        strftime( buf, sizeof( buf ),
-                  app_settings.date_format, //"%Y-%m-%d %H:%M",
-                  localtime( &fi->mtime ) );
-        fi->disp_mtime = g_strdup( buf );
+        if ( !strftime( ent->str, sizeof( ent->str ),
+                        app_settings.date_format, //"%Y-%m-%d %H:%M",
+                        localtime( &fi->mtime ) ) )
+            ent->str[ 0 ] = '\0';
+        ent->used = TRUE;
     }
-    return fi->disp_mtime;
+    return ent->str;
 }
 
 time_t* vfs_file_info_get_mtime( VFSFileInfo* fi )
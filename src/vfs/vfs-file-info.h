@@ -39,7 +39,8 @@ typedef enum
     VFS_FILE_INFO_DESKTOP_ENTRY = (1 << 2),
     VFS_FILE_INFO_MOUNT_POINT = (1 << 3),
     VFS_FILE_INFO_REMOTE = (1 << 4),
-    VFS_FILE_INFO_VIRTUAL = (1 << 5)
+    VFS_FILE_INFO_VIRTUAL = (1 << 5),
+    VFS_FILE_INFO_PENDING = (1 << 6)  /* only the name is loaded so far */
 }VFSFileInfoFlag;   /* For future use, not all supported now */
 
 typedef struct _VFSFileInfo VFSFileInfo;
@@ -49,6 +50,7 @@ struct _VFSFileInfo
     /* struct stat64 file_stat; */
     /* Only use some members of struct stat64 to reduce memory usage */
     mode_t mode;
+    VFSFileInfoFlag flags; /* if it's a special file */
     dev_t dev;
     uid_t uid;
     gid_t gid;
@@ -60,17 +62,14 @@ struct _VFSFileInfo
 
     char* name; /* real name on file system */
     char* disp_name;  /* displayed name (in UTF-8) */
-    char* collate_key;  //sfm sort key
-    char* collate_icase_key;  //sfm case folded sort key
-    char* disp_size;  /* displayed human-readable file size */
-    char* disp_owner; /* displayed owner:group pair */
-    char* disp_mtime; /* displayed last modification time */
-    char disp_perm[ 12 ];  /* displayed permission in string form */
+    char* collate_key;  //sfm sort key, built on demand
+    char* collate_icase_key;  //sfm case folded sort key, may == collate_key
+    const char* disp_owner; /* displayed owner:group pair, interned */
     VFSMimeType* mime_type; /* mime type related information */
     GdkPixbuf* big_thumbnail; /* thumbnail of the file */
     GdkPixbuf* small_thumbnail; /* thumbnail of the file */
+    char disp_perm[ 12 ];  /* displayed permission in string form */
 
-    VFSFileInfoFlag flags; /* if it's a special file */
     /*<private>*/
     int n_ref;
 };
@@ -85,13 +84,29 @@ gboolean vfs_file_info_get( VFSFileInfo* fi,
                             const char* file_path,
                             const char* base_name );
 
+/* Fill in what a dir entry tells without touching the disk - the name and,
+ * when d_type is known, the file type.  The rest is loaded later by
+ * vfs_file_info_get() and moved over with vfs_file_info_take() */
+void vfs_file_info_get_from_dirent( VFSFileInfo* fi,
+                                    const char* base_name,
+                                    unsigned char d_type );
+/* Fill in fi from file_stat, the lstat of the file, without reading the
+ * file - the mime type is guessed from the name until
+ * vfs_file_info_reload_mime_type() is called */
+void vfs_file_info_get_from_stat( VFSFileInfo* fi,
+                                  const char* base_name,
+                                  struct stat64* file_stat );
+void vfs_file_info_take( VFSFileInfo* fi, VFSFileInfo* src );
+
 const char* vfs_file_info_get_name( VFSFileInfo* fi );
 const char* vfs_file_info_get_disp_name( VFSFileInfo* fi );
 
 void vfs_file_info_set_name( VFSFileInfo* fi, const char* name );
 void vfs_file_info_set_disp_name( VFSFileInfo* fi, const char* name );
+const char* vfs_file_info_get_collate_key( VFSFileInfo* fi, gboolean icase );
 
 off_t vfs_file_info_get_size( VFSFileInfo* fi );
+/* Formatted into a shared cache - copy the result before the next call */
 const char* vfs_file_info_get_disp_size( VFSFileInfo* fi );
 
 off_t vfs_file_info_get_blocks( VFSFileInfo* fi );
@@ -105,6 +120,7 @@ void vfs_file_info_reload_mime_type( VFSFileInfo* fi,
 const char* vfs_file_info_get_mime_type_desc( VFSFileInfo* fi );
 
 const char* vfs_file_info_get_disp_owner( VFSFileInfo* fi );
+/* Formatted into a shared cache - copy the result before the next call */
 const char* vfs_file_info_get_disp_mtime( VFSFileInfo* fi );
 const char* vfs_file_info_get_disp_perm( VFSFileInfo* fi );
 
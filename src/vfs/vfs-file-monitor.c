@@ -25,6 +25,7 @@
 #include <sys/types.h>  /* for stat */
 #include <sys/stat.h>
 #include <errno.h>
+#include <limits.h>  /* for NAME_MAX */
 
 #include <stdlib.h>
 #include <string.h>
@@ -43,6 +44,7 @@ static GIOChannel* fam_io_channel = NULL;
 static guint fam_io_watch = 0;
 #ifdef USE_INOTIFY
 static int inotify_fd = -1;
+static GHashTable* wd_hash = NULL;   // watch descriptor -> monitor
 #else
 static FAMConnection fam;
 #endif
@@ -127,6 +129,13 @@ void vfs_file_monitor_clean()
         g_hash_table_destroy( monitor_hash );
         monitor_hash = NULL;
     }
+#ifdef USE_INOTIFY
+    if ( wd_hash )
+    {
+        g_hash_table_destroy( wd_hash );
+        wd_hash = NULL;
+    }
+#endif
 }
 
 /*
@@ -136,6 +145,9 @@ void vfs_file_monitor_clean()
 gboolean vfs_file_monitor_init()
 {
     monitor_hash = g_hash_table_new( g_str_hash, g_str_equal );
+#ifdef USE_INOTIFY
+    wd_hash = g_hash_table_new( g_direct_hash, g_direct_equal );
+#endif
     if ( ! connect_to_fam() )
         return FALSE;
     return TRUE;
@@ -241,6 +253,9 @@ VFSFileMonitor* vfs_file_monitor_add( char* path,
                         real_path, path, errno, msg );
             return NULL;
         }
+        // inotify returns the same wd for two paths to one inode - keep the first
+        if ( !g_hash_table_lookup( wd_hash, GINT_TO_POINTER( monitor->wd ) ) )
+            g_hash_table_insert( wd_hash, GINT_TO_POINTER( monitor->wd ), monitor );
 //printf("vfs_file_monitor_add  %s (%s) %d\n", real_path, path, monitor->wd );
 
 #else /* Use FAM|gamin */
@@ -285,6 +300,17 @@ VFSFileMonitor* vfs_file_monitor_add( char* path,
     return monitor;
 }
 
+#ifdef USE_INOTIFY
+static gboolean find_other_monitor( gpointer key,
+                                    gpointer value,
+                                    gpointer user_data )
+{
+    VFSFileMonitor* fm = ( VFSFileMonitor* ) user_data;
+    VFSFileMonitor* monitor = ( VFSFileMonitor* ) value;
+    return ( monitor != fm && monitor->wd == fm->wd );
+}
+#endif
+
 void vfs_file_monitor_remove( VFSFileMonitor * fm,
                               VFSFileMonitorCallback cb,
                               gpointer user_data )
@@ -311,6 +337,18 @@ void vfs_file_monitor_remove( VFSFileMonitor * fm,
 #ifdef USE_INOTIFY /* Linux inotify */
 //printf( "vfs_file_monitor_remove  %d\n", fm->wd );
         inotify_rm_watch ( inotify_fd, fm->wd );
+        if ( fm->wd >= 0 &&
+                g_hash_table_lookup( wd_hash, GINT_TO_POINTER( fm->wd ) ) == fm )
+        {
+            VFSFileMonitor* other;
+            g_hash_table_remove( wd_hash, GINT_TO_POINTER( fm->wd ) );
+            // hand the wd over to another monitor sharing it, if any
+            other = ( VFSFileMonitor* ) g_hash_table_find( monitor_hash,
+                                                find_other_monitor, fm );
+            if ( other )
+                g_hash_table_insert( wd_hash, GINT_TO_POINTER( fm->wd ),
+                                                                    other );
+        }
 #else /*  Use FAM|gamin */
         if ( fam_io_channel )
             FAMCancelMonitor( &fam, &fm->request );
@@ -351,6 +389,8 @@ static void reconnect_fam( gpointer key,
                         g_strerror ( errno ) );
             return ;
         }
+        if ( !g_hash_table_lookup( wd_hash, GINT_TO_POINTER( monitor->wd ) ) )
+            g_hash_table_insert( wd_hash, GINT_TO_POINTER( monitor->wd ), monitor );
 #else
         if ( S_ISDIR( file_stat.st_mode ) )
         {
@@ -372,15 +412,6 @@ static void reconnect_fam( gpointer key,
 }
 
 #ifdef USE_INOTIFY
-static gboolean find_monitor( gpointer key,
-                              gpointer value,
-                              gpointer user_data )
-{
-    int wd = GPOINTER_TO_INT( user_data );
-    VFSFileMonitor* monitor = ( VFSFileMonitor* ) value;
-    return ( monitor->wd == wd );
-}
-
 static VFSFileMonitorEvent translate_inotify_event( int inotify_mask )
 {
     if ( inotify_mask & ( IN_CREATE | IN_MOVED_TO ) )
@@ -417,14 +448,36 @@ static void dispatch_event( VFSFileMonitor * monitor,
     }
 }
 
+#ifdef USE_INOTIFY
+static void dispatch_overflow()
+{
+    GList* monitors;
+    GList* l;
+
+    /* The kernel queue overflowed, so any monitor may have missed events.
+     * Hold a ref on each since callbacks may remove monitors. */
+    monitors = g_hash_table_get_values( monitor_hash );
+    for ( l = monitors; l; l = l->next )
+        g_atomic_int_inc( &( ( VFSFileMonitor* ) l->data )->n_ref );
+    for ( l = monitors; l; l = l->next )
+    {
+        VFSFileMonitor* monitor = ( VFSFileMonitor* ) l->data;
+        dispatch_event( monitor, VFS_FILE_MONITOR_OVERFLOW, monitor->path );
+        vfs_file_monitor_remove( monitor, NULL, NULL );
+    }
+    g_list_free( monitors );
+}
+#endif
+
 /* event handler of all FAM events */
 static gboolean on_fam_event( GIOChannel * channel,
                               GIOCondition cond,
                               gpointer user_data )
 {
 #ifdef USE_INOTIFY /* Linux inootify */
-#define BUF_LEN (1024 * (sizeof (struct inotify_event) + 16))
-    char buf[ BUF_LEN ];
+/* room for at least 256 events with full length names per read */
+#define BUF_LEN (256 * (sizeof (struct inotify_event) + NAME_MAX + 1))
+    static char buf[ BUF_LEN ] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
     int i, len;
 #else /* FAM|gamin */
     FAMEvent evt;
@@ -442,6 +495,10 @@ static gboolean on_fam_event( GIOChannel * channel,
               This may be caused by crash of FAM server.
               So we have to reconnect to FAM server.
             */
+#ifdef USE_INOTIFY
+            // the new inotify fd hands out new watch descriptors
+            g_hash_table_remove_all( wd_hash );
+#endif
             if ( connect_to_fam() )
                 g_hash_table_foreach( monitor_hash, ( GHFunc ) reconnect_fam,
                                                                         NULL );
@@ -451,39 +508,50 @@ static gboolean on_fam_event( GIOChannel * channel,
     }
 
 #ifdef USE_INOTIFY /* Linux inotify */
-    while ( ( len = read ( inotify_fd, buf, BUF_LEN ) ) < 0
-            && errno == EINTR );
-    if ( len < 0 )
+    /* The fd is non-blocking, so drain everything queued in one wakeup
+     * rather than returning to the main loop after each read */
+    while ( inotify_fd >= 0 )
     {
-        g_warning ( "Error reading inotify event: %s",
-                    g_strerror ( errno ) );
-        /* goto error_cancel; */
-        return FALSE;
-    }
+        while ( ( len = read ( inotify_fd, buf, BUF_LEN ) ) < 0
+                && errno == EINTR );
+        if ( len < 0 )
+        {
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                break;
+            g_warning ( "Error reading inotify event: %s",
+                        g_strerror ( errno ) );
+            /* goto error_cancel; */
+            return FALSE;
+        }
 
-    if ( len == 0 )
-    {
-        /*
-        * FIXME: handle this better?
-        */
-        g_warning ( "Error reading inotify event: supplied buffer was too small" );
-        /* goto error_cancel; */
-        return FALSE;
-    }
-    i = 0;
-    while ( i < len )
-    {
-        struct inotify_event * ievent = ( struct inotify_event * ) & buf [ i ];
-        /* FIXME: 2 different paths can have the same wd because of link
-         *        This was fixed in spacefm 0.8.7 ?? */
-        monitor = ( VFSFileMonitor* ) g_hash_table_find(
-                      monitor_hash,
-                      find_monitor,
-                      GINT_TO_POINTER( ievent->wd ) );
-        if( G_LIKELY(monitor) )
+        if ( len == 0 )
         {
-            const char* file_name;
-            file_name = ievent->len > 0 ? ievent->name : monitor->path;
+            /*
+            * FIXME: handle this better?
+            */
+            g_warning ( "Error reading inotify event: supplied buffer was too small" );
+            /* goto error_cancel; */
+            return FALSE;
+        }
+        i = 0;
+        while ( i < len )
+        {
+            struct inotify_event * ievent = ( struct inotify_event * ) & buf [ i ];
+            if ( G_UNLIKELY( ievent->mask & IN_Q_OVERFLOW ) )
+            {
+                g_warning( "inotify event queue overflowed" );
+                dispatch_overflow();
+                i += sizeof ( struct inotify_event ) + ievent->len;
+                continue;
+            }
+            /* 2 different paths can have the same wd because of link - the
+             * first monitor added gets the events */
+            monitor = ( VFSFileMonitor* ) g_hash_table_lookup( wd_hash,
+                                                GINT_TO_POINTER( ievent->wd ) );
+            if( G_LIKELY(monitor) )
+            {
+                const char* file_name;
+                file_name = ievent->len > 0 ? ievent->name : monitor->path;
 /*
 //MOD for debug output only
 char* desc;
@@ -503,11 +571,12 @@ else
     printf("inotify-event %s: %s///%s\n", desc, monitor->path, file_name);
 //g_debug("inotify (%d) :%s", ievent->mask, file_name);
 */
-            dispatch_event( monitor,
-                            translate_inotify_event( ievent->mask ),
-                            file_name );
+                dispatch_event( monitor,
+                                translate_inotify_event( ievent->mask ),
+                                file_name );
+            }
+            i += sizeof ( struct inotify_event ) + ievent->len;
         }
-        i += sizeof ( struct inotify_event ) + ievent->len;
     }
 #else /* FAM|gamin */
     while ( FAMPending( &fam ) )
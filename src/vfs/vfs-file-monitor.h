@@ -38,13 +38,15 @@ G_BEGIN_DECLS
 typedef enum{
   VFS_FILE_MONITOR_CREATE,
   VFS_FILE_MONITOR_DELETE,
-  VFS_FILE_MONITOR_CHANGE
+  VFS_FILE_MONITOR_CHANGE,
+  VFS_FILE_MONITOR_OVERFLOW  /* events were lost, file_name is fm->path */
 }VFSFileMonitorEvent;
 #else
 typedef enum{
   VFS_FILE_MONITOR_CREATE = FAMCreated,
   VFS_FILE_MONITOR_DELETE = FAMDeleted,
-  VFS_FILE_MONITOR_CHANGE = FAMChanged
+  VFS_FILE_MONITOR_CHANGE = FAMChanged,
+  VFS_FILE_MONITOR_OVERFLOW = -1  /* not sent by FAM */
 }VFSFileMonitorEvent;
 #endif
 
@@ -20,6 +20,14 @@
 #include <utime.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>  /* for major, minor */
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>  /* for FICLONE */
+#endif
 
 #include <glib.h>
 #include "glib-mem.h"
@@ -32,6 +40,7 @@
 #include <errno.h>
 
 #include "vfs-dir.h"
+#include "vfs-dir-size.h"
 #include "settings.h"
 #include <sys/wait.h> //MOD for exec
 #include "main-window.h"
@@ -46,19 +55,6 @@ const mode_t chmod_flags[] =
         S_ISUID, S_ISGID, S_ISVTX
     };
 
-/*
-* void get_total_size_of_dir( const char* path, off_t* size )
-* Recursively count total size of all files in the specified directory.
-* If the path specified is a file, the size of the file is directly returned.
-* cancel is used to cancel the operation. This function will check the value
-* pointed by cancel in every iteration. If cancel is set to TRUE, the
-* calculation is cancelled.
-* NOTE: *size should be set to zero before calling this function.
-*/
-static void get_total_size_of_dir( VFSFileTask* task,
-                                   const char* path,
-                                   off_t* size,
-                                   struct stat64* have_stat );
 void vfs_file_task_error( VFSFileTask* task, int errnox, const char* action,
                                                             const char* target );
 void vfs_file_task_exec_error( VFSFileTask* task, int errnox, char* action );
@@ -347,6 +343,582 @@ void update_file_display( const char* path )
 }
 */
 
+/*
+* Copying and deleting of single files is done by FileJobs.  If the task has
+* a pool, the task thread walks the source tree and pushes jobs to the pool
+* workers; otherwise it runs each job itself.  Overwrite queries happen in
+* the task thread before a job is created, and a worker never calls
+* vfs_file_task_error() or should_abort() - it keeps the first error in
+* the job, which the task thread reports when the job is finished.
+*/
+#define FILE_JOB_MAX_WORKERS 8
+#define FILE_JOB_QUEUE_PER_WORKER 4
+
+typedef enum
+{
+    FILE_JOB_COPY,
+    FILE_JOB_DELETE
+} FileJobType;
+
+typedef struct
+{
+    VFSFileTask* task;
+    FileJobType type;
+    char* src_file;
+    char* dest_file;
+    struct stat64 file_stat;    /* of src_file */
+    int rfd;                    /* src_file, opened by the task thread */
+    int wfd;
+    gboolean in_worker;
+    gboolean failed;
+    int error;                  /* first error in a worker */
+    const char* action;
+    char* target;
+} FileJob;
+
+static FileJob* file_job_new( VFSFileTask* task, FileJobType type,
+                              const char* src_file, const char* dest_file,
+                              struct stat64* file_stat )
+{
+    FileJob* job = g_slice_new0( FileJob );
+    job->task = task;
+    job->type = type;
+    job->src_file = g_strdup( src_file );
+    job->dest_file = g_strdup( dest_file );
+    job->file_stat = *file_stat;
+    job->rfd = job->wfd = -1;
+    return job;
+}
+
+static void file_job_error( FileJob* job, int errnox, const char* action,
+                                                    const char* target )
+{
+    job->failed = TRUE;
+    if ( !job->in_worker )
+        vfs_file_task_error( job->task, errnox, action, target );
+    else if ( !job->action )
+    {
+        job->error = errnox;
+        job->action = action;
+        job->target = g_strdup( target );
+    }
+}
+
+static gboolean file_job_should_abort( FileJob* job )
+{
+    // workers must not wait on pause_cond, which belongs to the task thread
+    return job->in_worker ? job->task->abort : should_abort( job->task );
+}
+
+/*
+* Copy backends for the data of a regular file, tried in order by
+* copy_file_data().  A backend returns COPY_UNSUPPORTED only if nothing has
+* been written yet, so the next backend can start over.  On COPY_FAILED the
+* error has already been given to the job, or the task was aborted.
+*/
+#define COPY_CHUNK_SIZE  ( 8 * 1024 * 1024 ) /* per syscall for in-kernel copies */
+#define COPY_BUFFER_SIZE ( 1024 * 1024 )     /* read/write fallback buffer */
+
+typedef enum
+{
+    COPY_OK,
+    COPY_UNSUPPORTED,
+    COPY_FAILED
+} CopyResult;
+
+typedef CopyResult ( *CopyBackend ) ( FileJob* job );
+
+static void add_task_progress( VFSFileTask* task, off64_t size )
+{
+    g_mutex_lock( task->mutex );
+    task->progress += size;
+    g_mutex_unlock( task->mutex );
+}
+
+static gboolean is_copy_unsupported( int errnox )
+{
+    // kernel or filesystem can't do this kind of copy between these fds
+    return errnox == ENOSYS || errnox == EXDEV || errnox == EINVAL ||
+           errnox == EOPNOTSUPP || errnox == ENOTTY;
+}
+
+static CopyResult copy_reflink( FileJob* job )
+{
+#ifdef FICLONE
+    // share the extents (btrfs, xfs) - no data is copied
+    if ( ioctl( job->wfd, FICLONE, job->rfd ) == 0 )
+    {
+        add_task_progress( job->task, job->file_stat.st_size );
+        return COPY_OK;
+    }
+#endif
+    return COPY_UNSUPPORTED;
+}
+
+/* copy_file_range and sendfile both copy in the kernel, advancing the file
+ * offsets of both fds.  copy_file_range may also be offloaded by the
+ * filesystem, eg server-side copy on nfs 4.2 */
+static CopyResult copy_in_kernel( FileJob* job, gboolean use_sendfile )
+{
+#ifdef __linux__
+    ssize_t n;
+    off64_t copied = 0;
+
+#ifndef __NR_copy_file_range
+    if ( !use_sendfile )
+        return COPY_UNSUPPORTED;
+#endif
+
+    while ( 1 )
+    {
+        if ( file_job_should_abort( job ) )
+            return COPY_FAILED;
+        if ( use_sendfile )
+            n = sendfile( job->wfd, job->rfd, NULL, COPY_CHUNK_SIZE );
+#ifdef __NR_copy_file_range
+        else
+            n = syscall( __NR_copy_file_range, job->rfd, NULL,
+                                               job->wfd, NULL,
+                                               COPY_CHUNK_SIZE, 0 );
+#endif
+        if ( n > 0 )
+        {
+            copied += n;
+            add_task_progress( job->task, n );
+        }
+        else if ( n == 0 )
+        {
+            // some virtual filesystems (eg /proc, which also reports a
+            // size of zero) give eof without copying anything, so let an
+            // empty result fall back to plain reads
+            if ( copied == 0 )
+                return COPY_UNSUPPORTED;
+            return COPY_OK;
+        }
+        else if ( errno != EINTR )
+        {
+            if ( copied == 0 && is_copy_unsupported( errno ) )
+                return COPY_UNSUPPORTED;
+            file_job_error( job, errno, _("Writing"), job->dest_file );
+            return COPY_FAILED;
+        }
+    }
+#else
+    return COPY_UNSUPPORTED;
+#endif
+}
+
+static CopyResult copy_range( FileJob* job )
+{
+    return copy_in_kernel( job, FALSE );
+}
+
+static CopyResult copy_sendfile( FileJob* job )
+{
+    return copy_in_kernel( job, TRUE );
+}
+
+static CopyResult copy_buffered( FileJob* job )
+{
+    void* buffer;
+    char* p;
+    size_t buf_size = COPY_BUFFER_SIZE;
+    ssize_t rsize, wsize;
+    CopyResult ret = COPY_OK;
+
+    // small files don't need a big buffer
+    if ( job->file_stat.st_size >= 0 && job->file_stat.st_size < buf_size )
+        buf_size = MAX( job->file_stat.st_size, 4096 );
+    // page aligned for the kernel's copies to and from user space
+    if ( posix_memalign( &buffer, 4096, buf_size ) != 0 )
+    {
+        file_job_error( job, ENOMEM, _("Copying"), job->src_file );
+        return COPY_FAILED;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise( job->rfd, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif
+
+    while ( ( rsize = read( job->rfd, buffer, buf_size ) ) != 0 )
+    {
+        if ( rsize < 0 )
+        {
+            if ( errno == EINTR )
+                continue;
+            file_job_error( job, errno, _("Reading"), job->src_file );
+            ret = COPY_FAILED;
+            break;
+        }
+        if ( file_job_should_abort( job ) )
+        {
+            ret = COPY_FAILED;
+            break;
+        }
+        for ( p = buffer; p < (char*)buffer + rsize; p += wsize )
+        {
+            wsize = write( job->wfd, p, (char*)buffer + rsize - p );
+            if ( wsize < 0 )
+            {
+                if ( errno == EINTR )
+                {
+                    wsize = 0;
+                    continue;
+                }
+                file_job_error( job, errno, _("Writing"), job->dest_file );
+                ret = COPY_FAILED;
+                break;
+            }
+        }
+        if ( ret != COPY_OK )
+            break;
+        add_task_progress( job->task, rsize );
+    }
+    free( buffer );
+    return ret;
+}
+
+static gboolean copy_file_data( FileJob* job )
+{
+    static const CopyBackend backends[] =
+    {
+        copy_reflink,
+        copy_range,
+        copy_sendfile,
+        copy_buffered   // always supported
+    };
+    struct stat64 dest_stat;
+    guint i = 0;
+
+    if ( !S_ISREG( job->file_stat.st_mode ) )
+        // eg a fifo or device - just read it
+        i = G_N_ELEMENTS( backends ) - 1;
+    else if ( fstat64( job->wfd, &dest_stat ) != 0 ||
+                                dest_stat.st_dev != job->file_stat.st_dev )
+        // reflinks are only possible within a filesystem
+        i = 1;
+
+    for ( ; i < G_N_ELEMENTS( backends ); i++ )
+    {
+        switch ( backends[i]( job ) )
+        {
+        case COPY_OK:
+            return TRUE;
+        case COPY_FAILED:
+            return FALSE;
+        default:
+            break;
+        }
+    }
+    return FALSE;
+}
+
+/* Copy job->rfd to a new job->dest_file and close both */
+static void copy_regular_file( FileJob* job )
+{
+    VFSFileTask* task = job->task;
+    struct utimbuf times;
+
+    //MOD if dest is a symlink, delete it first to prevent overwriting target!
+    if ( g_file_test( job->dest_file, G_FILE_TEST_IS_SYMLINK ) &&
+                                                    unlink( job->dest_file ) )
+    {
+        file_job_error( job, errno, _("Removing"), job->dest_file );
+        goto _close_;
+    }
+
+    if ( ( job->wfd = creat( job->dest_file,
+                             job->file_stat.st_mode | S_IWUSR ) ) < 0 )
+    {
+        file_job_error( job, errno, _("Creating"), job->dest_file );
+        goto _close_;
+    }
+
+    // sshfs becomes unresponsive with this, nfs is okay with it
+    //if ( task->avoid_changes )
+    //    emit_created( dest_file );
+    if ( !copy_file_data( job ) )
+        job->failed = TRUE;
+    close( job->wfd );
+    if ( job->failed )
+    {
+        if ( unlink( job->dest_file ) && errno != 2 /* no such file */ )
+            file_job_error( job, errno, _("Removing"), job->dest_file );
+    }
+    else
+    {
+        //MOD don't chmod link
+        if ( ! g_file_test( job->dest_file, G_FILE_TEST_IS_SYMLINK ) )
+        {
+            chmod( job->dest_file, job->file_stat.st_mode );
+            times.actime = job->file_stat.st_atime;
+            times.modtime = job->file_stat.st_mtime;
+            utime( job->dest_file, &times );
+        }
+
+        /* Move files to different device: Need to delete source files */
+        if ( ( task->type == VFS_FILE_TASK_MOVE ||
+                                        task->type == VFS_FILE_TASK_TRASH )
+                                        && !file_job_should_abort( job ) )
+        {
+            if ( unlink( job->src_file ) )
+                file_job_error( job, errno, _("Removing"), job->src_file );
+        }
+    }
+_close_:
+    close( job->rfd );
+}
+
+static void delete_regular_file( FileJob* job )
+{
+    if ( unlink( job->src_file ) != 0 )
+        file_job_error( job, errno, _("Removing"), job->src_file );
+    else
+        add_task_progress( job->task, job->file_stat.st_size );
+}
+
+static void run_file_job( FileJob* job )
+{
+    if ( job->type == FILE_JOB_COPY )
+        copy_regular_file( job );
+    else
+        delete_regular_file( job );
+}
+
+/* GThreadPool func */
+static void on_file_job( FileJob* job, VFSFileTask* task )
+{
+    if ( task->abort )
+    {
+        job->failed = TRUE;
+        if ( job->rfd != -1 )
+            close( job->rfd );
+    }
+    else
+        run_file_job( job );
+    g_async_queue_push( task->done_jobs, job );
+}
+
+/* Report the outcome of a job in the task thread, and free it */
+static void finish_file_job( VFSFileTask* task, FileJob* job )
+{
+    if ( job->action )
+        vfs_file_task_error( task, job->error, job->action, job->target );
+    if ( job->failed )
+        task->n_job_fails++;
+    else
+    {
+        if ( job->type == FILE_JOB_COPY && task->avoid_changes )
+            update_file_display( job->dest_file );
+        g_mutex_lock( task->mutex );
+        if ( task->error_first )
+            task->error_first = FALSE;
+        g_mutex_unlock( task->mutex );
+    }
+    g_free( job->src_file );
+    g_free( job->dest_file );
+    g_free( job->target );
+    g_slice_free( FileJob, job );
+}
+
+/* Finish pool jobs until no more than max_jobs are outstanding */
+static void wait_file_jobs( VFSFileTask* task, guint max_jobs )
+{
+    FileJob* job;
+
+    while ( task->n_jobs > max_jobs )
+    {
+        job = (FileJob*)g_async_queue_pop( task->done_jobs );
+        task->n_jobs--;
+        finish_file_job( task, job );
+    }
+    // report what's already done without waiting
+    while ( task->n_jobs &&
+                ( job = (FileJob*)g_async_queue_try_pop( task->done_jobs ) ) )
+    {
+        task->n_jobs--;
+        finish_file_job( task, job );
+    }
+}
+
+/* Run a job in the pool if the task has one, otherwise in this thread.
+ * Returns FALSE if the job was run here and failed. */
+static gboolean do_file_job( VFSFileTask* task, FileJob* job )
+{
+    gboolean failed;
+
+    if ( task->pool )
+    {
+        // keep the walk from running far ahead of the workers
+        wait_file_jobs( task, FILE_JOB_QUEUE_PER_WORKER *
+                        g_thread_pool_get_max_threads( task->pool ) - 1 );
+        job->in_worker = TRUE;
+        task->n_jobs++;
+        g_thread_pool_push( task->pool, job, NULL );
+        return TRUE;
+    }
+    run_file_job( job );
+    failed = job->failed;
+    finish_file_job( task, job );
+    return !failed;
+}
+
+/* Find the block device behind an anonymous dev (btrfs, overlay, lvm snapshot
+ * mounts...) from the mount source in /proc/self/mountinfo.  Returns 0 if
+ * there is none.  *fstype is set to the newly allocated type of the mount,
+ * or NULL if dev isn't mounted */
+static dev_t get_backing_dev( dev_t dev, char** fstype )
+{
+    char* contents = NULL;
+    char** lines;
+    char* sep;
+    guint major, minor;
+    char** fields;
+    char* source;
+    struct stat64 statbuf;
+    dev_t backing = 0;
+    int n;
+
+    *fstype = NULL;
+    if ( !g_file_get_contents( "/proc/self/mountinfo", &contents, NULL, NULL ) )
+        return 0;
+    lines = g_strsplit( contents, "\n", 0 );
+    g_free( contents );
+    for ( n = 0; lines[n]; n++ )
+    {
+        if ( sscanf( lines[n], "%*d %*d %u:%u", &major, &minor ) != 2 ||
+                                major != major( dev ) || minor != minor( dev ) )
+            continue;
+        // the optional fields end at " - ", then fstype and mount source,
+        // which has no length limit
+        if ( !( sep = strstr( lines[n], " - " ) ) )
+            continue;
+        fields = g_strsplit( sep + 3, " ", 3 );
+        if ( fields[0] && fields[1] )
+        {
+            *fstype = g_strcompress( fields[0] );
+            source = g_strcompress( fields[1] );
+            if ( g_str_has_prefix( source, "/dev/" ) &&
+                                        stat64( source, &statbuf ) == 0 &&
+                                        S_ISBLK( statbuf.st_mode ) )
+                backing = statbuf.st_rdev;
+            g_free( source );
+        }
+        g_strfreev( fields );
+        if ( *fstype )
+            break;
+    }
+    g_strfreev( lines );
+    return backing;
+}
+
+/* Whether a filesystem without a block device is latency bound - on the
+ * network, in user space or in memory - rather than on a disk that seeks */
+static gboolean is_latency_bound_fs( const char* fstype )
+{
+    static const char* const types[] = { "nfs", "nfs4", "cifs", "smb3",
+                                         "smbfs", "9p", "ceph", "afs",
+                                         "glusterfs", "lustre", "davfs",
+                                         "tmpfs", "ramfs", NULL };
+    int i;
+
+    if ( !fstype )
+        return FALSE;
+    // fuse.sshfs, fuse.rclone... - fuseblk on a disk has a block device
+    if ( g_str_has_prefix( fstype, "fuse" ) )
+        return TRUE;
+    for ( i = 0; types[i]; i++ )
+    {
+        if ( !strcmp( fstype, types[i] ) )
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* How many files should be worked on at once on this device */
+static int get_dev_workers( dev_t dev )
+{
+    char* path;
+    char* contents = NULL;
+    char* fstype;
+    int workers = 1;    // unknown - assume a disk that seeks
+
+    if ( major( dev ) == 0 )
+    {
+        // anonymous dev - use the block device it's mounted from, if any.
+        // nfs, fuse and tmpfs have none and gain from many requests at once.
+        // overlay and others stay at one worker, as they may be on a disk
+        dev = get_backing_dev( dev, &fstype );
+        if ( major( dev ) == 0 )
+        {
+            if ( is_latency_bound_fs( fstype ) )
+                workers = FILE_JOB_MAX_WORKERS;
+            g_free( fstype );
+            return workers;
+        }
+        g_free( fstype );
+    }
+
+    path = g_strdup_printf( "/sys/dev/block/%d:%d/queue/rotational",
+                                                major( dev ), minor( dev ) );
+    if ( !g_file_get_contents( path, &contents, NULL, NULL ) )
+    {
+        // a partition - use its disk's queue
+        g_free( path );
+        path = g_strdup_printf( "/sys/dev/block/%d:%d/../queue/rotational",
+                                                major( dev ), minor( dev ) );
+        g_file_get_contents( path, &contents, NULL, NULL );
+    }
+    if ( contents && contents[0] == '0' )
+    {
+        // ssd, nvme
+        long ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+        workers = CLAMP( ncpu, 2, FILE_JOB_MAX_WORKERS );
+    }
+    g_free( contents );
+    g_free( path );
+    return workers;
+}
+
+/* Create the task's pool if all devices involved gain from parallel work */
+static void start_file_jobs( VFSFileTask* task )
+{
+    GSList* l;
+    int workers = task->devs ? FILE_JOB_MAX_WORKERS : 1;
+
+    // trash keeps a placeholder for the dest file which it removes after
+    // vfs_file_task_do_copy() returns, so it must copy synchronously
+    if ( task->type != VFS_FILE_TASK_COPY &&
+                                task->type != VFS_FILE_TASK_MOVE &&
+                                task->type != VFS_FILE_TASK_DELETE )
+        return;
+
+    for ( l = task->devs; l && workers > 1; l = l->next )
+        workers = MIN( workers,
+                        get_dev_workers( (dev_t)GPOINTER_TO_UINT( l->data ) ) );
+    if ( workers < 2 )
+        return;
+
+    task->done_jobs = g_async_queue_new();
+    task->pool = g_thread_pool_new( (GFunc)on_file_job, task, workers,
+                                                            FALSE, NULL );
+    if ( !task->pool )
+    {
+        g_async_queue_unref( task->done_jobs );
+        task->done_jobs = NULL;
+    }
+}
+
+static void stop_file_jobs( VFSFileTask* task )
+{
+    if ( !task->pool )
+        return;
+    wait_file_jobs( task, 0 );
+    g_thread_pool_free( task->pool, FALSE, TRUE );
+    task->pool = NULL;
+    g_async_queue_unref( task->done_jobs );
+    task->done_jobs = NULL;
+}
+
 static gboolean
 vfs_file_task_do_copy( VFSFileTask* task,
                        const char* src_file,
@@ -360,12 +932,13 @@ vfs_file_task_do_copy( VFSFileTask* task,
     char buffer[ 4096 ];
     int rfd;
     int wfd;
-    ssize_t rsize;
     char* new_dest_file = NULL;
     gboolean dest_exists;
     gboolean copy_fail = FALSE;
     int result;
     GError *error;
+    FileJob* job;
+    guint job_fails;
 
     if ( should_abort( task ) )
         return FALSE;
@@ -408,6 +981,7 @@ vfs_file_task_do_copy( VFSFileTask* task,
             g_mutex_lock( task->mutex );
             task->progress += file_stat.st_size;
             g_mutex_unlock( task->mutex );
+            job_fails = task->n_job_fails;
 
             error = NULL;
             dir = g_dir_open( src_file, 0, &error );
@@ -438,6 +1012,15 @@ vfs_file_task_do_copy( VFSFileTask* task,
                     goto _return_;
             }
 
+            // files must be in place before the dir's times are set or
+            // the source dir is removed
+            if ( task->pool )
+            {
+                wait_file_jobs( task, 0 );
+                if ( task->n_job_fails != job_fails )
+                    copy_fail = TRUE;
+            }
+
             chmod( dest_file, file_stat.st_mode );
             times.actime = file_stat.st_atime;
             times.modtime = file_stat.st_mtime;
@@ -546,88 +1129,14 @@ vfs_file_task_do_copy( VFSFileTask* task,
                 g_mutex_unlock( task->mutex );
             }
 
-            //MOD if dest is a symlink, delete it first to prevent overwriting target!
-            if ( g_file_test( dest_file, G_FILE_TEST_IS_SYMLINK ) )
-            {
-                result = unlink( dest_file );
-                if ( result )
-                {
-                    vfs_file_task_error( task, errno, _("Removing"), dest_file );
-                    close( rfd );
-                    goto _return_;
-                }                
-            }
-            
-            if ( ( wfd = creat( dest_file,
-                                file_stat.st_mode | S_IWUSR ) ) >= 0 )
-            {
-                // sshfs becomes unresponsive with this, nfs is okay with it
-                //if ( task->avoid_changes )
-                //    emit_created( dest_file );
-                struct utimbuf times;
-                while ( ( rsize = read( rfd, buffer, sizeof( buffer ) ) ) > 0 )
-                {
-                    if ( should_abort( task ) )
-                    {
-                        copy_fail = TRUE;
-                        break;
-                    }
-                    
-                    if ( write( wfd, buffer, rsize ) > 0 )
-                    {
-                        g_mutex_lock( task->mutex );
-                        task->progress += rsize;
-                        g_mutex_unlock( task->mutex );
-                    }
-                    else
-                    {
-                        vfs_file_task_error( task, errno, _("Writing"), dest_file );
-                        copy_fail = TRUE;
-                        break;
-                    }
-                }
-                close( wfd );
-                if ( copy_fail )
-                {
-                    result = unlink( dest_file );
-                    if ( result && errno != 2 /* no such file */ )
-                    {
-                        vfs_file_task_error( task, errno, _("Removing"), dest_file );
-                        copy_fail = TRUE;
-                    }
-                }
-                else
-                {
-                    //MOD don't chmod link
-                    if ( ! g_file_test( dest_file, G_FILE_TEST_IS_SYMLINK ) )
-                    {
-                        chmod( dest_file, file_stat.st_mode );
-                        times.actime = file_stat.st_atime;
-                        times.modtime = file_stat.st_mtime;
-                        utime( dest_file, &times );
-                    }
-                    if ( task->avoid_changes )
-                        update_file_display( dest_file );
-        
-                    /* Move files to different device: Need to delete source files */
-                    if ( (task->type == VFS_FILE_TASK_MOVE || task->type == VFS_FILE_TASK_TRASH)
-                         && !should_abort( task ) )
-                    {
-                        result = unlink( src_file );
-                        if ( result )
-                        {
-                            vfs_file_task_error( task, errno, _("Removing"), src_file );
-                            copy_fail = TRUE;
-                        }
-                    }
-                }
-            }
-            else
-            {
-                vfs_file_task_error( task, errno, _("Creating"), dest_file );
+            // the job reports its own errors and clears error_first
+            job = file_job_new( task, FILE_JOB_COPY, src_file, dest_file,
+                                                                &file_stat );
+            job->rfd = rfd;
+            if ( !do_file_job( task, job ) )
                 copy_fail = TRUE;
-            }
-            close( rfd );
+            g_free( new_dest_file );
+            return !copy_fail;
         }
         else
         {
@@ -891,6 +1400,9 @@ vfs_file_task_delete( char* src_file, VFSFileTask* task )
             g_free( msg );
         }
 
+        // contents must be gone before rmdir
+        if ( task->pool )
+            wait_file_jobs( task, 0 );
         if ( should_abort( task ) )
             return ;
         result = rmdir( src_file );
@@ -902,12 +1414,10 @@ vfs_file_task_delete( char* src_file, VFSFileTask* task )
     }
     else
     {
-        result = unlink( src_file );
-        if ( result != 0 )
-        {
-            vfs_file_task_error( task, errno, _("Removing"), src_file );
-            return ;
-        }
+        // the job adds its progress and clears error_first
+        do_file_job( task, file_job_new( task, FILE_JOB_DELETE, src_file,
+                                                        NULL, &file_stat ) );
+        return;
     }
     g_mutex_lock( task->mutex );
     task->progress += file_stat.st_size;
@@ -2034,13 +2544,55 @@ gboolean on_size_timeout( VFSFileTask* task )
     return FALSE;
 }
 
+static void on_size_scan_done( VFSDirSize* size_scan, VFSFileTask* task )
+{
+    VFSDirSizeTotals totals;
+
+    vfs_dir_size_get_totals( size_scan, &totals );
+    g_mutex_lock( task->mutex );
+    task->total_size = totals.size;
+    g_mutex_unlock( task->mutex );
+}
+
+/* Show the total size as it grows until the scan is done or times out.
+ * base_size is the size of files not being scanned.  Returns FALSE if the
+ * task was aborted */
+static gboolean wait_size_scan( VFSFileTask* task, VFSDirSize* size_scan,
+                                                   off64_t base_size )
+{
+    VFSDirSizeTotals totals;
+    GSList* devs;
+    GSList* l;
+    gboolean done;
+
+    do
+    {
+        done = vfs_dir_size_wait( size_scan, 100 );
+        vfs_dir_size_get_totals( size_scan, &totals );
+        g_mutex_lock( task->mutex );
+        task->total_size = base_size + totals.size;
+        g_mutex_unlock( task->mutex );
+
+        // remember devices for smart queue
+        devs = vfs_dir_size_steal_devs( size_scan );
+        for ( l = devs; l; l = l->next )
+            add_task_dev( task, (dev_t)GPOINTER_TO_UINT( l->data ) );
+        g_slist_free( devs );
+
+        if ( task->abort )
+            return FALSE;
+    } while ( !done && task->state != VFS_FILE_TASK_SIZE_TIMEOUT );
+    return TRUE;
+}
+
 static gpointer vfs_file_task_thread ( VFSFileTask* task )
 //void * vfs_file_task_thread ( void * ptr )
 {
     GList * l;
     struct stat64 file_stat;
     dev_t dest_dev = 0;
-    off64_t size;
+    off64_t base_size = 0;
+    VFSDirSize* size_scan = NULL;
     GFunc funcs[] = {( GFunc ) vfs_file_task_move,
                      ( GFunc ) vfs_file_task_copy,
                      ( GFunc ) vfs_file_task_move,  /* trash */
@@ -2079,6 +2631,7 @@ static gpointer vfs_file_task_thread ( VFSFileTask* task )
         // VERY slow for network filesystems
         size_timeout = g_timeout_add_seconds( 5,
                                        ( GSourceFunc ) on_size_timeout, task );
+        size_scan = vfs_dir_size_new();
         for ( l = task->src_paths; l; l = l->next )
         {
             if ( lstat64( (char*)l->data, &file_stat ) == -1 )
@@ -2087,17 +2640,7 @@ static gpointer vfs_file_task_thread ( VFSFileTask* task )
                 //vfs_file_task_error( task, errno, _("Accessing"), (char*)l->data );
             }
             else
-            {
-                size = 0;
-                get_total_size_of_dir( task, ( char* ) l->data, &size, &file_stat );
-                g_mutex_lock( task->mutex );
-                task->total_size += size;
-                g_mutex_unlock( task->mutex );
-            }
-            if ( task->abort )
-                goto _exit_thread;
-            if ( task->state == VFS_FILE_TASK_SIZE_TIMEOUT )
-                break;
+                vfs_dir_size_add( size_scan, ( char* ) l->data, &file_stat );
         }
     }
     else if ( task->type != VFS_FILE_TASK_EXEC )
@@ -2141,26 +2684,24 @@ static gpointer vfs_file_task_thread ( VFSFileTask* task )
                                                 && file_stat.st_dev != dest_dev )
                 {
                     // recursive size
-                    size = 0;
-                    get_total_size_of_dir( task, ( char* ) l->data, &size, &file_stat );
-                    g_mutex_lock( task->mutex );
-                    task->total_size += size;
-                    g_mutex_unlock( task->mutex );
+                    if ( !size_scan )
+                        size_scan = vfs_dir_size_new();
+                    vfs_dir_size_add( size_scan, ( char* ) l->data, &file_stat );
                 }
                 else
-                {
-                    g_mutex_lock( task->mutex );
-                    task->total_size += file_stat.st_size;
-                    g_mutex_unlock( task->mutex );
-                }
+                    base_size += file_stat.st_size;
             }
             if ( task->abort )
                 goto _exit_thread;
-            if ( task->state == VFS_FILE_TASK_SIZE_TIMEOUT )
-                break;
         }
+        g_mutex_lock( task->mutex );
+        task->total_size = base_size;
+        g_mutex_unlock( task->mutex );
     }
 
+    if ( size_scan && !wait_size_scan( task, size_scan, base_size ) )
+        goto _exit_thread;
+
     if ( task->dest_dir && stat64( task->dest_dir, &file_stat ) != -1 )
         add_task_dev( task, file_stat.st_dev );
 
@@ -2195,20 +2736,41 @@ static gpointer vfs_file_task_thread ( VFSFileTask* task )
     if ( task->state == VFS_FILE_TASK_SIZE_TIMEOUT )
     {
         append_add_log( task, _("Timed out calculating total size\n"), -1 );
+        g_mutex_lock( task->mutex );
         task->total_size = 0;
+        g_mutex_unlock( task->mutex );
+        if ( size_scan && !base_size && ( task->type == VFS_FILE_TASK_COPY ||
+                                task->type == VFS_FILE_TASK_CHMOD_CHOWN ) )
+        {
+            // the sources stay in place, so finish the scan in the
+            // background and show the total when it's known
+            vfs_dir_size_set_done_callback( size_scan,
+                        (VFSDirSizeDoneCallback)on_size_scan_done, task );
+            if ( vfs_dir_size_wait( size_scan, 0 ) )
+                on_size_scan_done( size_scan, task );
+        }
+        else if ( size_scan )
+            vfs_dir_size_cancel( size_scan );
     }
     task->state = VFS_FILE_TASK_RUNNING;
     if ( should_abort( task ) )
         goto _exit_thread;
 
+    start_file_jobs( task );
     g_list_foreach( task->src_paths,
                     funcs[ task->type ],
                     task );
+    stop_file_jobs( task );
 
 _exit_thread:
     task->state = VFS_FILE_TASK_RUNNING;
     if ( size_timeout )
         g_source_remove_by_user_data( task );
+    if ( size_scan )
+    {
+        vfs_dir_size_set_done_callback( size_scan, NULL, NULL );
+        vfs_dir_size_free( size_scan );
+    }
     if ( task->state_cb )
     {
         call_state_callback( task, VFS_FILE_TASK_FINISH );
@@ -2436,66 +2998,6 @@ void add_task_dev( VFSFileTask* task, dev_t dev )
     }
 }
 
-/*
-* void get_total_size_of_dir( const char* path, off_t* size )
-* Recursively count total size of all files in the specified directory.
-* If the path specified is a file, the size of the file is directly returned.
-* cancel is used to cancel the operation. This function will check the value
-* pointed by cancel in every iteration. If cancel is set to TRUE, the
-* calculation is cancelled.
-* NOTE: *size should be set to zero before calling this function.
-*/
-void get_total_size_of_dir( VFSFileTask* task,
-                            const char* path,
-                            off64_t* size,
-                            struct stat64* have_stat )
-{
-    GDir * dir;
-    const char* name;
-    char* full_path;
-    struct stat64 file_stat;
-
-    if ( task->abort )
-        return;
-
-    if ( have_stat )
-        file_stat = *have_stat;
-    else if ( lstat64( path, &file_stat ) == -1 )
-        return;
-
-    *size += file_stat.st_size;
-
-    // remember device for smart queue
-    if ( !task->devs )
-        add_task_dev( task, file_stat.st_dev );
-    else if ( (uint)file_stat.st_dev != GPOINTER_TO_UINT( task->devs->data ) )
-        add_task_dev( task, file_stat.st_dev );
-
-    // Don't follow symlinks
-    if ( S_ISLNK( file_stat.st_mode ) || !S_ISDIR( file_stat.st_mode ) )
-        return;
-
-    dir = g_dir_open( path, 0, NULL );
-    if ( dir )
-    {
-        while ( (name = g_dir_read_name( dir )) )
-        {
-            if ( task->state == VFS_FILE_TASK_SIZE_TIMEOUT || task->abort )
-                break;
-            full_path = g_build_filename( path, name, NULL );
-            if ( lstat64( full_path, &file_stat ) != -1 )
-            {
-                if ( S_ISDIR( file_stat.st_mode ) )
-                    get_total_size_of_dir( task, full_path, size, &file_stat );
-                else
-                    *size += file_stat.st_size;
-            }
-            g_free(full_path );
-        }
-        g_dir_close( dir );
-    }
-}
-
 void vfs_file_task_set_recursive( VFSFileTask* task, gboolean recursive )
 {
     task->recursive = recursive;
@@ -142,6 +142,13 @@ struct _VFSFileTask
     
     GMutex* mutex;
 
+    /* Workers for copy/delete of single files.  NULL if the task's devices
+     * are best used serially, in which case the task thread does it all */
+    GThreadPool* pool;
+    GAsyncQueue* done_jobs;  /* jobs finished by the pool */
+    guint n_jobs;  /* jobs pushed to the pool and not yet finished */
+    guint n_job_fails;
+
     //sfm write directly to gtk buffer for speed
     GtkTextBuffer* add_log_buf;
     GtkTextMark* add_log_end;
@@ -86,6 +86,7 @@ static void on_mime_cache_changed( VFSFileMonitor* fm,
          *  So if the cache is not loaded originally (the cache file is non-existent), we skip it. */
         if( ! cache->buffer )
             return;
+    case VFS_FILE_MONITOR_OVERFLOW:
     case VFS_FILE_MONITOR_CHANGE:
         mime_cache_reload( cache );
         /* g_debug( "reload cache: %s", file_name ); */
@@ -0,0 +1,560 @@
+/*
+*  C Implementation: vfs-search
+*
+* Description: Parallel search of directory trees for files by name, size,
+*              date and content
+*
+* Each dir is a job for a shared pool of workers, as in vfs-dir-size.  A
+* worker reads the dir once and tests its entries relative to the dir fd,
+* cheapest test first: the name, then the stat, and only then the content.
+* The d_type of the entries is used to find the sub-dirs, so entries whose
+* names don't match aren't even stat'd.
+*
+* Content is read in large chunks cut at line ends and searched with
+* memmem() for plain text, or with a GRegex whose matches are kept to a
+* line, as grep's are.  Files aren't mapped, since a mapped file truncated
+* during the search would kill us with SIGBUS.
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // fdopendir, fstatat64, memmem, memrchr, FNM_CASEFOLD
+#endif
+
+#include "vfs-search.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fnmatch.h>
+#include <time.h>
+
+#define SEARCH_WORKERS 8
+#define SEARCH_BUF_SIZE ( 256 * 1024 )  /* bytes of content read at once */
+
+struct _VFSSearch
+{
+    VFSSearchCriteria crit;     /* with copies of the strings */
+    int name_flags;             /* for fnmatch() */
+    GRegex* regex;              /* for text in UTF-8, NULL to use memmem() */
+    GRegex* raw_regex;          /* for anything else */
+    gsize text_len;
+    gsize carry;                /* bytes a match can span, for long lines */
+    time_t now;                 /* ages are counted from the start */
+
+    VFSSearchFoundCallback found_cb;
+    gpointer found_data;
+
+    GMutex* mutex;
+    GCond* cond;                /* signalled when pending drops to 0 */
+    guint pending;              /* dir jobs queued or running */
+    volatile gboolean cancel;
+};
+
+typedef struct
+{
+    VFSSearch* search;
+    char* path;
+} SearchJob;
+
+static GThreadPool* search_pool = NULL;
+G_LOCK_DEFINE_STATIC( search_pool );
+
+static void scan_dir( SearchJob* job, gpointer user_data );
+
+static SearchJob* new_job( VFSSearch* search, char* path )
+{
+    SearchJob* job = g_slice_new( SearchJob );
+    job->search = search;
+    job->path = path;
+    return job;
+}
+
+static void free_job( SearchJob* job )
+{
+    g_free( job->path );
+    g_slice_free( SearchJob, job );
+}
+
+static void push_jobs( GSList* jobs )
+{
+    GSList* l;
+
+    G_LOCK( search_pool );
+    if ( !search_pool )
+        search_pool = g_thread_pool_new( (GFunc)scan_dir, NULL,
+                                         SEARCH_WORKERS, FALSE, NULL );
+    for ( l = jobs; l; l = l->next )
+        g_thread_pool_push( search_pool, l->data, NULL );
+    G_UNLOCK( search_pool );
+    g_slist_free( jobs );
+}
+
+static gboolean match_name( VFSSearch* search, const char* name )
+{
+    return !search->crit.name ||
+                fnmatch( search->crit.name, name, search->name_flags ) == 0;
+}
+
+static gboolean match_stat( VFSSearch* search, struct stat64* st )
+{
+    VFSSearchCriteria* crit = &search->crit;
+    gint64 days;
+
+    if ( crit->size_lower >= 0 && st->st_size <= crit->size_lower )
+        return FALSE;
+    if ( crit->size_upper >= 0 && st->st_size > crit->size_upper )
+        return FALSE;
+    if ( crit->max_days >= 0 || crit->min_days >= 0 )
+    {
+        // whole days, the rest is dropped like find does
+        days = ( (gint64)search->now - st->st_mtime ) / 86400;
+        if ( crit->max_days >= 0 && days >= crit->max_days )
+            return FALSE;
+        if ( crit->min_days >= 0 && days <= crit->min_days )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Whether a line of data matches regex.  data is many lines at once, and
+ * \s, [^x] or \n can match across their ends, so a match that spans lines
+ * is only taken if the line it starts on matches by itself.  Being the
+ * leftmost match, no line before that one can match */
+static gboolean regex_match_lines( GRegex* regex, const char* data, gsize len )
+{
+    GMatchInfo* info = NULL;
+    const char* line;
+    const char* eol;
+    gint start, end;
+    gsize pos = 0;
+
+    while ( pos <= len )
+    {
+        if ( !g_regex_match_full( regex, data, len, pos, 0, &info, NULL ) )
+        {
+            g_match_info_free( info );
+            return FALSE;
+        }
+        g_match_info_fetch_pos( info, 0, &start, &end );
+        g_match_info_free( info );
+        info = NULL;
+        if ( !memchr( data + start, '\n', end - start ) )
+            return TRUE;
+        line = (const char*)memrchr( data, '\n', start );
+        line = line ? line + 1 : data;
+        eol = (const char*)memchr( data + start, '\n', len - start );
+        if ( g_regex_match_full( regex, line, eol - line, 0, 0, NULL, NULL ) )
+            return TRUE;
+        pos = eol + 1 - data;
+    }
+    return FALSE;
+}
+
+static gboolean search_data( VFSSearch* search, const char* data, gsize len )
+{
+    if ( !search->regex )
+        return memmem( data, len, search->crit.text, search->text_len ) != NULL;
+    if ( g_utf8_validate( data, len, NULL ) )
+        return regex_match_lines( search->regex, data, len );
+    return regex_match_lines( search->raw_regex, data, len );
+}
+
+/* Whether a line of the file contains the text.  buf is a scratch buffer of
+ * SEARCH_BUF_SIZE bytes */
+static gboolean match_text( VFSSearch* search, int dir_fd, const char* name,
+                            int open_flags, char* buf )
+{
+    gsize kept = 0, len, carry;
+    ssize_t n;
+    char* nl;
+    gboolean found = FALSE;
+    int fd;
+
+    fd = openat( dir_fd, name, O_RDONLY | O_NOCTTY | O_CLOEXEC | open_flags );
+    if ( fd == -1 )
+        return FALSE;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise( fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+#endif
+
+    // kept is the start of a line without its newline yet
+    while ( !found && !search->cancel )
+    {
+        n = read( fd, buf + kept, SEARCH_BUF_SIZE - kept );
+        if ( n == -1 && errno == EINTR )
+            continue;
+        if ( n <= 0 )
+        {
+            found = kept && search_data( search, buf, kept );
+            break;
+        }
+        len = kept + n;
+        nl = (char*)memrchr( buf + kept, '\n', n );
+        if ( !nl && len < SEARCH_BUF_SIZE )
+        {
+            kept = len;
+            continue;
+        }
+        if ( nl && len - ( nl + 1 - buf ) <= SEARCH_BUF_SIZE / 2 )
+        {
+            found = search_data( search, buf, nl + 1 - buf );
+            carry = len - ( nl + 1 - buf );
+        }
+        else
+        {
+            // a very long line is searched in pieces, overlapping so that
+            // a plain text can't be missed
+            found = search_data( search, buf, len );
+            carry = search->carry;
+        }
+        memmove( buf, buf + len - carry, carry );
+        kept = carry;
+    }
+    close( fd );
+    return found;
+}
+
+/* The content is tested last, as it's by far the slowest */
+static gboolean match_file( VFSSearch* search, int dir_fd, const char* name,
+                            int open_flags, struct stat64* st, char** buf )
+{
+    if ( !match_stat( search, st ) )
+        return FALSE;
+    if ( !search->crit.text )
+        return TRUE;
+    if ( !S_ISREG( st->st_mode ) || st->st_size == 0 )
+        return FALSE;
+    if ( !*buf )
+        *buf = (char*)g_malloc( SEARCH_BUF_SIZE );
+    return match_text( search, dir_fd, name, open_flags, *buf );
+}
+
+/* Read the dir, reporting the matching entries.  Returns the jobs for its
+ * sub-dirs */
+static GSList* read_dir( SearchJob* job, guint* n_jobs )
+{
+    VFSSearch* search = job->search;
+    GSList* jobs = NULL;
+    DIR* dir;
+    struct dirent* ent;
+    struct stat64 st;
+    const char* name;
+    char* path;
+    char* buf = NULL;
+    gboolean is_dir, have_stat;
+    int fd;
+
+    fd = open( job->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if ( fd == -1 )
+        return NULL;
+    if ( !( dir = fdopendir( fd ) ) )
+    {
+        close( fd );
+        return NULL;
+    }
+
+    while ( !search->cancel && ( ent = readdir( dir ) ) )
+    {
+        name = ent->d_name;
+        if ( name[0] == '.' && ( !search->crit.hidden || name[1] == '\0' ||
+                                ( name[1] == '.' && name[2] == '\0' ) ) )
+            continue;
+
+        // only stat what the name or an unknown d_type calls for
+        have_stat = FALSE;
+        if ( ent->d_type == DT_UNKNOWN )
+        {
+            if ( fstatat64( fd, name, &st, AT_SYMLINK_NOFOLLOW ) == -1 )
+                continue;
+            have_stat = TRUE;
+            is_dir = S_ISDIR( st.st_mode );
+        }
+        else
+            is_dir = ent->d_type == DT_DIR;
+
+        path = NULL;
+        if ( is_dir && search->crit.recursive )
+        {
+            path = g_build_filename( job->path, name, NULL );
+            jobs = g_slist_prepend( jobs, new_job( search, g_strdup( path ) ) );
+            ( *n_jobs )++;
+        }
+
+        if ( match_name( search, name ) &&
+                ( have_stat ||
+                  fstatat64( fd, name, &st, AT_SYMLINK_NOFOLLOW ) == 0 ) &&
+                match_file( search, fd, name, O_NOFOLLOW, &st, &buf ) &&
+                !search->cancel )
+        {
+            if ( !path )
+                path = g_build_filename( job->path, name, NULL );
+            search->found_cb( search, path, &st, search->found_data );
+        }
+        g_free( path );
+    }
+    closedir( dir );
+    g_free( buf );
+    return jobs;
+}
+
+/* GThreadPool func */
+static void scan_dir( SearchJob* job, gpointer user_data )
+{
+    VFSSearch* search = job->search;
+    GSList* jobs = NULL;
+    guint n_jobs = 0;
+
+    if ( !search->cancel )
+        jobs = read_dir( job, &n_jobs );
+
+    // sub-dirs are pending before this job finishes
+    g_mutex_lock( search->mutex );
+    search->pending += n_jobs;
+    g_mutex_unlock( search->mutex );
+    if ( jobs )
+        push_jobs( jobs );
+
+    g_mutex_lock( search->mutex );
+    if ( --search->pending == 0 )
+        g_cond_broadcast( search->cond );
+    g_mutex_unlock( search->mutex );
+
+    free_job( job );
+}
+
+/* Translate a regex in grep's basic syntax, which the search used to run,
+ * to the Perl syntax of GRegex: \( \) \{ \} \| \+ \? are the operators and
+ * the bare chars are literal, * and ^ are literal where nothing precedes
+ * them, and a backslash is literal inside brackets */
+static char* bre_to_pcre( const char* bre )
+{
+    GString* re = g_string_sized_new( strlen( bre ) + 16 );
+    const char* p = bre;
+    int start = 2;  // 2: nothing before, 1: only a leading ^, 0: something
+
+    while ( *p )
+    {
+        if ( *p == '\\' && p[1] )
+        {
+            p++;
+            if ( strchr( "(){}|+?", *p ) )
+                g_string_append_c( re, *p );
+            else if ( *p == '<' || *p == '>' )
+                g_string_append( re, "\\b" );
+            else if ( *p == '`' )
+                g_string_append( re, "\\A" );
+            else if ( *p == '\'' )
+                g_string_append( re, "\\z" );
+            else if ( g_ascii_isdigit( *p ) || strchr( "wWsSbB", *p ) )
+                g_string_append_printf( re, "\\%c", *p );
+            else if ( g_ascii_isalpha( *p ) || (guchar)*p >= 0x80 )
+                // \n, \t... mean the letter itself to grep
+                g_string_append_c( re, *p );
+            else
+                g_string_append_printf( re, "\\%c", *p );
+            start = ( *p == '(' || *p == '|' ) ? 2 : 0;
+            p++;
+        }
+        else if ( *p == '\\' )
+        {
+            g_string_append( re, "\\\\" );
+            p++;
+            start = 0;
+        }
+        else if ( *p == '[' )
+        {
+            // a ] right after [ or [^ is a member, not the end
+            g_string_append_c( re, *p++ );
+            if ( *p == '^' )
+                g_string_append_c( re, *p++ );
+            if ( *p == ']' )
+                g_string_append_c( re, *p++ );
+            while ( *p && *p != ']' )
+            {
+                if ( *p == '[' && ( p[1] == ':' || p[1] == '=' || p[1] == '.' ) )
+                {
+                    // [:alpha:] and such are copied whole
+                    const char* end = strstr( p + 2, p[1] == ':' ? ":]" :
+                                                ( p[1] == '=' ? "=]" : ".]" ) );
+                    if ( end )
+                    {
+                        g_string_append_len( re, p, end + 2 - p );
+                        p = end + 2;
+                        continue;
+                    }
+                }
+                if ( *p == '\\' )
+                    g_string_append_c( re, '\\' );
+                g_string_append_c( re, *p++ );
+            }
+            if ( *p )
+                g_string_append_c( re, *p++ );
+            start = 0;
+        }
+        else if ( strchr( "(){}|+?", *p ) || ( *p == '*' && start ) )
+        {
+            g_string_append_printf( re, "\\%c", *p++ );
+            start = 0;
+        }
+        else if ( *p == '^' )
+        {
+            if ( start == 2 )
+                g_string_append_c( re, '^' );
+            else
+                g_string_append( re, "\\^" );
+            p++;
+            // a * after a leading ^ is still literal
+            start = start == 2 ? 1 : 0;
+        }
+        else if ( *p == '$' )
+        {
+            // an anchor only at the end of the regex or of a group or branch
+            if ( !p[1] || ( p[1] == '\\' && ( p[2] == ')' || p[2] == '|' ) ) )
+                g_string_append_c( re, '$' );
+            else
+                g_string_append( re, "\\$" );
+            p++;
+            start = 0;
+        }
+        else
+        {
+            g_string_append_c( re, *p++ );
+            start = 0;
+        }
+    }
+    return g_string_free( re, FALSE );
+}
+
+VFSSearch* vfs_search_new( const VFSSearchCriteria* crit,
+                           VFSSearchFoundCallback found_cb,
+                           gpointer user_data, GError** err )
+{
+    VFSSearch* search = g_slice_new0( VFSSearch );
+    GRegexCompileFlags flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+    char* pattern;
+
+    search->crit = *crit;
+    search->crit.dirs = g_strdupv( crit->dirs );
+    search->crit.name = crit->name && *crit->name ? g_strdup( crit->name ) : NULL;
+    search->crit.text = crit->text && *crit->text ? g_strdup( crit->text ) : NULL;
+    if ( !crit->name_case_sensitive )
+        search->name_flags = FNM_CASEFOLD;
+    search->found_cb = found_cb;
+    search->found_data = user_data;
+    search->mutex = g_mutex_new();
+    search->cond = g_cond_new();
+
+    // a plain text with case is left to memmem(), anything else is a regex
+    if ( search->crit.text )
+    {
+        search->text_len = strlen( search->crit.text );
+        // Any plain text match is overlapped between the pieces of a long
+        // line, with or without case.  Without case one char may match
+        // another of up to 4 bytes (k and the Kelvin sign).  A regex match
+        // has no bound, so those get none.  The cap keeps each piece
+        // making progress - long lines are at least half the buffer
+        if ( !crit->text_regexp )
+            search->carry = MIN( ( crit->text_case_sensitive ? 1 : 4 ) *
+                                 search->text_len - 1, SEARCH_BUF_SIZE / 4 );
+        if ( crit->text_regexp || !crit->text_case_sensitive )
+        {
+            if ( crit->text_regexp )
+                pattern = bre_to_pcre( search->crit.text );
+            else
+                pattern = g_regex_escape_string( search->crit.text, -1 );
+            if ( !crit->text_case_sensitive )
+                flags |= G_REGEX_CASELESS;
+            search->regex = g_regex_new( pattern, flags, 0, err );
+            if ( search->regex )
+                search->raw_regex = g_regex_new( pattern, flags | G_REGEX_RAW,
+                                                 0, err );
+            g_free( pattern );
+            if ( !search->raw_regex )
+            {
+                vfs_search_free( search );
+                return NULL;
+            }
+        }
+    }
+    return search;
+}
+
+void vfs_search_start( VFSSearch* search )
+{
+    GSList* jobs = NULL;
+    struct stat64 st;
+    char** dir;
+    char* name;
+    char* buf = NULL;
+
+    search->now = time( NULL );
+    for ( dir = search->crit.dirs; dir && *dir && !search->cancel; dir++ )
+    {
+        // the dirs themselves are followed if they're links, and are found
+        // if they match, whatever their names
+        if ( stat64( *dir, &st ) == -1 )
+            continue;
+        name = g_path_get_basename( *dir );
+        if ( match_name( search, name ) &&
+                        match_file( search, AT_FDCWD, *dir, 0, &st, &buf ) )
+            search->found_cb( search, *dir, &st, search->found_data );
+        g_free( name );
+
+        if ( S_ISDIR( st.st_mode ) )
+        {
+            jobs = g_slist_prepend( jobs, new_job( search, g_strdup( *dir ) ) );
+            g_mutex_lock( search->mutex );
+            search->pending++;
+            g_mutex_unlock( search->mutex );
+        }
+    }
+    g_free( buf );
+    if ( jobs )
+        push_jobs( g_slist_reverse( jobs ) );
+}
+
+gboolean vfs_search_wait( VFSSearch* search, int timeout_ms )
+{
+    GTimeVal end;
+    gboolean done;
+
+    g_get_current_time( &end );
+    g_time_val_add( &end, (glong)timeout_ms * 1000 );
+    g_mutex_lock( search->mutex );
+    while ( search->pending )
+    {
+        if ( timeout_ms < 0 )
+            g_cond_wait( search->cond, search->mutex );
+        else if ( !g_cond_timed_wait( search->cond, search->mutex, &end ) )
+            break;
+    }
+    done = search->pending == 0;
+    g_mutex_unlock( search->mutex );
+    return done;
+}
+
+void vfs_search_cancel( VFSSearch* search )
+{
+    search->cancel = TRUE;
+}
+
+void vfs_search_free( VFSSearch* search )
+{
+    vfs_search_cancel( search );
+    vfs_search_wait( search, -1 );
+    if ( search->regex )
+        g_regex_unref( search->regex );
+    if ( search->raw_regex )
+        g_regex_unref( search->raw_regex );
+    g_strfreev( search->crit.dirs );
+    g_free( search->crit.name );
+    g_free( search->crit.text );
+    g_mutex_free( search->mutex );
+    g_cond_free( search->cond );
+    g_slice_free( VFSSearch, search );
+}
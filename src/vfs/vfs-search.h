@@ -0,0 +1,69 @@
+/*
+*  C Interface: vfs-search
+*
+* Description: Parallel search of directory trees for files by name, size,
+*              date and content
+*
+*
+* Copyright: See COPYING file that comes with this distribution
+*
+*/
+
+#ifndef _VFS_SEARCH_H_
+#define _VFS_SEARCH_H_
+
+#include <glib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+G_BEGIN_DECLS
+
+typedef struct _VFSSearch VFSSearch;
+
+typedef struct
+{
+    char** dirs;                /* where to search, NULL terminated */
+    gboolean recursive;         /* FALSE: only the files directly in dirs */
+    gboolean hidden;            /* include and enter dot files */
+
+    char* name;                 /* glob for the base name, NULL for any */
+    gboolean name_case_sensitive;
+
+    off64_t size_lower;         /* size > size_lower bytes, -1 for any */
+    off64_t size_upper;         /* size <= size_upper bytes, -1 for any */
+
+    /* age of the mtime in whole days, like find -mtime: < max_days and
+     * > min_days, -1 for any */
+    int max_days;
+    int min_days;
+
+    char* text;                 /* only regular files with a line matching */
+    gboolean text_case_sensitive;
+    gboolean text_regexp;       /* text is a grep basic regex, not plain */
+} VFSSearchCriteria;
+
+/* Called in a worker thread for each file found.  st is its lstat - only
+ * dirs passed as VFSSearchCriteria.dirs are followed if they're links */
+typedef void ( *VFSSearchFoundCallback ) ( VFSSearch* search, const char* path,
+                                           struct stat64* st,
+                                           gpointer user_data );
+
+/* Returns NULL and sets err if the text regex is invalid.  crit is copied */
+VFSSearch* vfs_search_new( const VFSSearchCriteria* crit,
+                           VFSSearchFoundCallback found_cb,
+                           gpointer user_data, GError** err );
+
+void vfs_search_start( VFSSearch* search );
+
+/* Wait for the search to finish for up to timeout_ms (-1 waits as long as it
+ * takes).  Returns TRUE if the search is done */
+gboolean vfs_search_wait( VFSSearch* search, int timeout_ms );
+
+void vfs_search_cancel( VFSSearch* search );
+
+/* Cancels the search and waits for the workers to let go of search */
+void vfs_search_free( VFSSearch* search );
+
+G_END_DECLS
+
+#endif
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #ifdef HAVE_FFMPEG
 #include <libffmpegthumbnailer/videothumbnailerc.h>
 #endif
@@ -35,13 +36,20 @@
     #include "md5.h"    /* for thumbnails */
 #endif
 
+/* Requests of all dirs share one priority queue, served by a pool of
+ * workers sized to the cores.  Requests for the files a view has in sight go
+ * first, the rest in the order they were made. */
+#define THUMBNAIL_MAX_WORKERS 8
+#define THUMBNAIL_BATCH_INTERVAL 50    /* ms between thumbnail-loaded batches */
+
 struct _VFSThumbnailLoader
 {
     VFSDir* dir;
-    GQueue* queue;
-    VFSAsyncTask* task;
-    guint idle_handler;
-    GQueue* update_queue;
+    GHashTable* requests;   /* ThumbnailRequest.name => pending request */
+    GQueue* visible;        /* requests moved ahead by the last prioritize */
+    int n_loading;          /* requests taken by workers */
+    int n_results;          /* results waiting for the main loop */
+    gboolean cancel : 1;
 };
 
 enum
@@ -55,104 +63,204 @@ typedef struct _ThumbnailRequest
 {
     int n_requests[ N_LOAD_TYPES ];
     VFSFileInfo* file;
+    char* name;             /* key in loader->requests - file's name may
+                               be changed while the request is pending */
+    VFSThumbnailLoader* loader;
+    GSequenceIter* iter;    /* in queue */
+    GList* visible_link;    /* in loader->visible, or NULL */
+    guint serial;
 }
 ThumbnailRequest;
 
-static gpointer thumbnail_loader_thread( VFSAsyncTask* task, VFSThumbnailLoader* loader );
-/* static void on_load_finish( VFSAsyncTask* task, gboolean is_cancelled, VFSThumbnailLoader* loader ); */
-static void thumbnail_request_free( ThumbnailRequest* req );
-static gboolean on_thumbnail_idle( VFSThumbnailLoader* loader );
+typedef struct _ThumbnailResult
+{
+    VFSThumbnailLoader* loader;
+    VFSFileInfo* file;      /* NULL if the loader may be done */
+}
+ThumbnailResult;
+
+/* queue_mutex guards all of the below and the loaders' fields */
+static GMutex* queue_mutex = NULL;
+static GCond* loading_cond = NULL;  /* signalled when a worker drops a request */
+static GSequence* queue = NULL;     /* ThumbnailRequest* */
+static GThreadPool* pool = NULL;
+static int max_workers = 0;
+static int n_workers = 0;
+static guint next_serial = 0;
+static GQueue* results = NULL;      /* ThumbnailResult* */
+static guint results_timeout = 0;
+
+static void thumbnail_worker( gpointer data, gpointer user_data );
+static gboolean on_results_timeout( gpointer user_data );
+
+
+static void thumbnail_scheduler_init()
+{
+    long ncpu;
+
+    // only the main thread makes requests, so no race here
+    if ( G_LIKELY( queue_mutex ) )
+        return;
+    queue_mutex = g_mutex_new();
+    loading_cond = g_cond_new();
+    queue = g_sequence_new( NULL );
+    results = g_queue_new();
+    ncpu = sysconf( _SC_NPROCESSORS_ONLN );
+    max_workers = CLAMP( ncpu, 1, THUMBNAIL_MAX_WORKERS );
+    pool = g_thread_pool_new( thumbnail_worker, NULL, max_workers,
+                                                        FALSE, NULL );
+}
+
+static int compare_requests( gconstpointer a, gconstpointer b,
+                                                gpointer user_data )
+{
+    const ThumbnailRequest* ra = (const ThumbnailRequest*)a;
+    const ThumbnailRequest* rb = (const ThumbnailRequest*)b;
 
+    if ( !ra->visible_link != !rb->visible_link )
+        return ra->visible_link ? -1 : 1;
+    return ra->serial < rb->serial ? -1 : ( ra->serial > rb->serial ? 1 : 0 );
+}
 
 VFSThumbnailLoader* vfs_thumbnail_loader_new( VFSDir* dir )
 {
     VFSThumbnailLoader* loader = g_slice_new0( VFSThumbnailLoader );
-    loader->idle_handler = 0;
     loader->dir = g_object_ref( dir );
-    loader->queue = g_queue_new();
-    loader->update_queue = g_queue_new();
-    loader->task = vfs_async_task_new( (VFSAsyncFunc)thumbnail_loader_thread, loader );
-    /* g_signal_connect( loader->task, "finish", G_CALLBACK(on_load_finish), loader ); */
+    loader->requests = g_hash_table_new( g_str_hash, g_str_equal );
+    loader->visible = g_queue_new();
     return loader;
 }
 
-void vfs_thumbnail_loader_free( VFSThumbnailLoader* loader )
+static void thumbnail_request_free( ThumbnailRequest* req )
 {
-    if( loader->idle_handler )
-    {
-        g_source_remove( loader->idle_handler );
-        loader->idle_handler = 0;
-    }
+    vfs_file_info_unref( req->file );
+    g_free( req->name );
+    g_slice_free( ThumbnailRequest, req );
+    /* g_debug( "FREE REQUEST!" ); */
+}
 
-    /* g_signal_handlers_disconnect_by_func( loader->task, on_load_finish, loader ); */
-    /* stop the running thread, if any. */
-    vfs_async_task_cancel( loader->task );
+/* Take a pending request out of the queue.  Call with queue_mutex locked */
+static void remove_request( ThumbnailRequest* req )
+{
+    VFSThumbnailLoader* loader = req->loader;
 
-    if( loader->idle_handler )
+    g_sequence_remove( req->iter );
+    req->iter = NULL;
+    if ( req->visible_link )
     {
-        g_source_remove( loader->idle_handler );
-        loader->idle_handler = 0;
+        g_queue_delete_link( loader->visible, req->visible_link );
+        req->visible_link = NULL;
     }
+    g_hash_table_remove( loader->requests, req->name );
+}
+
+/* Call with queue_mutex locked */
+static void add_result( VFSThumbnailLoader* loader, VFSFileInfo* file )
+{
+    ThumbnailResult* res = g_slice_new( ThumbnailResult );
+    res->loader = loader;
+    res->file = file ? vfs_file_info_ref( file ) : NULL;
+    g_queue_push_tail( results, res );
+    loader->n_results++;
+    // one batch for all files loaded within the interval
+    if ( 0 == results_timeout )
+        results_timeout = g_timeout_add_full( G_PRIORITY_LOW,
+                                    THUMBNAIL_BATCH_INTERVAL,
+                                    on_results_timeout, NULL, NULL );
+}
 
-    g_object_unref( loader->task );
+void vfs_thumbnail_loader_free( VFSThumbnailLoader* loader )
+{
+    GHashTableIter it;
+    gpointer value;
+    GList* l;
 
-    if( loader->queue )
+    g_mutex_lock( queue_mutex );
+    loader->cancel = TRUE;
+    g_hash_table_iter_init( &it, loader->requests );
+    while ( g_hash_table_iter_next( &it, NULL, &value ) )
     {
-        g_queue_foreach( loader->queue, (GFunc) thumbnail_request_free, NULL );
-        g_queue_free( loader->queue );
+        ThumbnailRequest* req = (ThumbnailRequest*)value;
+        g_sequence_remove( req->iter );
+        thumbnail_request_free( req );
     }
-    if( loader->update_queue )
+    g_hash_table_destroy( loader->requests );
+    g_queue_free( loader->visible );
+
+    /* wait for the workers to let go of the loader - they only load a
+     * single file each */
+    while ( loader->n_loading )
+        g_cond_wait( loading_cond, queue_mutex );
+
+    for ( l = results->head; l && loader->n_results; )
     {
-        g_queue_foreach( loader->update_queue, (GFunc) vfs_file_info_unref, NULL );
-        g_queue_free( loader->update_queue );
+        ThumbnailResult* res = (ThumbnailResult*)l->data;
+        GList* next = l->next;
+        if ( res->loader == loader )
+        {
+            if ( res->file )
+                vfs_file_info_unref( res->file );
+            g_slice_free( ThumbnailResult, res );
+            g_queue_delete_link( results, l );
+            loader->n_results--;
+        }
+        l = next;
     }
+    g_mutex_unlock( queue_mutex );
     /* g_debug( "FREE THUMBNAIL LOADER" ); */
 
     /* prevent recursive unref called from vfs_dir_finalize */
     loader->dir->thumbnail_loader = NULL;
     g_object_unref( loader->dir );
+    g_slice_free( VFSThumbnailLoader, loader );
 }
 
-#if 0  /* This is not used in the program. For debug only */
-void on_load_finish( VFSAsyncTask* task, gboolean is_cancelled, VFSThumbnailLoader* loader )
-{
-    g_debug( "TASK FINISHED" );
-}
-#endif
-
-void thumbnail_request_free( ThumbnailRequest* req )
-{
-    vfs_file_info_unref( req->file );
-    g_slice_free( ThumbnailRequest, req );
-    /* g_debug( "FREE REQUEST!" ); */
-}
-
-gboolean on_thumbnail_idle( VFSThumbnailLoader* loader )
+static gboolean on_results_timeout( gpointer user_data )
 {
-    VFSFileInfo* file;
-
-    /* g_debug( "ENTER ON_THUMBNAIL_IDLE" ); */
-    vfs_async_task_lock( loader->task );
-
-    while( ( file = (VFSFileInfo*)g_queue_pop_head(loader->update_queue) )  )
+    ThumbnailResult* res;
+    VFSThumbnailLoader* loader;
+    VFSDir* dir;
+    gboolean done;
+
+    /* g_debug( "ENTER ON_RESULTS_TIMEOUT" ); */
+    g_mutex_lock( queue_mutex );
+    results_timeout = 0;
+    // a handler may free any loader, which drops its results, so only
+    // the popped result is used while unlocked
+    while( ( res = (ThumbnailResult*)g_queue_pop_head( results ) ) )
     {
+        loader = res->loader;
+        loader->n_results--;
+        done = 0 == loader->n_results && 0 == loader->n_loading &&
+                    0 == g_hash_table_size( loader->requests );
+        dir = g_object_ref( loader->dir );
+        g_mutex_unlock( queue_mutex );
+
         GDK_THREADS_ENTER();
-        vfs_dir_emit_thumbnail_loaded( loader->dir, file );
-        vfs_file_info_unref( file );
+        if ( res->file )
+        {
+            vfs_dir_emit_thumbnail_loaded( dir, res->file );
+            vfs_file_info_unref( res->file );
+        }
+        if ( done && dir->thumbnail_loader == loader )
+        {
+            /* g_debug( "FREE LOADER IN RESULTS HANDLER" ); */
+            g_mutex_lock( queue_mutex );
+            // a request may have come in from a handler
+            done = 0 == loader->n_results && 0 == loader->n_loading &&
+                        0 == g_hash_table_size( loader->requests );
+            g_mutex_unlock( queue_mutex );
+            if ( done )
+                vfs_thumbnail_loader_free( loader );
+        }
+        g_object_unref( dir );
         GDK_THREADS_LEAVE();
-    }
-
-    loader->idle_handler = 0;
-
-    vfs_async_task_unlock( loader->task );
+        g_slice_free( ThumbnailResult, res );
 
-    if( vfs_async_task_is_finished( loader->task ) )
-    {
-        /* g_debug( "FREE LOADER IN IDLE HANDLER" ); */
-        loader->dir->thumbnail_loader = NULL;
-        vfs_thumbnail_loader_free(loader);
+        g_mutex_lock( queue_mutex );
     }
-    /* g_debug( "LEAVE ON_THUMBNAIL_IDLE" ); */
+    g_mutex_unlock( queue_mutex );
+    /* g_debug( "LEAVE ON_RESULTS_TIMEOUT" ); */
 
     return FALSE;
 }
@@ -166,191 +274,401 @@ void on_video_thumbnailer_log_message(ThumbnailerLogLevel lvl, const char* msg)
 }
 #endif
 
-gpointer thumbnail_loader_thread( VFSAsyncTask* task, VFSThumbnailLoader* loader )
+/* Returns TRUE if the views need an update */
+static gboolean load_request( ThumbnailRequest* req )
 {
-    ThumbnailRequest* req;
     int i;
-    gboolean load_big, need_update;
+    gboolean load_big, need_update = FALSE;
+
+    /* Only we have the reference. That means, no body is using the file */
+    if( req->file->n_ref == 1 )
+        return FALSE;
 
-    while( G_LIKELY( ! vfs_async_task_is_cancelled(task) ))
+    for ( i = 0; i < 2; ++i )
     {
-        vfs_async_task_lock( task );
-        req = (ThumbnailRequest*)g_queue_pop_head( loader->queue );
-        vfs_async_task_unlock( task );
-        if( G_UNLIKELY( ! req ) )
-            break;
-        /* g_debug("pop: %s", req->file->name); */
+        if ( 0 == req->n_requests[ i ] )
+            continue;
 
-        /* Only we have the reference. That means, no body is using the file */
-        if( req->file->n_ref == 1 )
+        load_big = ( i == LOAD_BIG_THUMBNAIL );
+        if ( ! vfs_file_info_is_thumbnail_loaded( req->file, load_big ) )
         {
-            thumbnail_request_free( req );
-            continue;
+            char* full_path;
+            full_path = g_build_filename( req->loader->dir->path,
+                                          vfs_file_info_get_name( req->file ),
+                                          NULL );
+            vfs_file_info_load_thumbnail( req->file, full_path, load_big );
+            g_free( full_path );
+            /*  Slow donwn for debugging.
+            g_debug( "DELAY!!" );
+            g_usleep(G_USEC_PER_SEC/2);
+            */
+
+            /* g_debug( "thumbnail loaded: %s", req->file ); */
         }
+        need_update = TRUE;
+    }
+    return need_update;
+}
 
-        need_update = FALSE;
-        for ( i = 0; i < 2; ++i )
-        {
-            if ( 0 == req->n_requests[ i ] )
-                continue;
+/* GThreadPool func - loads requests until the queue is empty */
+static void thumbnail_worker( gpointer data, gpointer user_data )
+{
+    ThumbnailRequest* req;
+    VFSThumbnailLoader* loader;
+    GSequenceIter* first;
+    gboolean need_update;
 
-            load_big = ( i == LOAD_BIG_THUMBNAIL );
-            if ( ! vfs_file_info_is_thumbnail_loaded( req->file, load_big ) )
-            {
-                char* full_path;
-                full_path = g_build_filename( loader->dir->path,
-                                              vfs_file_info_get_name( req->file ),
-                                              NULL );
-                vfs_file_info_load_thumbnail( req->file, full_path, load_big );
-                g_free( full_path );
-                /*  Slow donwn for debugging.
-                g_debug( "DELAY!!" );
-                g_usleep(G_USEC_PER_SEC/2);
-                */
-
-                /* g_debug( "thumbnail loaded: %s", req->file ); */
-            }
-            need_update = TRUE;
-        }
+    g_mutex_lock( queue_mutex );
+    while( !g_sequence_iter_is_end( first = g_sequence_get_begin_iter( queue ) ) )
+    {
+        req = (ThumbnailRequest*)g_sequence_get( first );
+        loader = req->loader;
+        remove_request( req );
+        loader->n_loading++;
+        g_mutex_unlock( queue_mutex );
+        /* g_debug("pop: %s", req->file->name); */
+
+        need_update = load_request( req );
 
-        if( ! vfs_async_task_is_cancelled(task) && need_update )
+        g_mutex_lock( queue_mutex );
+        loader->n_loading--;
+        if( !loader->cancel )
         {
-            vfs_async_task_lock( task );
-            g_queue_push_tail( loader->update_queue, vfs_file_info_ref(req->file) );
-            if( 0 == loader->idle_handler)
-            {
-                loader->idle_handler = g_idle_add_full( G_PRIORITY_LOW, (GSourceFunc) on_thumbnail_idle, loader, NULL );
-            }
-            vfs_async_task_unlock( task );
+            if ( need_update )
+                add_result( loader, req->file );
+            else if ( 0 == loader->n_loading && 0 == loader->n_results &&
+                            0 == g_hash_table_size( loader->requests ) )
+                add_result( loader, NULL );  // let the main loop free it
         }
-        /* g_debug( "NEED_UPDATE: %d", need_update ); */
+        g_cond_broadcast( loading_cond );
         thumbnail_request_free( req );
     }
+    n_workers--;
+    g_mutex_unlock( queue_mutex );
+    /* g_debug("WORKER ENDED!");  */
+}
+
+/* Find or add the request for file.  Call with queue_mutex locked */
+static ThumbnailRequest* get_request( VFSDir* dir, VFSFileInfo* file,
+                                      gboolean* is_new )
+{
+    VFSThumbnailLoader* loader;
+    ThumbnailRequest* req;
 
-    if( vfs_async_task_is_cancelled(task) )
+    if( G_UNLIKELY( ! dir->thumbnail_loader ) )
+        dir->thumbnail_loader = vfs_thumbnail_loader_new( dir );
+    loader = dir->thumbnail_loader;
+
+    /* If file with the same name is already in our queue */
+    req = (ThumbnailRequest*)g_hash_table_lookup( loader->requests,
+                                                  file->name );
+    *is_new = !req;
+    if ( req )
     {
-        /* g_debug( "THREAD CANCELLED!!!" ); */
-        vfs_async_task_lock( task );
-        if( loader->idle_handler)
+        if ( req->file != file )
         {
-            g_source_remove( loader->idle_handler );
-            loader->idle_handler = 0;
+            // the file was replaced by one of the same name
+            vfs_file_info_unref( req->file );
+            req->file = vfs_file_info_ref( file );
         }
-        vfs_async_task_unlock( task );
+        return req;
     }
-    else
+
+    req = g_slice_new0( ThumbnailRequest );
+    req->file = vfs_file_info_ref( file );
+    req->name = g_strdup( file->name );
+    req->loader = loader;
+    req->serial = next_serial++;
+    g_hash_table_insert( loader->requests, req->name, req );
+    req->iter = g_sequence_insert_sorted( queue, req, compare_requests, NULL );
+    if ( n_workers < max_workers )
     {
-        if( 0 == loader->idle_handler)
-        {
-            /* g_debug( "ADD IDLE HANDLER BEFORE THREAD ENDING" ); */
-            /* FIXME: add2 This source always causes a "Source ID was not
-             * found" critical warning if removed in vfs_thumbnail_loader_free.
-             * Where is this being removed?  See comment in
-             * vfs_thumbnail_loader_cancel_all_requests. */
-            loader->idle_handler = g_idle_add_full( G_PRIORITY_LOW, (GSourceFunc) on_thumbnail_idle, loader, NULL );
-        }
+        n_workers++;
+        g_thread_pool_push( pool, GINT_TO_POINTER( 1 ), NULL );
     }
-    /* g_debug("THREAD ENDED!");  */
-    return NULL;
+    return req;
 }
 
 void vfs_thumbnail_loader_request( VFSDir* dir, VFSFileInfo* file, gboolean is_big )
 {
-    VFSThumbnailLoader* loader;
     ThumbnailRequest* req;
-    gboolean new_task = FALSE;
-    GList* l;
+    gboolean is_new;
 
     /* g_debug( "request thumbnail: %s, is_big: %d", file->name, is_big ); */
-    if( G_UNLIKELY( ! dir->thumbnail_loader ) )
-    {
-        dir->thumbnail_loader = vfs_thumbnail_loader_new( dir );
-        new_task = TRUE;
-    }
-
-    loader = dir->thumbnail_loader;
+    // the size of a file listed by name only isn't known, and its info is
+    // about to be replaced - it's requested again once that's done
+    if ( file->flags & VFS_FILE_INFO_PENDING )
+        return;
+    thumbnail_scheduler_init();
+    g_mutex_lock( queue_mutex );
+    req = get_request( dir, file, &is_new );
+    ++req->n_requests[ is_big ? LOAD_BIG_THUMBNAIL : LOAD_SMALL_THUMBNAIL ];
+    g_mutex_unlock( queue_mutex );
+}
 
-    if( G_UNLIKELY( ! loader->task ) )
-    {
-        loader->task = vfs_async_task_new( (VFSAsyncFunc)thumbnail_loader_thread, loader );
-        new_task = TRUE;
-    }
-    vfs_async_task_lock( loader->task );
+void vfs_thumbnail_loader_prioritize( VFSDir* dir, GList* files,
+                                                   gboolean is_big )
+{
+    VFSThumbnailLoader* loader;
+    ThumbnailRequest* req;
+    gboolean is_new;
+    GList* l;
 
-    /* Check if the request is already scheduled */
-    for( l = loader->queue->head; l; l = l->next )
+    thumbnail_scheduler_init();
+    g_mutex_lock( queue_mutex );
+    if( ( loader = dir->thumbnail_loader ) )
     {
-        req = (ThumbnailRequest*)l->data;
-        /* If file with the same name is already in our queue */
-        if( req->file == file || 0 == strcmp( req->file->name, file->name ) )
-            break;
-    }
-    if( l )
-    {
-        req = (ThumbnailRequest*)l->data;
+        // the files in sight before go back in line
+        while ( ( req = (ThumbnailRequest*)g_queue_peek_head( loader->visible ) ) )
+        {
+            g_queue_delete_link( loader->visible, req->visible_link );
+            req->visible_link = NULL;
+            g_sequence_sort_changed( req->iter, compare_requests, NULL );
+        }
     }
-    else
+    for ( l = files; l; l = l->next )
     {
-        req = g_slice_new0( ThumbnailRequest );
-        req->file = vfs_file_info_ref(file);
-        g_queue_push_tail( dir->thumbnail_loader->queue, req );
+        req = get_request( dir, (VFSFileInfo*)l->data, &is_new );
+        if ( is_new )
+            ++req->n_requests[ is_big ? LOAD_BIG_THUMBNAIL : LOAD_SMALL_THUMBNAIL ];
+        if ( !req->visible_link )
+        {
+            g_queue_push_tail( req->loader->visible, req );
+            req->visible_link = req->loader->visible->tail;
+            g_sequence_sort_changed( req->iter, compare_requests, NULL );
+        }
     }
+    g_mutex_unlock( queue_mutex );
+}
 
-    ++req->n_requests[ is_big ? LOAD_BIG_THUMBNAIL : LOAD_SMALL_THUMBNAIL ];
-
-    vfs_async_task_unlock( loader->task );
+void vfs_thumbnail_loader_cancel_request( VFSDir* dir, VFSFileInfo* file,
+                                                       gboolean is_big )
+{
+    VFSThumbnailLoader* loader;
+    ThumbnailRequest* req;
 
-    if( new_task )
-        vfs_async_task_execute( loader->task );
+    if( G_LIKELY( !( loader = dir->thumbnail_loader ) ) )
+        return;
+    g_mutex_lock( queue_mutex );
+    req = (ThumbnailRequest*)g_hash_table_lookup( loader->requests,
+                                                  file->name );
+    if ( req && req->file == file )
+    {
+        --req->n_requests[ is_big ? LOAD_BIG_THUMBNAIL : LOAD_SMALL_THUMBNAIL ];
+        if( req->n_requests[0]  <= 0 && req->n_requests[1] <= 0 )   /* nobody needs this */
+        {
+            remove_request( req );
+            thumbnail_request_free( req );
+            // other files' results may be on their way, so leave freeing
+            // the loader to the main loop
+            if ( 0 == loader->n_loading && 0 == loader->n_results &&
+                            0 == g_hash_table_size( loader->requests ) )
+                add_result( loader, NULL );
+        }
+    }
+    g_mutex_unlock( queue_mutex );
 }
 
 void vfs_thumbnail_loader_cancel_all_requests( VFSDir* dir, gboolean is_big )
 {
-    GList* l;
+    GHashTableIter it;
+    gpointer value;
     VFSThumbnailLoader* loader;
-    ThumbnailRequest* req;
 
     if( G_UNLIKELY( (loader=dir->thumbnail_loader) ) )
     {
-        vfs_async_task_lock( loader->task );
+        g_mutex_lock( queue_mutex );
         /* g_debug( "TRY TO CANCEL REQUESTS!!" ); */
-        for( l = loader->queue->head; l;  )
+        g_hash_table_iter_init( &it, loader->requests );
+        while ( g_hash_table_iter_next( &it, NULL, &value ) )
         {
-            req = (ThumbnailRequest*)l->data;
+            ThumbnailRequest* req = (ThumbnailRequest*)value;
             --req->n_requests[ is_big ? LOAD_BIG_THUMBNAIL : LOAD_SMALL_THUMBNAIL ];
-
             if( req->n_requests[0]  <= 0 && req->n_requests[1] <= 0 )   /* nobody needs this */
             {
-                GList* next = l->next;
-                g_queue_delete_link( loader->queue, l );
-                l = next;
+                // removing from the hash table must go through the iter
+                g_hash_table_iter_remove( &it );
+                g_sequence_remove( req->iter );
+                if ( req->visible_link )
+                    g_queue_delete_link( loader->visible, req->visible_link );
+                thumbnail_request_free( req );
             }
-            else
-                l = l->next;
         }
-
-        if( g_queue_get_length( loader->queue ) == 0 )
+        if( g_hash_table_size( loader->requests ) == 0 )
         {
             /* g_debug( "FREE LOADER IN vfs_thumbnail_loader_cancel_all_requests!" ); */
-            vfs_async_task_unlock( loader->task );
-            loader->dir->thumbnail_loader = NULL;
-            
-            /* FIXME: added idle_handler = 0 to prevent idle_handler being
-             * removed in vfs_thumbnail_loader_free - BUT causes a segfault
-             * in vfs_async_task_lock ??
-             * If source is removed here or in vfs_thumbnail_loader_free
-             * it causes a "GLib-CRITICAL **: Source ID N was not found when
-             * attempting to remove it" warning.  Such a source ID is always
-             * the one added in thumbnail_loader_thread at the "add2" comment. */
-            //loader->idle_handler = 0;
-            
+            g_mutex_unlock( queue_mutex );
             vfs_thumbnail_loader_free( loader );
             return;
         }
-        vfs_async_task_unlock( loader->task );
+        g_mutex_unlock( queue_mutex );
     }
 }
 
+/* The thumbnail dirs of the freedesktop spec, by the size they hold */
+static const struct
+{
+    int size;
+    const char* dir;
+} thumbnail_dirs[] =
+{
+    { 128, "normal" },
+    { 256, "large" },
+    { 512, "x-large" }
+};
+#define N_THUMBNAIL_DIRS G_N_ELEMENTS( thumbnail_dirs )
+#define THUMBNAIL_INDEX_MAX 65536
+
+/* Per thumbnail dir, "<md5>:<mtime>" of the thumbnails found fresh */
+static GHashTable* thumbnail_index[ N_THUMBNAIL_DIRS ] = { NULL };
+G_LOCK_DEFINE_STATIC( thumbnail_index );
+
+static char* thumbnail_index_key( const char* file_name, time_t mtime )
+{
+    return g_strdup_printf( "%.32s:%ld", file_name, (long)mtime );
+}
+
+static gboolean thumbnail_index_lookup( int dir, const char* file_name,
+                                                 time_t mtime )
+{
+    char* key = thumbnail_index_key( file_name, mtime );
+    gboolean found;
+
+    G_LOCK( thumbnail_index );
+    found = thumbnail_index[ dir ] &&
+                    g_hash_table_lookup( thumbnail_index[ dir ], key );
+    G_UNLOCK( thumbnail_index );
+    g_free( key );
+    return found;
+}
+
+static void thumbnail_index_insert( int dir, const char* file_name,
+                                             time_t mtime )
+{
+    char* key = thumbnail_index_key( file_name, mtime );
+
+    G_LOCK( thumbnail_index );
+    if ( !thumbnail_index[ dir ] )
+        thumbnail_index[ dir ] = g_hash_table_new_full( g_str_hash,
+                                            g_str_equal, g_free, NULL );
+    else if ( g_hash_table_size( thumbnail_index[ dir ] ) >= THUMBNAIL_INDEX_MAX )
+        g_hash_table_remove_all( thumbnail_index[ dir ] );
+    g_hash_table_replace( thumbnail_index[ dir ], key, key );
+    G_UNLOCK( thumbnail_index );
+}
+
+/* Read the size and Thumb::MTime of a PNG thumbnail from the chunks before
+ * its image data, without decoding it.  *thumb_mtime is NULL if the text
+ * isn't found there.  Returns FALSE if the file isn't a readable PNG. */
+static gboolean thumbnail_read_png_info( const char* path, int* width,
+                                         int* height, char** thumb_mtime )
+{
+    static const guchar signature[ 8 ] =
+                            { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+    static const char key[] = "Thumb::MTime";
+    guchar buf[ 256 ];
+    guint32 len;
+    FILE* file;
+    gboolean ret = FALSE;
+
+    *thumb_mtime = NULL;
+    if ( !( file = fopen( path, "rb" ) ) )
+        return FALSE;
+    if ( fread( buf, 1, 8, file ) != 8 || memcmp( buf, signature, 8 ) )
+        goto _out;
+
+    // chunks: length, type, data, crc - the length excludes type and crc
+    while ( fread( buf, 1, 8, file ) == 8 )
+    {
+        len = ( (guint32)buf[0] << 24 ) | ( buf[1] << 16 ) | ( buf[2] << 8 ) |
+                                                                    buf[3];
+        if ( !memcmp( buf + 4, "IHDR", 4 ) )
+        {
+            if ( len < 8 || fread( buf, 1, 8, file ) != 8 )
+                goto _out;
+            *width = ( buf[0] << 24 ) | ( buf[1] << 16 ) | ( buf[2] << 8 ) |
+                                                                    buf[3];
+            *height = ( buf[4] << 24 ) | ( buf[5] << 16 ) | ( buf[6] << 8 ) |
+                                                                    buf[7];
+            len -= 8;
+            ret = TRUE;
+        }
+        else if ( !memcmp( buf + 4, "tEXt", 4 ) && len < sizeof( buf ) &&
+                                                        !*thumb_mtime )
+        {
+            // keyword, nul, text
+            if ( fread( buf, 1, len, file ) != len )
+                goto _out;
+            if ( len > sizeof( key ) && !memcmp( buf, key, sizeof( key ) ) )
+                *thumb_mtime = g_strndup( (char*)buf + sizeof( key ),
+                                          len - sizeof( key ) );
+            len = 0;
+        }
+        else if ( !memcmp( buf + 4, "IDAT", 4 ) || !memcmp( buf + 4, "IEND", 4 ) )
+            break;
+        if ( !ret || fseek( file, (long)len + 4, SEEK_CUR ) == -1 )
+        {
+            // IHDR must come first
+            ret = FALSE;
+            break;
+        }
+    }
+_out:
+    fclose( file );
+    if ( !ret )
+    {
+        g_free( *thumb_mtime );
+        *thumb_mtime = NULL;
+    }
+    return ret;
+}
+
+/* Returns the thumbnail if it is at least size and made from the file as of
+ * mtime */
+static GdkPixbuf* thumbnail_load_fresh( const char* thumbnail_file, int dir,
+                                        const char* file_name, int size,
+                                        time_t mtime )
+{
+    GdkPixbuf* thumbnail;
+    char* thumb_mtime;
+    const char* opt;
+    int w, h;
+    gboolean fresh;
+
+    if ( thumbnail_index_lookup( dir, file_name, mtime ) )
+        return gdk_pixbuf_new_from_file( thumbnail_file, NULL );
+
+    // a stale thumbnail is found out without decoding it
+    if ( !thumbnail_read_png_info( thumbnail_file, &w, &h, &thumb_mtime ) ||
+                                                ( w < size && h < size ) )
+    {
+        g_free( thumb_mtime );
+        return NULL;
+    }
+    fresh = thumb_mtime && atol( thumb_mtime ) == mtime;
+    if ( thumb_mtime && !fresh )
+    {
+        g_free( thumb_mtime );
+        return NULL;
+    }
+    g_free( thumb_mtime );
+
+    thumbnail = gdk_pixbuf_new_from_file( thumbnail_file, NULL );
+    if ( thumbnail && !fresh )
+    {
+        // the text is after the image data - use what gdk-pixbuf read
+        opt = gdk_pixbuf_get_option( thumbnail, "tEXt::Thumb::MTime" );
+        if ( !opt || atol( opt ) != mtime )
+        {
+            g_object_unref( thumbnail );
+            return NULL;
+        }
+    }
+    if ( thumbnail )
+        thumbnail_index_insert( dir, file_name, mtime );
+    return thumbnail;
+}
+
 static GdkPixbuf* _vfs_thumbnail_load( const char* file_path, const char* uri,
                                                     int size, time_t mtime )
 {
@@ -363,18 +681,14 @@ static GdkPixbuf* _vfs_thumbnail_load( const char* file_path, const char* uri,
     char file_name[ 40 ];
     char* thumbnail_file;
     char mtime_str[ 32 ];
-    const char* thumb_mtime;
     int i, w, h;
     struct stat statbuf;
     GdkPixbuf* thumbnail, *result = NULL;
-    int create_size;
-    
-    if ( size > 256 )
-        create_size = 512;
-    else if ( size > 128 )
-        create_size = 256;
-    else
-        create_size = 128;
+    int create_size, dir;
+
+    for ( dir = 0; dir < N_THUMBNAIL_DIRS - 1 &&
+                            size > thumbnail_dirs[ dir ].size; ++dir );
+    create_size = thumbnail_dirs[ dir ].size;
     
     gboolean file_is_video = FALSE;
 #ifdef HAVE_FFMPEG
@@ -417,8 +731,8 @@ static GdkPixbuf* _vfs_thumbnail_load( const char* file_path, const char* uri,
 #endif
     strcpy( ( file_name + 32 ), ".png" );
 
-    thumbnail_file = g_build_filename( g_get_home_dir(),
-                                       ".thumbnails/normal",
+    thumbnail_file = g_build_filename( g_get_home_dir(), ".thumbnails",
+                                       thumbnail_dirs[ dir ].dir,
                                        file_name, NULL );
 
     if( G_UNLIKELY( 0 == mtime ) )
@@ -435,19 +749,10 @@ static GdkPixbuf* _vfs_thumbnail_load( const char* file_path, const char* uri,
         return NULL;
 
     /* load existing thumbnail */
-    thumbnail = gdk_pixbuf_new_from_file( thumbnail_file, NULL );
-    if ( thumbnail )
-    {
-        w = gdk_pixbuf_get_width( thumbnail );
-        h = gdk_pixbuf_get_height( thumbnail );
-    }
-    if ( !thumbnail || ( w < size && h < size ) ||
-                !( thumb_mtime = gdk_pixbuf_get_option( thumbnail,
-                                                "tEXt::Thumb::MTime" ) ) ||
-                atol( thumb_mtime ) != mtime )
+    thumbnail = thumbnail_load_fresh( thumbnail_file, dir, file_name, size,
+                                                                    mtime );
+    if ( !thumbnail )
     {
-        if( thumbnail )
-            g_object_unref( thumbnail );
         /* create new thumbnail */
         if ( file_is_video == FALSE )
         {
@@ -461,9 +766,10 @@ static GdkPixbuf* _vfs_thumbnail_load( const char* file_path, const char* uri,
                 thumbnail = gdk_pixbuf_apply_embedded_orientation( thumbnail );
                 g_object_unref( thumbnail_old );
                 sprintf( mtime_str, "%lu", mtime );
-                gdk_pixbuf_save( thumbnail, thumbnail_file, "png", NULL,
+                if ( gdk_pixbuf_save( thumbnail, thumbnail_file, "png", NULL,
                                  "tEXt::Thumb::URI", uri, "tEXt::Thumb::MTime",
-                                 mtime_str, NULL );
+                                 mtime_str, NULL ) )
+                    thumbnail_index_insert( dir, file_name, mtime );
                 chmod( thumbnail_file, 0600 );  /* only the owner can read it. */
             }
         }
@@ -547,12 +853,18 @@ GdkPixbuf* vfs_thumbnail_load_for_file( const char* file, int size, time_t mtime
 void vfs_thumbnail_init()
 {
     char* dir;
-    dir = g_build_filename( g_get_home_dir(), ".thumbnails/normal", NULL );
+    int i;
 
-    if( G_LIKELY( g_file_test( dir, G_FILE_TEST_IS_DIR ) ) )
-        chmod( dir, 0700 );
-    else
-        g_mkdir_with_parents( dir, 0700 );
+    for ( i = 0; i < N_THUMBNAIL_DIRS; ++i )
+    {
+        dir = g_build_filename( g_get_home_dir(), ".thumbnails",
+                                thumbnail_dirs[ i ].dir, NULL );
 
-    g_free( dir );
+        if( G_LIKELY( g_file_test( dir, G_FILE_TEST_IS_DIR ) ) )
+            chmod( dir, 0700 );
+        else
+            g_mkdir_with_parents( dir, 0700 );
+
+        g_free( dir );
+    }
 }
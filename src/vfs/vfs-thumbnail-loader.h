@@ -37,6 +37,14 @@ void vfs_thumbnail_loader_free( VFSThumbnailLoader* loader );
 
 void vfs_thumbnail_loader_request( VFSDir* dir, VFSFileInfo* file, gboolean is_big );
 void vfs_thumbnail_loader_cancel_all_requests( VFSDir* dir, gboolean is_big );
+void vfs_thumbnail_loader_cancel_request( VFSDir* dir, VFSFileInfo* file,
+                                                       gboolean is_big );
+
+/* Load the thumbnails of files, the files in sight of a view, before all
+ * other requests.  Files prioritized by the last call go back in line.
+ * Files without a request get one. */
+void vfs_thumbnail_loader_prioritize( VFSDir* dir, GList* files,
+                                                   gboolean is_big );
 
 /* Load thumbnail for the specified file
  *  If the caller knows mtime of the file, it should pass mtime to this function to